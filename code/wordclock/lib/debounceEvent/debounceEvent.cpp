@@ -25,10 +25,14 @@ DebounceEvent::DebounceEvent(uint8_t pin, callback_t callback, uint8_t defaultSt
 	
 	// store configuration
 	_pin = pin;
-	_status = _defaultStatus = defaultStatus;
+	_status = _reading = _defaultStatus = defaultStatus;
 	_delay = delay;
   _callback = callback;
 
+	// no press so far
+	_longPressed = true;
+	_changedAt = _pressedAt = _releasedAt = _repeatAt = 0;
+
 	// set up button
 	if (_defaultStatus == LOW) {
 		pinMode(_pin, INPUT);
@@ -39,30 +43,75 @@ DebounceEvent::DebounceEvent(uint8_t pin, callback_t callback, uint8_t defaultSt
 
 }
 
+void DebounceEvent::_event(uint8_t event) {
+  if (_callback) _callback(_pin, event);
+}
+
 bool DebounceEvent::loop() {
+  return loop(digitalRead(_pin), millis());
+}
+
+/**
+ * Runs the button with a reading taken elsewhere, like a pin change
+ * interrupt. Readings must come in time order
+ * @param  uint8_t reading        Pin level
+ * @param  unsigned long now      millis() when it was read
+ * @return bool                   True while pressed
+ */
+bool DebounceEvent::loop(uint8_t reading, unsigned long now) {
+
+  // replayed readings come far apart, the one that ends now may have
+  // been stable long enough to count
+  if (reading != _reading) loop(_reading, now);
+
+  // restart the debounce window every time the pin bounces
+  if (reading != _reading) {
+    _reading = reading;
+    _changedAt = now;
+  }
+
+  // accept the new status once it has been stable long enough
+  if ((_reading != _status) && (now - _changedAt >= _delay)) {
 
-  if (digitalRead(_pin) != _status) {
-    delay(_delay);
-    uint8_t newStatus = digitalRead(_pin);
-    if (newStatus != _status) {
+    _status = _reading;
 
-      	_status = newStatus;
+    // raise change event
+    _event(EVENT_CHANGED);
 
-      // raise events if callback defined
-      if (_callback) {
-    	 
-        // raise change event
-        _callback(_pin, EVENT_CHANGED);
+    if (_status == _defaultStatus) {
 
-      	if (_status == _defaultStatus) {
-      		// raise released event
-      		_callback(_pin, EVENT_RELEASED);
-      	} else {
-      		// raise pressed event
-      		_callback(_pin, EVENT_PRESSED);
-      	}
+      // raise released event
+      _event(EVENT_RELEASED);
+      _releasedAt = now;
 
+    } else {
+
+      // raise pressed event, and double click if the previous
+      // click was released shortly before
+      _event(EVENT_PRESSED);
+      if ((_releasedAt > 0) && (now - _releasedAt < DOUBLE_CLICK_DELAY)) {
+        _event(EVENT_DOUBLE_CLICK);
+        _releasedAt = 0;
       }
+      _pressedAt = now;
+      _repeatAt = now + REPEAT_DELAY;
+      _longPressed = false;
+
+    }
+
+  }
+
+  // while pressed raise long press once and repeat periodically
+  if (_status != _defaultStatus) {
+    if (!_longPressed && (now - _pressedAt >= LONG_PRESS_DELAY)) {
+      _longPressed = true;
+      _event(EVENT_LONG_PRESS);
+    }
+    if ((long) (now - _repeatAt) >= 0) {
+      _repeatAt += REPEAT_INTERVAL;
+      // after a stall repeat once and go on from now, not in a burst
+      if ((long) (now - _repeatAt) >= 0) _repeatAt = now + REPEAT_INTERVAL;
+      _event(EVENT_REPEAT);
     }
   }
 
@@ -22,9 +22,17 @@
 #define _DEBOUNCE_EVENT_h
 
 #define DEBOUNCE_DELAY 100
+#define LONG_PRESS_DELAY 1000
+#define DOUBLE_CLICK_DELAY 400
+#define REPEAT_DELAY 600
+#define REPEAT_INTERVAL 150
+
 #define EVENT_CHANGED 0
 #define EVENT_PRESSED 1
 #define EVENT_RELEASED 2
+#define EVENT_LONG_PRESS 3
+#define EVENT_DOUBLE_CLICK 4
+#define EVENT_REPEAT 5
 
 typedef void(*callback_t)(uint8_t pin, uint8_t event);
 
@@ -34,14 +42,23 @@ class DebounceEvent {
 
         uint8_t _pin;
         uint8_t _status;
+        uint8_t _reading;
         uint8_t _defaultStatus;
-        unsigned long _delay; 
+        bool _longPressed;
+        unsigned long _delay;
+        unsigned long _changedAt;
+        unsigned long _pressedAt;
+        unsigned long _releasedAt;
+        unsigned long _repeatAt;
         callback_t _callback;
-    
+
+        void _event(uint8_t event);
+
     public:
 
-        DebounceEvent(uint8_t pin, callback_t callback = false, uint8_t defaultStatus = HIGH, unsigned long delay = DEBOUNCE_DELAY);
+        DebounceEvent(uint8_t pin, callback_t callback = NULL, uint8_t defaultStatus = HIGH, unsigned long delay = DEBOUNCE_DELAY);
         bool loop();
+        bool loop(uint8_t reading, unsigned long now);
 
 };
 
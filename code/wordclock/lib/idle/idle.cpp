@@ -0,0 +1,153 @@
+/*
+
+  Sleep until the next event
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "idle.h"
+
+#ifdef __AVR__
+#include <avr/sleep.h>
+// Interrupts are enabled right before sleeping, the instruction after
+// sei always runs, so an event raised meanwhile wakes the CPU at once
+#define IDLE_SLEEP_CPU() { \
+  set_sleep_mode(SLEEP_MODE_IDLE); \
+  sleep_enable(); \
+  interrupts(); \
+  sleep_cpu(); \
+  sleep_disable(); \
+}
+#elif defined(ARDUINO_ARCH_NATIVE)
+// The host stand-in moves its clock on to the next interrupt
+#define IDLE_SLEEP_CPU() nativeSleep()
+#endif
+
+// Elsewhere wait for the next interrupt busy
+#ifndef IDLE_SLEEP_CPU
+#define IDLE_SLEEP_CPU() interrupts()
+#endif
+
+/**
+ * Adds microseconds to a millisecond counter, the remainder is kept
+ * for the next time. Divides only for intervals over a millisecond
+ */
+static void _count(unsigned long * ms, unsigned int * us, unsigned long elapsed) {
+  if (elapsed < 1000) {
+    *us += elapsed;
+    if (*us >= 1000) {
+      *us -= 1000;
+      (*ms)++;
+    }
+  } else {
+    elapsed += *us;
+    *ms += elapsed / 1000;
+    *us = elapsed % 1000;
+  }
+}
+
+Idle::Idle() {
+  _woken = 0;
+  reset();
+}
+
+/**
+ * Starts counting the time awake from now
+ */
+void Idle::begin() {
+  _since = micros();
+}
+
+/**
+ * Ends the current sleep, called from the interrupts of the events
+ * the loop has to handle
+ * @param  uint8_t reason         IDLE_WAKE_BUTTON or IDLE_WAKE_RTC
+ */
+void Idle::wake(uint8_t reason) {
+  _woken |= (1 << reason);
+}
+
+/**
+ * Sleeps for wait ms or until wake() is called. Every timer tick wakes
+ * the CPU for a moment, it goes back to sleep if there is nothing to do
+ * @param  unsigned long wait     Milliseconds, 0 returns at once
+ * @return uint8_t                Bit i set if reason i has woken it up
+ */
+uint8_t Idle::sleep(unsigned long wait) {
+
+  unsigned long start = micros();
+  _count(&_awake, &_awakeUs, start - _since);
+
+  unsigned long from = millis();
+  uint8_t woken;
+  while (true) {
+
+    // the checks and the sleep must be atomic or an event raised in
+    // between would be slept over
+    noInterrupts();
+    woken = _woken;
+    _woken = 0;
+    if ((woken > 0) || (millis() - from >= wait)) break;
+    IDLE_SLEEP_CPU();
+
+    // the interrupt that woke it has run already
+    if (_woken == 0) _wakes[IDLE_WAKE_TIMER]++;
+
+  }
+  interrupts();
+
+  for (uint8_t i=1; i<IDLE_WAKE_REASONS; i++) {
+    if (woken & (1 << i)) _wakes[i]++;
+  }
+
+  _since = micros();
+  _count(&_asleep, &_asleepUs, _since - start);
+  return woken;
+
+}
+
+/**
+ * Number of wakes for a reason
+ * @param  uint8_t reason         IDLE_WAKE_*
+ */
+unsigned long Idle::wakes(uint8_t reason) {
+  return reason < IDLE_WAKE_REASONS ? _wakes[reason] : 0;
+}
+
+/**
+ * Milliseconds spent in sleep()
+ */
+unsigned long Idle::asleep() {
+  return _asleep;
+}
+
+/**
+ * Milliseconds spent out of sleep()
+ */
+unsigned long Idle::awake() {
+  return _awake;
+}
+
+/**
+ * Clears the statistics
+ */
+void Idle::reset() {
+  for (uint8_t i=0; i<IDLE_WAKE_REASONS; i++) _wakes[i] = 0;
+  _asleep = _awake = 0;
+  _asleepUs = _awakeUs = 0;
+  _since = micros();
+}
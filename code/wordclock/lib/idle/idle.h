@@ -0,0 +1,61 @@
+/*
+
+  Sleep until the next event
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _IDLE_h
+#define _IDLE_h
+
+// Wake reasons, wake() takes the ones raised by interrupts
+#define IDLE_WAKE_TIMER 0       // millis() tick or any other interrupt
+#define IDLE_WAKE_BUTTON 1      // button pin change
+#define IDLE_WAKE_RTC 2         // RTC square wave
+#define IDLE_WAKE_REASONS 3
+
+/**
+ * Puts the CPU to sleep between the events of a cooperative loop.
+ * Idle mode stops the core only, so the millis() timer, the pin change
+ * and external interrupts and the serial port keep running and any of
+ * them wakes it up
+ */
+class Idle {
+
+  private:
+
+    volatile uint8_t _woken;    // reasons raised since the last sleep
+    unsigned long _wakes[IDLE_WAKE_REASONS];
+    unsigned long _asleep;      // milliseconds, wrap in 49 days
+    unsigned long _awake;
+    unsigned int _asleepUs;     // microseconds not counted yet
+    unsigned int _awakeUs;
+    unsigned long _since;
+
+  public:
+
+    Idle();
+    void begin();
+    void wake(uint8_t reason);
+    uint8_t sleep(unsigned long wait);
+    unsigned long wakes(uint8_t reason);
+    unsigned long asleep();
+    unsigned long awake();
+    void reset();
+
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+
+  Buffered serial log
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "logBuffer.h"
+
+/**
+ * @param  uint8_t * buffer       Ring buffer
+ * @param  uint16_t size          Ring buffer size, a power of two up to 256
+ * @param  HardwareSerial * port  Where the log goes
+ */
+LogBuffer::LogBuffer(uint8_t * buffer, uint16_t size, HardwareSerial * port) {
+  _buffer = buffer;
+  _mask = size - 1;
+  _head = _tail = 0;
+  _dropped = 0;
+  _cut = _marked = false;
+  _port = port;
+}
+
+void LogBuffer::_put(uint8_t c) {
+  _buffer[_head] = c;
+  _head = (_head + 1) & _mask;
+  _marked = false;
+}
+
+/**
+ * Bytes that can be queued, the room of the cut mark aside
+ */
+uint8_t LogBuffer::room() {
+  uint8_t free = (_tail - _head - 1) & _mask;
+  return free > LOG_BUFFER_CUT_SIZE ? free - LOG_BUFFER_CUT_SIZE : 0;
+}
+
+/**
+ * Queues a text byte. The first one that does not fit ends the line
+ * with the cut mark and the rest of the line is dropped. Lines dropped
+ * whole right after share that mark
+ */
+size_t LogBuffer::write(uint8_t c) {
+
+  if (!_cut && (room() > 0)) {
+    _put(c);
+    return 1;
+  }
+
+  if (!_cut && !_marked) {
+    const char * mark = LOG_BUFFER_CUT;
+    while (*mark) _put(*mark++);
+    _marked = true;
+  }
+  _cut = (c != '\n');
+  _dropped++;
+  return 0;
+
+}
+
+/**
+ * Queues text as write(uint8_t) does. A block starting with a byte
+ * over 0x7F is a binary frame, never cut: it goes whole or not at all
+ * and leaves a line being cut alone
+ */
+size_t LogBuffer::write(const uint8_t * buffer, size_t size) {
+
+  if ((size > 0) && (buffer[0] & 0x80)) {
+    if (size > room()) {
+      _dropped += size;
+      return 0;
+    }
+    for (size_t i=0; i<size; i++) _put(buffer[i]);
+    return size;
+  }
+
+  size_t n = 0;
+  for (size_t i=0; i<size; i++) n += write(buffer[i]);
+  return n;
+
+}
+
+/**
+ * Moves as many bytes as the port takes without blocking
+ * @return bool       True if there is still something queued
+ */
+bool LogBuffer::loop() {
+  int free = _port->availableForWrite();
+  while ((free-- > 0) && (_tail != _head)) {
+    _port->write(_buffer[_tail]);
+    _tail = (_tail + 1) & _mask;
+  }
+  return _tail != _head;
+}
+
+/**
+ * Sends everything queued, blocking. Use before writing to the port
+ * directly or halting
+ */
+void LogBuffer::flush() {
+  while (_tail != _head) {
+    _port->write(_buffer[_tail]);
+    _tail = (_tail + 1) & _mask;
+  }
+  _port->flush();
+}
+
+/**
+ * Bytes lost because the buffer was full
+ */
+unsigned long LogBuffer::dropped() {
+  return _dropped;
+}
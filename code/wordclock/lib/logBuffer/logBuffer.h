@@ -0,0 +1,72 @@
+/*
+
+  Buffered serial log
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _LOG_BUFFER_h
+#define _LOG_BUFFER_h
+
+// Log levels, compare LOG_LEVEL against them to compile messages out
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Ends a line cut short, its room is always kept free
+#define LOG_BUFFER_CUT "~\r\n"
+#define LOG_BUFFER_CUT_SIZE 3
+
+/**
+ * Queues everything printed into a ring buffer and moves it to the
+ * serial port only as fast as its transmit buffer empties, so printing
+ * never waits for the wire. Bytes that do not fit are dropped and
+ * counted: a text line that does not fit ends in LOG_BUFFER_CUT and
+ * the rest of it is dropped, a binary block goes whole or not at all.
+ * A frame written a byte at a time is text to it, so it must follow a
+ * whole line and fit in room(). Not for use from interrupts
+ */
+class LogBuffer : public Print {
+
+  private:
+
+    uint8_t * _buffer;
+    uint8_t _mask;              // size - 1
+    uint8_t _head;
+    uint8_t _tail;
+    unsigned long _dropped;
+    bool _cut;                  // dropping up to the end of the line
+    bool _marked;               // nothing queued since the last cut mark
+    HardwareSerial * _port;
+
+    void _put(uint8_t c);
+
+  public:
+
+    LogBuffer(uint8_t * buffer, uint16_t size, HardwareSerial * port);
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+    uint8_t room();
+    bool loop();
+    void flush();
+    unsigned long dropped();
+
+};
+
+#endif
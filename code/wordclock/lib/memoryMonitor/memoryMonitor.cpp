@@ -0,0 +1,119 @@
+/*
+
+  Stack and heap high water mark monitor
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "memoryMonitor.h"
+
+#ifdef __AVR__
+
+// Linker symbols
+extern "C" {
+  extern uint8_t __data_start;
+  extern uint8_t __bss_end;
+  extern uint8_t _end;
+  extern uint8_t __stack;
+  extern uint8_t __heap_start;
+  extern void * __brkval;
+}
+
+// Lowest free RAM seen so far
+unsigned int _memory_min_free = 0xFFFF;
+
+/**
+ * Paints everything between the end of static data and the top of the
+ * stack with the canary byte. Runs from .init3, right after the stack
+ * pointer is set and before any constructor allocates from the heap.
+ */
+extern "C" void memoryPaint(void) __attribute__ ((naked, used, section (".init3")));
+extern "C" void memoryPaint(void) {
+  uint8_t * p = &_end;
+  while (p <= &__stack) {
+    *p = MEMORY_CANARY;
+    p++;
+  }
+}
+
+/**
+ * Current top of the heap
+ */
+uint8_t * _memoryHeapTop() {
+  return (__brkval == 0) ? &__heap_start : (uint8_t *) __brkval;
+}
+
+/**
+ * Bytes used by .data and .bss
+ */
+unsigned int memoryStatic() {
+  return &__bss_end - &__data_start;
+}
+
+/**
+ * Bytes currently free between the heap and the stack
+ */
+unsigned int memoryFree() {
+  uint8_t v;
+  return &v - _memoryHeapTop();
+}
+
+/**
+ * Bytes above the heap never touched by the stack since boot
+ */
+unsigned int memoryMinFree() {
+  uint8_t * p = _memoryHeapTop();
+  uint8_t * top = &__stack;
+  unsigned int count = 0;
+  while ((p <= top) && (*p == MEMORY_CANARY)) {
+    p++;
+    count++;
+  }
+  if (count < _memory_min_free) _memory_min_free = count;
+  return _memory_min_free;
+}
+
+/**
+ * Checks the high water mark against a threshold
+ * @param  unsigned int threshold   Minimum free bytes
+ * @return bool                     True if the headroom is below threshold
+ */
+bool memoryLow(unsigned int threshold) {
+  return memoryMinFree() < threshold;
+}
+
+#else
+
+// Elsewhere there is no fixed RAM to watch, nothing is ever low
+
+unsigned int memoryStatic() {
+  return 0;
+}
+
+unsigned int memoryFree() {
+  return 0xFFFF;
+}
+
+unsigned int memoryMinFree() {
+  return 0xFFFF;
+}
+
+bool memoryLow(unsigned int threshold) {
+  return memoryMinFree() < threshold;
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+
+  Stack and heap high water mark monitor
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _MEMORY_MONITOR_h
+#define _MEMORY_MONITOR_h
+
+// Byte painted on the free RAM at boot
+#define MEMORY_CANARY 0xC5
+
+// Free bytes left below which the monitor warns
+#define MEMORY_WARNING 128
+
+unsigned int memoryStatic();
+unsigned int memoryFree();
+unsigned int memoryMinFree();
+bool memoryLow(unsigned int threshold = MEMORY_WARNING);
+
+#endif
@@ -0,0 +1,109 @@
+/*
+
+  Adafruit_NeoPixel stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <Arduino.h>
+#include "Adafruit_NeoPixel.h"
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, neoPixelType t) {
+  _count = n;
+  _pin = p;
+  _brightness = 0;
+  _pixels = (uint8_t *) calloc(n, 3);
+  _rOffset = (t >> 4) & 0b11;
+  _gOffset = (t >> 2) & 0b11;
+  _bOffset = t & 0b11;
+  _endTime = 0;
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+  free(_pixels);
+}
+
+void Adafruit_NeoPixel::begin() {
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+}
+
+void Adafruit_NeoPixel::setPin(uint8_t p) {
+  _pin = p;
+}
+
+void Adafruit_NeoPixel::show() {
+  while (!canShow());
+  noInterrupts();
+  for (uint16_t i=0; i<_count * 3; i++) nativeWire(_pixels[i]);
+  interrupts();
+  _endTime = micros();
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n >= _count) return;
+  if (_brightness) {
+    r = (r * _brightness) >> 8;
+    g = (g * _brightness) >> 8;
+    b = (b * _brightness) >> 8;
+  }
+  uint8_t * p = &_pixels[n * 3];
+  p[_rOffset] = r;
+  p[_gOffset] = g;
+  p[_bOffset] = b;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, (uint8_t) (c >> 16), (uint8_t) (c >> 8), (uint8_t) c);
+}
+
+// Rescales the buffer from the previous level, lossy as the original
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  uint8_t newBrightness = b + 1;
+  if (newBrightness == _brightness) return;
+  uint8_t oldBrightness = _brightness - 1;
+  uint16_t scale;
+  if (oldBrightness == 0) {
+    scale = 0;
+  } else if (b == 255) {
+    scale = 65535 / oldBrightness;
+  } else {
+    scale = (((uint16_t) newBrightness << 8) - 1) / oldBrightness;
+  }
+  for (uint16_t i=0; i<_count * 3; i++) _pixels[i] = (_pixels[i] * scale) >> 8;
+  _brightness = newBrightness;
+}
+
+void Adafruit_NeoPixel::clear() {
+  memset(_pixels, 0, _count * 3);
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+  if (n >= _count) return 0;
+  const uint8_t * p = &_pixels[n * 3];
+  if (_brightness) {
+    return (((uint32_t) (p[_rOffset] << 8) / _brightness) << 16)
+      | (((uint32_t) (p[_gOffset] << 8) / _brightness) << 8)
+      | ((uint32_t) (p[_bOffset] << 8) / _brightness);
+  }
+  return ((uint32_t) p[_rOffset] << 16) | ((uint32_t) p[_gOffset] << 8) | p[_bOffset];
+}
+
+// Gamma 2.6, as the table of the library
+uint8_t Adafruit_NeoPixel::gamma8(uint8_t x) {
+  return (uint8_t) (pow(x / 255.0, 2.6) * 255.0 + 0.5);
+}
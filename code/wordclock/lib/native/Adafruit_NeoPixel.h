@@ -0,0 +1,81 @@
+/*
+
+  Adafruit_NeoPixel stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef _ADAFRUIT_NEOPIXEL_NATIVE_h
+#define _ADAFRUIT_NEOPIXEL_NATIVE_h
+
+#include <Arduino.h>
+
+// Byte order as offsets of white, red, green and blue, 3 byte types only
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+typedef uint16_t neoPixelType;
+
+/**
+ * The buffer and scaling of Adafruit_NeoPixel, byte for byte, so the
+ * tests can compare against what the clock used to send. show() puts
+ * the buffer on the led data line of the stand-in core
+ */
+class Adafruit_NeoPixel {
+
+  private:
+
+    uint16_t _count;
+    uint8_t _pin;
+    uint8_t _brightness;
+    uint8_t * _pixels;
+    uint8_t _rOffset;
+    uint8_t _gOffset;
+    uint8_t _bOffset;
+    unsigned long _endTime;
+
+  public:
+
+    Adafruit_NeoPixel(uint16_t n, uint8_t p = 6, neoPixelType t = NEO_GRB + NEO_KHZ800);
+    ~Adafruit_NeoPixel();
+    void begin();
+    void show();
+    void setPin(uint8_t p);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    void setPixelColor(uint16_t n, uint32_t c);
+    void setBrightness(uint8_t b);
+    void clear();
+    uint8_t * getPixels() const { return _pixels; }
+    uint8_t getBrightness() const { return _brightness - 1; }
+    uint16_t numPixels() const { return _count; }
+    uint32_t getPixelColor(uint16_t n) const;
+    bool canShow() { return (micros() - _endTime) >= 300L; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+      return ((uint32_t) r << 16) | ((uint32_t) g << 8) | b;
+    }
+    static uint8_t gamma8(uint8_t x);
+
+};
+
+#endif
@@ -0,0 +1,582 @@
+/*
+
+  Arduino core stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+
+// Interrupt routines waiting for their time
+#define NATIVE_EVENTS 16
+#define NATIVE_TICK 1000
+
+struct native_event_t {
+  unsigned long long at;
+  void (*isr)();
+};
+
+static unsigned long long _now = 0;             // wall clock, us
+static unsigned long long _tick = NATIVE_TICK;  // next timer interrupt
+static unsigned long _millis = 0;             // timer ticks, as timer0_overflow_count
+static bool _enabled = true;
+
+// What millis() returns, as in wiring.c, so a sketch can give it back
+// the ticks lost with interrupts off
+volatile unsigned long timer0_millis = 0;
+static bool _tickPending = false;
+static native_event_t _events[NATIVE_EVENTS];
+static uint8_t _eventCount = 0;
+
+static void (*_external[2])() = { NULL, NULL };
+static int _externalMode[2] = { 0, 0 };
+
+static uint8_t _wire[NATIVE_WIRE];
+static size_t _wireCount = 0;
+
+volatile uint8_t native_ports[NATIVE_PINS];
+
+NativeTimer1 TCNT1;
+volatile uint8_t TCCR1A = 0;
+volatile uint8_t TCCR1B = 0;
+static unsigned long long _timer1From = 0;
+
+HardwareSerial Serial;
+
+// -----------------------------------------------------------------------------
+// Time
+// -----------------------------------------------------------------------------
+
+// Runs an interrupt routine with interrupts off, as the hardware does
+static void _run(void (*isr)()) {
+  _enabled = false;
+  isr();
+  _enabled = true;
+}
+
+// Runs the interrupts raised while they were off
+static void _pending() {
+  if (_tickPending) {
+    _tickPending = false;
+    _millis++;
+    timer0_millis++;
+  }
+  Serial.nativeAdvance(0);
+  uint8_t i = 0;
+  while (i < _eventCount) {
+    if (_events[i].at <= _now) {
+      void (*isr)() = _events[i].isr;
+      _events[i] = _events[--_eventCount];
+      _run(isr);
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+}
+
+// Earliest interrupt routine due, NATIVE_EVENTS if none
+static uint8_t _nextEvent() {
+  uint8_t next = NATIVE_EVENTS;
+  for (uint8_t i=0; i<_eventCount; i++) {
+    if ((next == NATIVE_EVENTS) || (_events[i].at < _events[next].at)) next = i;
+  }
+  return next;
+}
+
+static void _advance(unsigned long long us) {
+  unsigned long long end = _now + us;
+  while (true) {
+    uint8_t event = _nextEvent();
+    unsigned long long next = _tick;
+    if (_enabled && (event < NATIVE_EVENTS) && (_events[event].at < next)) next = _events[event].at;
+    if (next > end) break;
+    Serial.nativeAdvance((unsigned long) (next - _now));
+    _now = next;
+    if (next == _tick) {
+      _tick += NATIVE_TICK;
+      if (_enabled) {
+        _millis++;
+        timer0_millis++;
+      } else {
+        _tickPending = true;
+      }
+    } else {
+      void (*isr)() = _events[event].isr;
+      _events[event] = _events[--_eventCount];
+      _run(isr);
+    }
+  }
+  Serial.nativeAdvance((unsigned long) (end - _now));
+  _now = end;
+}
+
+unsigned long millis() {
+  return timer0_millis;
+}
+
+// Counts the timer ticks seen plus the time into the current one,
+// a busy loop on it moves the clock a microsecond per call
+unsigned long micros() {
+  _advance(1);
+  return _millis * NATIVE_TICK + (unsigned long) (NATIVE_TICK - (_tick - _now));
+}
+
+void delay(unsigned long ms) {
+  _advance((unsigned long long) ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  _advance(us);
+}
+
+void noInterrupts() {
+  _enabled = false;
+}
+
+void interrupts() {
+  if (_enabled) return;
+  _enabled = true;
+  _pending();
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode) {
+  if (interrupt > 1) return;
+  _external[interrupt] = isr;
+  _externalMode[interrupt] = mode;
+}
+
+void detachInterrupt(uint8_t interrupt) {
+  if (interrupt > 1) return;
+  _external[interrupt] = NULL;
+}
+
+NativeTimer1::operator uint16_t() const {
+  if (TCCR1B == 0) return 0;
+  return (uint16_t) ((_now - _timer1From) * (F_CPU / 8000000L));
+}
+
+NativeTimer1 & NativeTimer1::operator=(uint16_t value) {
+  _timer1From = _now - value / (F_CPU / 8000000L);
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+// Pins
+// -----------------------------------------------------------------------------
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NATIVE_PINS) return;
+  if (mode == INPUT_PULLUP) native_ports[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= NATIVE_PINS) return;
+  native_ports[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= NATIVE_PINS) return LOW;
+  return native_ports[pin] & 1;
+}
+
+// -----------------------------------------------------------------------------
+// Print
+// -----------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t * buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (write(*buffer++)) {
+      n++;
+    } else {
+      break;
+    }
+  }
+  return n;
+}
+
+// A character at a time, up to the first one not taken
+size_t Print::print(const __FlashStringHelper * str) {
+  const char * p = reinterpret_cast<const char *> (str);
+  size_t n = 0;
+  while (true) {
+    uint8_t c = pgm_read_byte(p++);
+    if (c == 0) break;
+    if (write(c)) {
+      n++;
+    } else {
+      break;
+    }
+  }
+  return n;
+}
+
+size_t Print::print(const char str[]) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t) c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long) n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 0) return write((uint8_t) n);
+  if ((base == 10) && (n < 0)) {
+    size_t t = print('-');
+    return printNumber(-n, 10) + t;
+  }
+  return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  if (base == 0) return write((uint8_t) n);
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  return printFloat(n, digits);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper * str) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(const char str[]) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(char c) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(unsigned char n, int base) {
+  size_t t = print(n, base);
+  return t + println();
+}
+
+size_t Print::println(int n, int base) {
+  size_t t = print(n, base);
+  return t + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+  size_t t = print(n, base);
+  return t + println();
+}
+
+size_t Print::println(long n, int base) {
+  size_t t = print(n, base);
+  return t + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+  size_t t = print(n, base);
+  return t + println();
+}
+
+size_t Print::println(double n, int digits) {
+  size_t t = print(n, digits);
+  return t + println();
+}
+
+// Digits into a buffer written in one go
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char * str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  if (base < 2) base = 10;
+  do {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+  size_t n = 0;
+  if (isnan(number)) return print("nan");
+  if (isinf(number)) return print("inf");
+  if (number < 0.0) {
+    n += print('-');
+    number = -number;
+  }
+  double rounding = 0.5;
+  for (uint8_t i=0; i<digits; i++) rounding /= 10.0;
+  number += rounding;
+  unsigned long integer = (unsigned long) number;
+  double remainder = number - (double) integer;
+  n += print(integer);
+  if (digits > 0) n += print('.');
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    unsigned int digit = (unsigned int) remainder;
+    n += print(digit);
+    remainder -= digit;
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+// Serial
+// -----------------------------------------------------------------------------
+
+HardwareSerial::HardwareSerial() {
+  _baud = 0;
+  nativeReset();
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  _baud = baud;
+}
+
+void HardwareSerial::end() {
+  flush();
+  _baud = 0;
+}
+
+int HardwareSerial::available() {
+  return _rxCount;
+}
+
+int HardwareSerial::peek() {
+  return _rxCount > 0 ? _rx[_rxHead] : -1;
+}
+
+int HardwareSerial::read() {
+  if (_rxCount == 0) return -1;
+  uint8_t c = _rx[_rxHead];
+  _rxHead = (_rxHead + 1) % NATIVE_SERIAL_RX;
+  _rxCount--;
+  return c;
+}
+
+int HardwareSerial::availableForWrite() {
+  return NATIVE_SERIAL_TX - 1 - _txCount;
+}
+
+// Waits for the transmit buffer to empty
+void HardwareSerial::flush() {
+  while (_txCount > 0) _advance(10000000UL / _baud);
+}
+
+// Waits for room if the transmit buffer is full, as the ATmega does
+size_t HardwareSerial::write(uint8_t c) {
+  if (_baud == 0) return 0;
+  while (availableForWrite() == 0) _advance(10000000UL / _baud);
+  _tx[(_txHead + _txCount) % NATIVE_SERIAL_TX] = c;
+  _txCount++;
+  return 1;
+}
+
+/**
+ * Sends bytes to the port, they arrive as the clock moves
+ * @param  unsigned long after    Microseconds before the first starts if
+ *                                the line is idle, the sketch may be busy
+ *                                by then
+ * @return size_t                 Bytes taken by the wire
+ */
+size_t HardwareSerial::nativeSend(const uint8_t * buffer, size_t size, unsigned long after) {
+  if (_lineCount == 0) _rxWait = after;
+  size_t n = 0;
+  while ((n < size) && (_lineCount < NATIVE_SERIAL_SENT)) _line[_lineCount++] = buffer[n++];
+  return n;
+}
+
+/**
+ * Takes the bytes the port has put on the wire
+ * @return size_t             Bytes copied
+ */
+size_t HardwareSerial::nativeReceive(uint8_t * buffer, size_t size) {
+  size_t n = size < _sentCount ? size : _sentCount;
+  memcpy(buffer, _sent, n);
+  memmove(_sent, &_sent[n], _sentCount - n);
+  _sentCount -= n;
+  return n;
+}
+
+// A byte in off the wire, lost if the FIFO is full
+void HardwareSerial::_receive(uint8_t c) {
+  if (_fifoCount < NATIVE_SERIAL_FIFO) {
+    _fifo[_fifoCount++] = c;
+  } else {
+    _overruns++;
+  }
+  if (_enabled) _take();
+}
+
+// The receive interrupt, drops what the receive buffer has no room
+// for as the core does
+void HardwareSerial::_take() {
+  for (uint8_t i=0; i<_fifoCount; i++) {
+    if (_rxCount == NATIVE_SERIAL_RX) break;
+    _rx[(_rxHead + _rxCount) % NATIVE_SERIAL_RX] = _fifo[i];
+    _rxCount++;
+  }
+  _fifoCount = 0;
+}
+
+// Ten bits per byte at the baud rate, both ways
+void HardwareSerial::nativeAdvance(unsigned long us) {
+
+  if (_baud == 0) {
+    _progress = _rxProgress = 0;
+    return;
+  }
+  unsigned long period = 10000000UL / _baud;
+
+  if (_txCount == 0) {
+    _progress = 0;
+  } else {
+    _progress += us;
+    while ((_progress >= period) && (_txCount > 0)) {
+      _progress -= period;
+      if (_sentCount < NATIVE_SERIAL_SENT) _sent[_sentCount++] = _tx[_txHead];
+      _txHead = (_txHead + 1) % NATIVE_SERIAL_TX;
+      _txCount--;
+    }
+  }
+
+  if (_enabled) _take();
+  if (_lineCount == 0) {
+    _rxProgress = 0;
+    return;
+  }
+  if (_rxWait >= us) {
+    _rxWait -= us;
+    return;
+  }
+  _rxProgress += us - _rxWait;
+  _rxWait = 0;
+  uint16_t n = 0;
+  while ((_rxProgress >= period) && (n < _lineCount)) {
+    _rxProgress -= period;
+    _receive(_line[n++]);
+  }
+  memmove(_line, &_line[n], _lineCount - n);
+  _lineCount -= n;
+
+}
+
+/**
+ * Bytes lost to a full USART FIFO since the reset
+ */
+unsigned long HardwareSerial::nativeOverruns() {
+  return _overruns;
+}
+
+void HardwareSerial::nativeReset() {
+  _progress = _rxProgress = _rxWait = 0;
+  _rxHead = _rxCount = 0;
+  _txHead = _txCount = 0;
+  _sentCount = 0;
+  _lineCount = 0;
+  _fifoCount = 0;
+  _overruns = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Host controls
+// -----------------------------------------------------------------------------
+
+void nativeReset() {
+  _now = 0;
+  _tick = NATIVE_TICK;
+  _millis = 0;
+  timer0_millis = 0;
+  _enabled = true;
+  _tickPending = false;
+  _eventCount = 0;
+  _wireCount = 0;
+  _timer1From = 0;
+  Serial.nativeReset();
+}
+
+unsigned long long nativeNow() {
+  return _now;
+}
+
+void nativeAdvance(unsigned long us) {
+  _advance(us);
+}
+
+void nativeBusy(unsigned long us) {
+  bool enabled = _enabled;
+  _enabled = false;
+  _advance(us);
+  if (enabled) interrupts();
+}
+
+void nativeSleep() {
+  interrupts();
+  uint8_t event = _nextEvent();
+  unsigned long long next = _tick;
+  if ((event < NATIVE_EVENTS) && (_events[event].at < next)) next = _events[event].at;
+  _advance(next - _now);
+}
+
+void nativeInterrupt(unsigned long us, void (*isr)()) {
+  if (_eventCount == NATIVE_EVENTS) return;
+  _events[_eventCount].at = _now + us;
+  _events[_eventCount].isr = isr;
+  _eventCount++;
+}
+
+// Pins 2 and 3 raise the external interrupts attached to them
+void nativeSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= NATIVE_PINS) return;
+  uint8_t previous = native_ports[pin] & 1;
+  native_ports[pin] = level ? HIGH : LOW;
+  int interrupt = digitalPinToInterrupt(pin);
+  if ((interrupt < 0) || (_external[interrupt] == NULL) || (previous == (level ? HIGH : LOW))) return;
+  int mode = _externalMode[interrupt];
+  if ((mode == CHANGE) || ((mode == RISING) && level) || ((mode == FALLING) && !level)) {
+    nativeInterrupt(0, _external[interrupt]);
+    if (_enabled) _pending();
+  }
+}
+
+void nativeWire(uint8_t value) {
+  if (_wireCount < NATIVE_WIRE) _wire[_wireCount++] = value;
+  _advance(10);
+}
+
+size_t nativeWireRead(uint8_t * buffer, size_t size) {
+  size_t n = size < _wireCount ? size : _wireCount;
+  memcpy(buffer, _wire, n);
+  _wireCount = 0;
+  return n;
+}
@@ -0,0 +1,262 @@
+/*
+
+  Arduino core stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _ARDUINO_NATIVE_h
+#define _ARDUINO_NATIVE_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Libraries with host specific code test for it
+#define ARDUINO_ARCH_NATIVE
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define _BV(bit) (1 << (bit))
+
+// Flash is plain memory
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char *
+#define memcpy_P memcpy
+static inline uint8_t pgm_read_byte(const void * addr) { return *(const uint8_t *) addr; }
+static inline uint16_t pgm_read_word(const void * addr) { uint16_t v; memcpy(&v, addr, 2); return v; }
+static inline uint32_t pgm_read_dword(const void * addr) { uint32_t v; memcpy(&v, addr, 4); return v; }
+static inline void * pgm_read_ptr(const void * addr) { void * v; memcpy(&v, addr, sizeof(v)); return v; }
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *> (PSTR(s)))
+
+// -----------------------------------------------------------------------------
+// Time
+// -----------------------------------------------------------------------------
+// The clock only moves when the code waits on it or a test moves it.
+// millis() counts the ticks of a 1ms timer interrupt, ticks raised
+// while interrupts are off are lost but one, as on the ATmega
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void noInterrupts();
+void interrupts();
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+// Timer1 free running at F_CPU/8 once TCCR1B is set, as the profiler uses it
+struct NativeTimer1 {
+  operator uint16_t() const;
+  NativeTimer1 & operator=(uint16_t value);
+};
+extern NativeTimer1 TCNT1;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+#define CS10 0
+#define CS11 1
+#define CS12 2
+
+// -----------------------------------------------------------------------------
+// Pins
+// -----------------------------------------------------------------------------
+// Every pin is a port of its own with the level in bit 0, inputs with
+// the pull-up read HIGH until a test drives them
+
+#define NATIVE_PINS 20
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+extern volatile uint8_t native_ports[NATIVE_PINS];
+#define digitalPinToPort(p) (p)
+#define digitalPinToBitMask(p) (1)
+#define portInputRegister(port) (&native_ports[port])
+#define portOutputRegister(port) (&native_ports[port])
+
+// -----------------------------------------------------------------------------
+// Print and Serial
+// -----------------------------------------------------------------------------
+
+class Print {
+
+  private:
+
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double number, uint8_t digits);
+
+  public:
+
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t * buffer, size_t size);
+    size_t write(const char * str) { return str ? write((const uint8_t *) str, strlen(str)) : 0; }
+    size_t write(const char * buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper * str);
+    size_t print(const char str[]);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println();
+    size_t println(const __FlashStringHelper * str);
+    size_t println(const char str[]);
+    size_t println(char c);
+    size_t println(unsigned char n, int base = DEC);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned int n, int base = DEC);
+    size_t println(long n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+    size_t println(double n, int digits = 2);
+
+};
+
+// Buffers as the ATmega ones
+#define NATIVE_SERIAL_RX 64
+#define NATIVE_SERIAL_TX 64
+#define NATIVE_SERIAL_FIFO 2
+#define NATIVE_SERIAL_SENT 4096
+
+/**
+ * Serial port with its wire on the host side: bytes written leave the
+ * transmit buffer at the baud rate as the clock moves, bytes sent to
+ * the port arrive at the baud rate too. The receive interrupt moves
+ * them from the USART FIFO to the receive buffer, while interrupts are
+ * off the FIFO fills and the bytes after it are lost, as the ATmega
+ * overruns
+ */
+class HardwareSerial : public Print {
+
+  private:
+
+    unsigned long _baud;
+    unsigned long _progress;    // microseconds toward the next byte out
+    uint8_t _rx[NATIVE_SERIAL_RX];
+    uint16_t _rxHead;
+    uint16_t _rxCount;
+    uint8_t _tx[NATIVE_SERIAL_TX];
+    uint16_t _txHead;
+    uint16_t _txCount;
+    uint8_t _sent[NATIVE_SERIAL_SENT];
+    uint16_t _sentCount;
+    unsigned long _rxProgress;  // microseconds toward the next byte in
+    unsigned long _rxWait;      // microseconds before the line starts
+    uint8_t _line[NATIVE_SERIAL_SENT];
+    uint16_t _lineCount;
+    uint8_t _fifo[NATIVE_SERIAL_FIFO];
+    uint8_t _fifoCount;
+    unsigned long _overruns;
+
+    void _receive(uint8_t c);
+    void _take();
+
+  public:
+
+    HardwareSerial();
+    void begin(unsigned long baud);
+    void end();
+    int available();
+    int peek();
+    int read();
+    virtual int availableForWrite();
+    virtual void flush();
+    virtual size_t write(uint8_t c);
+    using Print::write;
+    operator bool() { return true; }
+
+    // host side of the wire
+    size_t nativeSend(const uint8_t * buffer, size_t size, unsigned long after = 0);
+    size_t nativeReceive(uint8_t * buffer, size_t size);
+    void nativeAdvance(unsigned long us);
+    unsigned long nativeOverruns();
+    void nativeReset();
+
+};
+
+extern HardwareSerial Serial;
+
+// -----------------------------------------------------------------------------
+// Host controls, for the tests
+// -----------------------------------------------------------------------------
+
+// Back to time 0 with interrupts on, no interrupt pending and the serial
+// port and led data line empty. Pin levels are kept
+void nativeReset();
+
+// Microseconds since nativeReset(), as a clock on the wall would tell
+unsigned long long nativeNow();
+
+// Moves the clock, running the interrupts due on the way
+void nativeAdvance(unsigned long us);
+
+// Moves the clock while interrupts are off, as a long blocking section would
+void nativeBusy(unsigned long us);
+
+// Enables interrupts and waits for the next one, the CPU sleep
+void nativeSleep();
+
+// Runs an interrupt routine us microseconds from now
+void nativeInterrupt(unsigned long us, void (*isr)());
+
+// Sets the level of an input pin
+void nativeSetPin(uint8_t pin, uint8_t level);
+
+// Led data line: a byte sent takes 10us at 800kHz, the ones sent since
+// the last nativeWireRead() are kept up to NATIVE_WIRE
+#define NATIVE_WIRE 2048
+void nativeWire(uint8_t value);
+size_t nativeWireRead(uint8_t * buffer, size_t size);
+
+#endif
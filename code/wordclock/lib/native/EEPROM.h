@@ -0,0 +1,66 @@
+/*
+
+  EEPROM stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef _EEPROM_NATIVE_h
+#define _EEPROM_NATIVE_h
+
+#include <Arduino.h>
+
+// As the ATmega328P, erased to 0xFF
+#define NATIVE_EEPROM 1024
+
+class EEPROMClass {
+
+  private:
+
+    uint8_t _data[NATIVE_EEPROM];
+    unsigned long _writes;
+
+  public:
+
+    EEPROMClass() {
+      memset(_data, 0xFF, NATIVE_EEPROM);
+      _writes = 0;
+    }
+    uint8_t read(int address) { return _data[address % NATIVE_EEPROM]; }
+    void write(int address, uint8_t value) {
+      _data[address % NATIVE_EEPROM] = value;
+      _writes++;
+    }
+    void update(int address, uint8_t value) {
+      if (read(address) != value) write(address, value);
+    }
+    uint16_t length() { return NATIVE_EEPROM; }
+
+    // cells actually written, updates with the same value do not count
+    unsigned long nativeWrites() { return _writes; }
+
+    // a blank chip
+    void nativeErase() {
+      memset(_data, 0xFF, NATIVE_EEPROM);
+      _writes = 0;
+    }
+
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,138 @@
+/*
+
+  RTClib stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <Arduino.h>
+#include "RTClib.h"
+
+static const uint8_t _daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+// Days since 2000-01-01
+static uint16_t _days(uint16_t y, uint8_t m, uint8_t d) {
+  if (y >= 2000) y -= 2000;
+  uint16_t days = d;
+  for (uint8_t i=1; i<m; i++) days += _daysInMonth[i - 1];
+  if ((m > 2) && (y % 4 == 0)) days++;
+  return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+static uint8_t _number(const char * p) {
+  uint8_t v = 0;
+  if (('0' <= *p) && (*p <= '9')) v = *p - '0';
+  return 10 * v + *++p - '0';
+}
+
+DateTime::DateTime(uint32_t t) {
+  t -= SECONDS_FROM_1970_TO_2000;
+  ss = t % 60;
+  t /= 60;
+  mm = t % 60;
+  t /= 60;
+  hh = t % 24;
+  uint16_t days = t / 24;
+  uint8_t leap;
+  for (yOff = 0; ; yOff++) {
+    leap = (yOff % 4 == 0);
+    if (days < 365 + leap) break;
+    days -= 365 + leap;
+  }
+  for (m = 1; m < 12; m++) {
+    uint8_t length = _daysInMonth[m - 1];
+    if (leap && (m == 2)) length++;
+    if (days < length) break;
+    days -= length;
+  }
+  d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec) {
+  if (year >= 2000) year -= 2000;
+  yOff = year;
+  m = month;
+  d = day;
+  hh = hour;
+  mm = min;
+  ss = sec;
+}
+
+// As __DATE__ and __TIME__, "Oct 18 2015" and "12:34:56"
+DateTime::DateTime(const char * date, const char * time) {
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  yOff = _number(date + 9);
+  m = 1;
+  for (uint8_t i=0; i<12; i++) {
+    if (strncmp(date, &months[i * 3], 3) == 0) m = i + 1;
+  }
+  d = _number(date + 4);
+  hh = _number(time);
+  mm = _number(time + 3);
+  ss = _number(time + 6);
+}
+
+DateTime::DateTime(const __FlashStringHelper * date, const __FlashStringHelper * time) {
+  *this = DateTime(reinterpret_cast<const char *> (date), reinterpret_cast<const char *> (time));
+}
+
+// 2000-01-01 was a Saturday
+uint8_t DateTime::dayOfTheWeek() const {
+  return (_days(yOff, m, d) + 6) % 7;
+}
+
+uint32_t DateTime::secondstime() const {
+  return ((_days(yOff, m, d) * 24UL + hh) * 60 + mm) * 60 + ss;
+}
+
+uint32_t DateTime::unixtime() const {
+  return secondstime() + SECONDS_FROM_1970_TO_2000;
+}
+
+RTC_DS1307::RTC_DS1307() {
+  _running = false;
+  _time = SECONDS_FROM_1970_TO_2000;
+  _setAt = 0;
+  _sqw = OFF;
+}
+
+bool RTC_DS1307::begin() {
+  return true;
+}
+
+void RTC_DS1307::adjust(const DateTime & dt) {
+  _time = dt.unixtime();
+  _setAt = nativeNow();
+  _running = true;
+}
+
+uint8_t RTC_DS1307::isrunning() {
+  return _running;
+}
+
+DateTime RTC_DS1307::now() {
+  if (!_running) return DateTime(_time);
+  return DateTime(_time + (uint32_t) ((nativeNow() - _setAt) / 1000000));
+}
+
+Ds1307SqwPinMode RTC_DS1307::readSqwPinMode() {
+  return _sqw;
+}
+
+void RTC_DS1307::writeSqwPinMode(Ds1307SqwPinMode mode) {
+  _sqw = mode;
+}
@@ -0,0 +1,91 @@
+/*
+
+  RTClib stand-in for the native environment
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef _RTCLIB_NATIVE_h
+#define _RTCLIB_NATIVE_h
+
+#include <Arduino.h>
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+/**
+ * Date and time from 2000 to 2099, as the RTClib one
+ */
+class DateTime {
+
+  protected:
+
+    uint8_t yOff, m, d, hh, mm, ss;
+
+  public:
+
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    DateTime(const char * date, const char * time);
+    DateTime(const __FlashStringHelper * date, const __FlashStringHelper * time);
+    uint16_t year() const { return 2000 + yOff; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+    uint8_t dayOfTheWeek() const;
+    uint32_t secondstime() const;
+    uint32_t unixtime() const;
+
+};
+
+enum Ds1307SqwPinMode {
+  OFF = 0x00,
+  ON = 0x80,
+  SquareWave1HZ = 0x10,
+  SquareWave4kHz = 0x11,
+  SquareWave8kHz = 0x12,
+  SquareWave32kHz = 0x13
+};
+
+/**
+ * DS1307 counting whole seconds from the wall clock of the stand-in
+ * core, so it keeps time however millis() does. Stopped until adjusted,
+ * as a chip whose backup battery has run out
+ */
+class RTC_DS1307 {
+
+  private:
+
+    bool _running;
+    uint32_t _time;                 // unix time when set
+    unsigned long long _setAt;      // nativeNow() when set
+    Ds1307SqwPinMode _sqw;
+
+  public:
+
+    RTC_DS1307();
+    bool begin();
+    void adjust(const DateTime & dt);
+    uint8_t isrunning();
+    DateTime now();
+    Ds1307SqwPinMode readSqwPinMode();
+    void writeSqwPinMode(Ds1307SqwPinMode mode);
+
+};
+
+#endif
@@ -0,0 +1,301 @@
+/*
+
+  Palette indexed WS2812 strip
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "paletteStrip.h"
+
+// Milliseconds millis() returns, wiring.c in the AVR core
+extern volatile unsigned long timer0_millis;
+
+// Perceived level to led duty, 255 * (i / 255) ^ PALETTE_GAMMA in
+// 8.8 fixed point, the fraction is what dithering renders. Truncated,
+// so adding a half rounds to the same byte as Adafruit_NeoPixel::gamma8()
+const uint16_t palette_gamma[256] PROGMEM = {
+  0, 0, 0, 0, 1, 2, 3, 5, 8, 10, 14, 18,
+  23, 28, 34, 41, 48, 57, 66, 76, 87, 98, 111, 125,
+  140, 155, 172, 190, 209, 229, 250, 272, 295, 320, 346, 373,
+  401, 431, 462, 494, 528, 563, 600, 637, 677, 718, 760, 803,
+  849, 895, 944, 994, 1045, 1098, 1153, 1209, 1267, 1327, 1388, 1452,
+  1516, 1583, 1651, 1722, 1794, 1867, 1943, 2021, 2100, 2181, 2264, 2349,
+  2436, 2525, 2616, 2709, 2804, 2901, 3000, 3101, 3204, 3310, 3417, 3526,
+  3638, 3752, 3867, 3985, 4106, 4228, 4353, 4480, 4609, 4740, 4874, 5010,
+  5148, 5289, 5432, 5577, 5725, 5875, 6027, 6182, 6339, 6499, 6661, 6826,
+  6993, 7162, 7334, 7509, 7686, 7866, 8048, 8233, 8421, 8611, 8803, 8999,
+  9197, 9397, 9600, 9806, 10015, 10226, 10440, 10657, 10877, 11099, 11324, 11552,
+  11783, 12016, 12253, 12492, 12734, 12979, 13226, 13477, 13731, 13987, 14247, 14509,
+  14774, 15042, 15314, 15588, 15865, 16145, 16429, 16715, 17004, 17297, 17592, 17891,
+  18192, 18497, 18805, 19116, 19430, 19747, 20068, 20392, 20719, 21049, 21382, 21718,
+  22058, 22401, 22747, 23097, 23450, 23806, 24165, 24528, 24894, 25264, 25637, 26013,
+  26392, 26775, 27161, 27551, 27944, 28341, 28741, 29144, 29551, 29962, 30376, 30793,
+  31214, 31639, 32067, 32498, 32933, 33372, 33814, 34260, 34709, 35162, 35619, 36079,
+  36543, 37011, 37482, 37957, 38436, 38918, 39404, 39894, 40387, 40884, 41385, 41890,
+  42398, 42911, 43427, 43947, 44470, 44998, 45529, 46064, 46603, 47146, 47693, 48243,
+  48798, 49356, 49919, 50485, 51055, 51629, 52207, 52790, 53376, 53966, 54560, 55158,
+  55760, 56366, 56976, 57590, 58208, 58831, 59457, 60088, 60722, 61361, 62003, 62650,
+  63301, 63957, 64616, 65280
+};
+
+#ifdef __AVR__
+/**
+ * Sends a byte MSB first, 16MHz timing: 6 cycles high for a 0,
+ * 13 cycles high for a 1, 20-21 cycles per bit. The line is left low,
+ * the time until the next byte only stretches the last low period
+ */
+static inline void _send(volatile uint8_t * port, uint8_t hi, uint8_t lo, uint8_t value) {
+  uint8_t bits = 8;
+  asm volatile(
+    "1:"                        "\n\t"
+    "st   %a[port], %[hi]"      "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "sbrs %[value], 7"          "\n\t"
+    "st   %a[port], %[lo]"      "\n\t"
+    "lsl  %[value]"             "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "st   %a[port], %[lo]"      "\n\t"
+    "nop"                       "\n\t"
+    "nop"                       "\n\t"
+    "dec  %[bits]"              "\n\t"
+    "brne 1b"                   "\n\t"
+    : [value] "+r" (value), [bits] "+r" (bits)
+    : [port] "e" (port), [hi] "r" (hi), [lo] "r" (lo)
+  );
+}
+#endif
+
+/**
+ * @param  uint8_t * pixels     Buffer of PALETTE_BUFFER(count) bytes
+ * @param  uint16_t count       Number of leds
+ * @param  uint8_t pin          Data pin
+ */
+PaletteStrip::PaletteStrip(uint8_t * pixels, uint16_t count, uint8_t pin) {
+  _pixels = pixels;
+  _count = count;
+  _pin = pin;
+  _brightness = 0;
+  _dither = false;
+  _lost = 0;
+  for (uint8_t i=0; i<PALETTE_SIZE; i++) setPalette(i, 0);
+  clear();
+}
+
+void PaletteStrip::begin() {
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  _port = portOutputRegister(digitalPinToPort(_pin));
+  _mask = digitalPinToBitMask(_pin);
+  _latched = micros();
+}
+
+/**
+ * Streams the frame, expanding every index to its GRB bytes on the fly
+ */
+void PaletteStrip::show() {
+
+  if (_dither) _advance();
+  while ((micros() - _latched) < PALETTE_LATCH) {}
+  uint16_t before = micros() % PALETTE_TICK;
+
+  #ifdef __AVR__
+    volatile uint8_t * port = _port;
+    uint8_t hi = *port | _mask;
+    uint8_t lo = *port & ~_mask;
+    const uint8_t * pixel = _pixels;
+    const uint8_t * grb;
+    noInterrupts();
+    for (uint16_t n=0; n<_count; n+=2) {
+      uint8_t pair = *pixel++;
+      grb = _grb[pair & 0x0F];
+      _send(port, hi, lo, grb[0]);
+      _send(port, hi, lo, grb[1]);
+      _send(port, hi, lo, grb[2]);
+      if (n + 1 == _count) break;
+      grb = _grb[pair >> 4];
+      _send(port, hi, lo, grb[0]);
+      _send(port, hi, lo, grb[1]);
+      _send(port, hi, lo, grb[2]);
+    }
+    interrupts();
+  #elif defined(ARDUINO_ARCH_NATIVE)
+    // the host stand-in takes the bytes from its data line
+    noInterrupts();
+    for (uint16_t n=0; n<_count; n++) {
+      const uint8_t * grb = _grb[getPixel(n)];
+      nativeWire(grb[0]);
+      nativeWire(grb[1]);
+      nativeWire(grb[2]);
+    }
+    interrupts();
+  #endif
+
+  _restore(before);
+  _latched = micros();
+
+}
+
+/**
+ * Gives millis() back the ticks a show lost: with interrupts off the
+ * first timer0 overflow waits and the ones after it are dropped. How
+ * many fell is told by the timer phase before and after, the show time
+ * only has to be right to half a tick. micros() is left as it is
+ * @param  uint16_t before    micros() % PALETTE_TICK as the show began
+ */
+void PaletteStrip::_restore(uint16_t before) {
+  uint16_t after = micros() % PALETTE_TICK;
+  long span = (long) _count * PALETTE_LED_TIME + before + PALETTE_TICK / 2 - after;
+  if (span < 2 * PALETTE_TICK) return;
+  uint16_t ticks = span / PALETTE_TICK;
+  _lost += (ticks - 1) * PALETTE_TICK;
+  uint16_t ms = _lost / 1000;
+  _lost -= ms * 1000;
+  noInterrupts();
+  timer0_millis += ms;
+  interrupts();
+}
+
+void PaletteStrip::clear() {
+  for (uint16_t i=0; i<PALETTE_BUFFER(_count); i++) _pixels[i] = 0;
+}
+
+void PaletteStrip::setPixel(uint16_t n, uint8_t index) {
+  if (n >= _count) return;
+  uint8_t * pair = &_pixels[n >> 1];
+  if (n & 1) {
+    *pair = (*pair & 0x0F) | (index << 4);
+  } else {
+    *pair = (*pair & 0xF0) | (index & 0x0F);
+  }
+}
+
+uint8_t PaletteStrip::getPixel(uint16_t n) {
+  if (n >= _count) return 0;
+  uint8_t pair = _pixels[n >> 1];
+  return (n & 1) ? pair >> 4 : pair & 0x0F;
+}
+
+/**
+ * Sets a palette color, every pixel using it changes on next show()
+ * @param  uint8_t index        Palette entry
+ * @param  unsigned long color  0xRRGGBB
+ */
+void PaletteStrip::setPalette(uint8_t index, unsigned long color) {
+  if (index >= PALETTE_SIZE) return;
+  _colors[index][0] = color >> 16;
+  _colors[index][1] = color >> 8;
+  _colors[index][2] = color;
+  _scale(index);
+}
+
+unsigned long PaletteStrip::getPalette(uint8_t index) {
+  if (index >= PALETTE_SIZE) return 0;
+  return Color(_colors[index][0], _colors[index][1], _colors[index][2]);
+}
+
+/**
+ * Scales the whole palette, 255 is full brightness. Unlike
+ * Adafruit_NeoPixel it always scales from the original colors, and
+ * both colors and level are perceived values, evenly spaced to the eye
+ * @param  uint8_t level        Brightness
+ */
+void PaletteStrip::setBrightness(uint8_t level) {
+  _brightness = level + 1;
+  for (uint8_t i=0; i<PALETTE_SIZE; i++) _scale(i);
+}
+
+/**
+ * Renders the fraction of the palette levels over time: every show()
+ * sends the integer duty and adds the fraction to an error accumulator,
+ * one more step is sent whenever it overflows. A level of 1.25 is sent
+ * as 1, 1, 1, 2, 1, 1, 1, 2... Needs show() called at a steady rate,
+ * the more often the less flicker
+ * @param  bool enabled         Dither, otherwise send rounded levels
+ */
+void PaletteStrip::setDither(bool enabled) {
+  _dither = enabled;
+  for (uint8_t i=0; i<PALETTE_SIZE; i++) _scale(i);
+}
+
+/**
+ * Whether the frame changes from one show() to the next even if the
+ * pixels and palette do not, so it has to be refreshed
+ */
+bool PaletteStrip::dithering() {
+  if (!_dither) return false;
+  for (uint8_t i=0; i<PALETTE_SIZE; i++) {
+    if (_fraction[i][0] | _fraction[i][1] | _fraction[i][2]) return true;
+  }
+  return false;
+}
+
+// Same scaling as Adafruit_NeoPixel, 0 means no scaling, then the
+// gamma table turns the perceived level into the led duty. Done once
+// per palette entry, show() sends the result as is
+void PaletteStrip::_scale(uint8_t index) {
+  uint8_t r = _colors[index][0];
+  uint8_t g = _colors[index][1];
+  uint8_t b = _colors[index][2];
+  if (_brightness) {
+    r = ((uint16_t) r * _brightness) >> 8;
+    g = ((uint16_t) g * _brightness) >> 8;
+    b = ((uint16_t) b * _brightness) >> 8;
+  }
+  _level(index, 0, g);
+  _level(index, 1, r);
+  _level(index, 2, b);
+}
+
+void PaletteStrip::_level(uint8_t index, uint8_t channel, uint8_t value) {
+  uint16_t duty = pgm_read_word(&palette_gamma[value]);
+  if (_dither) {
+    _duty[index][channel] = duty >> 8;
+    _fraction[index][channel] = duty;
+  } else {
+    _duty[index][channel] = (duty + 0x80) >> 8;
+    _fraction[index][channel] = 0;
+  }
+  _error[index][channel] = 0;
+  _grb[index][channel] = _duty[index][channel];
+}
+
+// Next dithered frame, a first order sigma-delta per palette channel
+void PaletteStrip::_advance() {
+  uint8_t * grb = &_grb[0][0];
+  const uint8_t * duty = &_duty[0][0];
+  const uint8_t * fraction = &_fraction[0][0];
+  uint8_t * error = &_error[0][0];
+  for (uint8_t i=0; i<PALETTE_SIZE * 3; i++) {
+    uint8_t e = error[i] + fraction[i];
+    grb[i] = duty[i] + (e < error[i] ? 1 : 0);
+    error[i] = e;
+  }
+}
+
+uint16_t PaletteStrip::numPixels() {
+  return _count;
+}
+
+unsigned long PaletteStrip::Color(uint8_t r, uint8_t g, uint8_t b) {
+  return ((unsigned long) r << 16) | ((unsigned long) g << 8) | b;
+}
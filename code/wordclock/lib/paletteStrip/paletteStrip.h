@@ -0,0 +1,92 @@
+/*
+
+  Palette indexed WS2812 strip
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _PALETTE_STRIP_h
+#define _PALETTE_STRIP_h
+
+// 4 bits per pixel, two pixels per byte
+#define PALETTE_SIZE 16
+#define PALETTE_BUFFER(pixels) (((pixels) + 1) / 2)
+
+// Colors and brightness are perceived levels, sent as level ^ gamma
+#define PALETTE_GAMMA 2.6
+
+// Low time that latches the data into the leds, in microseconds
+#define PALETTE_LATCH 300
+
+// Time a led takes to send, 24 bits of 1.25us, and between two timer0
+// interrupts, the millis() tick, in microseconds
+#define PALETTE_LED_TIME 30
+#ifdef __AVR__
+  #define PALETTE_TICK 1024
+#else
+  #define PALETTE_TICK 1000
+#endif
+
+class PaletteStrip {
+
+  private:
+
+    uint8_t * _pixels;
+    uint16_t _count;
+    uint8_t _pin;
+    volatile uint8_t * _port;
+    uint8_t _mask;
+    unsigned long _latched;
+    uint16_t _lost;       // microseconds lost to millis() not given back yet
+
+    // Colors as set, 48 bytes. The ones sent can't give them back, so
+    // they are kept to rescale every brightness change from the
+    // original instead of losing a bit of them each time, and for
+    // getPalette() to tell what is being shown
+    uint8_t _brightness;
+    uint8_t _colors[PALETTE_SIZE][3];
+    uint8_t _grb[PALETTE_SIZE][3];    // colors as sent, brightness and gamma applied
+
+    bool _dither;
+    uint8_t _duty[PALETTE_SIZE][3];       // integer part of the gamma level
+    uint8_t _fraction[PALETTE_SIZE][3];   // 1/256 steps left to dither
+    uint8_t _error[PALETTE_SIZE][3];      // dithering accumulators
+
+    void _scale(uint8_t index);
+    void _level(uint8_t index, uint8_t channel, uint8_t value);
+    void _advance();
+    void _restore(uint16_t before);
+
+  public:
+
+    PaletteStrip(uint8_t * pixels, uint16_t count, uint8_t pin);
+    void begin();
+    void show();
+    void clear();
+    void setPixel(uint16_t n, uint8_t index);
+    uint8_t getPixel(uint16_t n);
+    void setPalette(uint8_t index, unsigned long color);
+    unsigned long getPalette(uint8_t index);
+    void setBrightness(uint8_t level);
+    void setDither(bool enabled);
+    bool dithering();
+    uint16_t numPixels();
+
+    static unsigned long Color(uint8_t r, uint8_t g, uint8_t b);
+
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+
+  Pin change capture queue
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "pinChange.h"
+
+static PinChange * _instance = NULL;
+
+// Keeps the compiler from moving the slot accesses across the indexes
+#define PIN_CHANGE_BARRIER() asm volatile("" ::: "memory")
+
+#ifdef __AVR__
+// Every port raises its own vector, all of them sample every pin
+ISR(PCINT0_vect) {
+  if (_instance) _instance->sample();
+}
+#ifdef PCINT1_vect
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+#ifdef PCINT2_vect
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+#endif
+
+/**
+ * @param  pin_change_t * queue   Ring buffer
+ * @param  uint8_t size           Ring buffer size, a power of two
+ */
+PinChange::PinChange(pin_change_t * queue, uint8_t size) {
+  _queue = queue;
+  _mask = size - 1;
+  _head = _tail = 0;
+  _levels = 0;
+  _overflows = 0;
+  _count = 0;
+  _callback = NULL;
+}
+
+/**
+ * Starts watching the pins, they must be configured as inputs already
+ * @param  const uint8_t * pins   Pins, pin i is bit i of the levels
+ * @param  uint8_t count          Number of pins
+ * @param  pin_change_callback_t  Called from the interrupt on every change queued
+ */
+void PinChange::begin(const uint8_t * pins, uint8_t count, pin_change_callback_t callback) {
+
+  _pins = pins;
+  _callback = callback;
+  _count = count < PIN_CHANGE_MAX_PINS ? count : PIN_CHANGE_MAX_PINS;
+  for (uint8_t i=0; i<_count; i++) {
+    _inputs[i] = portInputRegister(digitalPinToPort(pins[i]));
+    _bits[i] = digitalPinToBitMask(pins[i]);
+  }
+  _levels = _read();
+  _instance = this;
+
+  #ifdef __AVR__
+    for (uint8_t i=0; i<_count; i++) {
+      *digitalPinToPCMSK(pins[i]) |= _BV(digitalPinToPCMSKbit(pins[i]));
+      PCIFR |= _BV(digitalPinToPCICRbit(pins[i]));
+      PCICR |= _BV(digitalPinToPCICRbit(pins[i]));
+    }
+  #endif
+
+}
+
+uint8_t PinChange::_read() {
+  uint8_t levels = 0;
+  for (uint8_t i=0; i<_count; i++) {
+    if (*_inputs[i] & _bits[i]) levels |= (1 << i);
+  }
+  return levels;
+}
+
+/**
+ * Queues the levels if they have changed. Called from the interrupt,
+ * or from the main loop with interrupts disabled on boards without it
+ */
+void PinChange::sample() {
+
+  uint8_t levels = _read();
+  if (levels == _levels) return;
+  _levels = levels;
+
+  uint8_t next = (_head + 1) & _mask;
+  if (next == _tail) {
+    _overflows++;
+    return;
+  }
+  _queue[_head].levels = levels;
+  _queue[_head].at = millis();
+  PIN_CHANGE_BARRIER();
+  _head = next;
+  if (_callback) _callback();
+
+}
+
+/**
+ * Takes the oldest change from the queue
+ * @param  pin_change_t * change  Where to copy it
+ * @return bool                   False if the queue is empty
+ */
+bool PinChange::read(pin_change_t * change) {
+  uint8_t tail = _tail;
+  if (tail == _head) return false;
+  PIN_CHANGE_BARRIER();
+  *change = _queue[tail];
+  PIN_CHANGE_BARRIER();
+  _tail = (tail + 1) & _mask;
+  return true;
+}
+
+/**
+ * Latest levels seen, queued or not
+ */
+uint8_t PinChange::levels() {
+  return _levels;
+}
+
+/**
+ * Changes lost because the queue was full
+ */
+unsigned int PinChange::overflows() {
+  noInterrupts();
+  unsigned int overflows = _overflows;
+  interrupts();
+  return overflows;
+}
@@ -0,0 +1,70 @@
+/*
+
+  Pin change capture queue
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _PIN_CHANGE_h
+#define _PIN_CHANGE_h
+
+// Pins watched, one bit each in the levels
+#define PIN_CHANGE_MAX_PINS 8
+
+struct pin_change_t {
+  uint8_t levels;         // bit i is the level of pin i
+  unsigned long at;       // millis() when it changed
+};
+
+// Called from the interrupt after a change has been queued
+typedef void(*pin_change_callback_t)();
+
+/**
+ * Captures the level of a set of pins on every pin change interrupt,
+ * with a timestamp, into a single producer single consumer ring buffer
+ * drained by the main loop. Only one instance, it owns the PCINT vectors
+ */
+class PinChange {
+
+  private:
+
+    pin_change_t * _queue;
+    uint8_t _mask;              // size - 1
+    volatile uint8_t _head;     // written by the interrupt only
+    volatile uint8_t _tail;     // written by the main loop only
+    volatile uint8_t _levels;
+    volatile unsigned int _overflows;
+
+    const uint8_t * _pins;
+    uint8_t _count;
+    volatile uint8_t * _inputs[PIN_CHANGE_MAX_PINS];
+    uint8_t _bits[PIN_CHANGE_MAX_PINS];
+    pin_change_callback_t _callback;
+
+    uint8_t _read();
+
+  public:
+
+    PinChange(pin_change_t * queue, uint8_t size);
+    void begin(const uint8_t * pins, uint8_t count, pin_change_callback_t callback = NULL);
+    void sample();
+    bool read(pin_change_t * change);
+    uint8_t levels();
+    unsigned int overflows();
+
+};
+
+#endif
@@ -0,0 +1,150 @@
+/*
+
+  Section profiler based on Timer1
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "profiler.h"
+
+#ifdef PROFILER
+
+Profiler profiler;
+
+/**
+ * Sets Timer1 free running at F_CPU/8
+ */
+void Profiler::begin() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);
+  TCNT1 = 0;
+  reset();
+}
+
+/**
+ * Adds a sample to a section
+ * @param  uint8_t section        Section index
+ * @param  unsigned int ticks     Duration in timer ticks
+ */
+void Profiler::record(uint8_t section, unsigned int ticks) {
+
+  profile_t * p = &_sections[section];
+
+  if (ticks < p->min) p->min = ticks;
+  if (ticks > p->max) p->max = ticks;
+  p->sum += ticks;
+  p->count++;
+
+  uint8_t bucket = 0;
+  unsigned int limit = PROFILER_BUCKET_BASE * PROFILER_TICKS_PER_US;
+  while ((bucket < PROFILER_BUCKETS - 1) && (ticks >= limit)) {
+    bucket++;
+    limit <<= 1;
+  }
+  if (p->histogram[bucket] < 0xFFFF) p->histogram[bucket]++;
+
+}
+
+/**
+ * Records the time since the previous call, to be called first thing
+ * in loop(). Sleeps and long tasks make the periods longer than the
+ * Timer1 range, they are taken with micros()
+ */
+void Profiler::loop() {
+
+  unsigned long now = micros();
+  unsigned long period = now - _loopAt;
+  _loopAt = now;
+  if (_periodCount++ == 0) return;
+
+  if (period > _periodMax) _periodMax = period;
+
+  uint8_t bucket = 0;
+  unsigned long limit = PROFILER_PERIOD_BASE;
+  while ((bucket < PROFILER_BUCKETS - 1) && (period >= limit)) {
+    bucket++;
+    limit <<= 1;
+  }
+  if (_periods[bucket] < 0xFFFF) _periods[bucket]++;
+
+}
+
+/**
+ * Prints a section statistics in microseconds
+ * @param  Print * out                        Where to print them
+ * @param  const __FlashStringHelper * name   Section name
+ * @param  uint8_t section                    Section index
+ */
+void Profiler::dump(Print * out, const __FlashStringHelper * name, uint8_t section) {
+
+  profile_t * p = &_sections[section];
+
+  out->print(name);
+  if (p->count == 0) {
+    out->println(F(": no samples"));
+    return;
+  }
+  out->print(F(": n "));
+  out->print(p->count);
+  out->print(F(", min "));
+  out->print(p->min / PROFILER_TICKS_PER_US);
+  out->print(F("us, max "));
+  out->print(p->max / PROFILER_TICKS_PER_US);
+  out->print(F("us, mean "));
+  out->print(p->sum / p->count / PROFILER_TICKS_PER_US);
+  out->print(F("us, histogram"));
+  for (uint8_t i=0; i<PROFILER_BUCKETS; i++) {
+    out->print(F(" "));
+    out->print(p->histogram[i]);
+  }
+  out->println();
+
+}
+
+/**
+ * Prints the loop period histogram
+ * @param  Print * out                        Where to print it
+ */
+void Profiler::dumpLoop(Print * out) {
+  out->print(F("loop: n "));
+  out->print(_periodCount > 0 ? _periodCount - 1 : 0);
+  out->print(F(", max "));
+  out->print(_periodMax);
+  out->print(F("us, histogram"));
+  for (uint8_t i=0; i<PROFILER_BUCKETS; i++) {
+    out->print(F(" "));
+    out->print(_periods[i]);
+  }
+  out->println();
+}
+
+/**
+ * Clears all sections and the loop periods
+ */
+void Profiler::reset() {
+  for (uint8_t i=0; i<PROFILER_SECTIONS; i++) {
+    profile_t * p = &_sections[i];
+    p->min = 0xFFFF;
+    p->max = 0;
+    p->sum = p->count = 0;
+    for (uint8_t j=0; j<PROFILER_BUCKETS; j++) p->histogram[j] = 0;
+  }
+  _periodMax = _periodCount = 0;
+  for (uint8_t i=0; i<PROFILER_BUCKETS; i++) _periods[i] = 0;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+
+  Section profiler based on Timer1
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _PROFILER_h
+#define _PROFILER_h
+
+// Enable with build_flags = -DPROFILER, otherwise everything compiles to nothing
+
+#ifdef PROFILER
+
+#ifndef PROFILER_SECTIONS
+#define PROFILER_SECTIONS 5
+#endif
+
+// Histogram buckets double from 32us up, the last one is open
+#define PROFILER_BUCKETS 8
+#define PROFILER_BUCKET_BASE 32
+
+// Loop period buckets double from 250us up, the last one is open
+#define PROFILER_PERIOD_BASE 250
+
+// Timer1 runs at F_CPU/8, 0.5us per tick at 16MHz, sections must be shorter than 32ms
+#define PROFILER_TICKS_PER_US (F_CPU / 8000000L)
+
+struct profile_t {
+    unsigned int min;
+    unsigned int max;
+    unsigned long sum;
+    unsigned long count;
+    unsigned int histogram[PROFILER_BUCKETS];
+};
+
+class Profiler {
+
+    private:
+
+        profile_t _sections[PROFILER_SECTIONS];
+
+        // time between loop() calls, in microseconds
+        unsigned long _loopAt;
+        unsigned long _periodMax;
+        unsigned long _periodCount;
+        unsigned int _periods[PROFILER_BUCKETS];
+
+    public:
+
+        void begin();
+        void record(uint8_t section, unsigned int ticks);
+        void loop();
+        void dump(Print * out, const __FlashStringHelper * name, uint8_t section);
+        void dumpLoop(Print * out);
+        void reset();
+
+        static inline unsigned int timer() { return TCNT1; }
+
+};
+
+extern Profiler profiler;
+
+#define PROFILE_START(section) unsigned int _profile_##section = Profiler::timer()
+#define PROFILE_STOP(section) profiler.record(section, Profiler::timer() - _profile_##section)
+#define PROFILE_LOOP() profiler.loop()
+
+#else
+
+#define PROFILE_START(section)
+#define PROFILE_STOP(section)
+#define PROFILE_LOOP()
+
+#endif
+
+#endif
@@ -0,0 +1,225 @@
+/*
+
+  Framed binary command protocol
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "protocol.h"
+
+// Parser states
+#define STATE_SYNC 0
+#define STATE_COMMAND 1
+#define STATE_LENGTH 2
+#define STATE_PAYLOAD 3
+#define STATE_CRC 4
+#define STATE_SKIP 5
+
+/**
+ * @param  uint8_t * payload      Buffer for the payload received
+ * @param  uint8_t size           Longest payload accepted
+ */
+Protocol::Protocol(uint8_t * payload, uint8_t size) {
+  _payload = payload;
+  _size = size;
+  _state = STATE_SYNC;
+  _last = 0;
+  _frames = _errors = 0;
+}
+
+uint8_t Protocol::_drop() {
+  _state = STATE_SYNC;
+  _errors++;
+  return PROTOCOL_INVALID;
+}
+
+/**
+ * Takes the next byte received
+ * @param  uint8_t c              Byte
+ * @param  unsigned long now      millis()
+ * @return uint8_t                PROTOCOL_TEXT, _PARTIAL, _FRAME, _INVALID or _OVERSIZE
+ */
+uint8_t Protocol::feed(uint8_t c, unsigned long now) {
+
+  // a sender that stopped halfway must not swallow the next frame
+  if ((_state != STATE_SYNC) && (now - _last > PROTOCOL_TIMEOUT)) {
+    _state = STATE_SYNC;
+    _errors++;
+  }
+  _last = now;
+
+  switch (_state) {
+
+    case STATE_SYNC:
+      if (c != PROTOCOL_SYNC) return PROTOCOL_TEXT;
+      _crc = 0;
+      _state = STATE_COMMAND;
+      break;
+
+    case STATE_COMMAND:
+      _command = c;
+      _crc = crc(_crc, c);
+      _state = STATE_LENGTH;
+      break;
+
+    case STATE_LENGTH:
+      _length = c;
+      _received = 0;
+      _crc = crc(_crc, c);
+      if (c > _size) {
+        // its payload is skipped, not taken for text, and its CRC
+        // tells whether the sender has to hear about it
+        _state = STATE_SKIP;
+        break;
+      }
+      _state = c > 0 ? STATE_PAYLOAD : STATE_CRC;
+      break;
+
+    case STATE_PAYLOAD:
+      _payload[_received++] = c;
+      _crc = crc(_crc, c);
+      if (_received == _length) _state = STATE_CRC;
+      break;
+
+    case STATE_CRC:
+      if (c != _crc) return _drop();
+      _state = STATE_SYNC;
+      _frames++;
+      return PROTOCOL_FRAME;
+
+    case STATE_SKIP:
+      if (_received < _length) {
+        _received++;
+        _crc = crc(_crc, c);
+        break;
+      }
+      _state = STATE_SYNC;
+      _errors++;
+      return c == _crc ? PROTOCOL_OVERSIZE : PROTOCOL_INVALID;
+
+  }
+
+  return PROTOCOL_PARTIAL;
+
+}
+
+/**
+ * Command of the last frame
+ */
+uint8_t Protocol::command() {
+  return _command;
+}
+
+/**
+ * Payload length of the last frame
+ */
+uint8_t Protocol::length() {
+  return _length;
+}
+
+/**
+ * Payload of the last frame, valid until the next byte is fed
+ */
+const uint8_t * Protocol::payload() {
+  return _payload;
+}
+
+/**
+ * Valid frames received
+ */
+unsigned long Protocol::frames() {
+  return _frames;
+}
+
+/**
+ * Frames dropped for a bad CRC or timeout, or skipped for their length
+ */
+unsigned long Protocol::errors() {
+  return _errors;
+}
+
+/**
+ * CRC-8, polynomial 0x07
+ * @param  uint8_t crc            CRC so far, 0 to start
+ * @param  uint8_t data           Next byte
+ */
+uint8_t Protocol::crc(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t i=0; i<8; i++) {
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+/**
+ * Builds a frame
+ * @param  uint8_t * buffer       Where to build it, length + PROTOCOL_OVERHEAD bytes
+ * @param  uint8_t command        Command
+ * @param  const uint8_t * payload
+ * @param  uint8_t length         Payload length
+ * @return uint8_t                Frame length
+ */
+uint8_t Protocol::frame(uint8_t * buffer, uint8_t command, const uint8_t * payload, uint8_t length) {
+  uint8_t crc = 0;
+  buffer[0] = PROTOCOL_SYNC;
+  buffer[1] = command;
+  buffer[2] = length;
+  crc = Protocol::crc(crc, command);
+  crc = Protocol::crc(crc, length);
+  for (uint8_t i=0; i<length; i++) {
+    buffer[3 + i] = payload[i];
+    crc = Protocol::crc(crc, payload[i]);
+  }
+  buffer[3 + length] = crc;
+  return length + PROTOCOL_OVERHEAD;
+}
+
+/**
+ * Starts writing a frame byte by byte, for payloads too long for a
+ * buffer. The output must have room for the whole frame
+ * @param  Print * out            Where to write it
+ * @param  uint8_t command        Command
+ * @param  uint8_t length         Payload length, exactly that many write() must follow
+ * @return uint8_t                CRC so far
+ */
+uint8_t Protocol::begin(Print * out, uint8_t command, uint8_t length) {
+  out->write(PROTOCOL_SYNC);
+  out->write(command);
+  out->write(length);
+  return crc(crc(0, command), length);
+}
+
+/**
+ * Writes the next payload byte of a frame
+ * @param  Print * out            Where to write it
+ * @param  uint8_t crc            CRC so far
+ * @param  uint8_t data           Byte
+ * @return uint8_t                CRC so far
+ */
+uint8_t Protocol::write(Print * out, uint8_t crc, uint8_t data) {
+  out->write(data);
+  return Protocol::crc(crc, data);
+}
+
+/**
+ * Closes a frame
+ * @param  Print * out            Where to write it
+ * @param  uint8_t crc            CRC of the whole frame
+ */
+void Protocol::end(Print * out, uint8_t crc) {
+  out->write(crc);
+}
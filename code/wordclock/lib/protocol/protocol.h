@@ -0,0 +1,76 @@
+/*
+
+  Framed binary command protocol
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _PROTOCOL_h
+#define _PROTOCOL_h
+
+// Frame: sync, command, payload length, payload, CRC-8 of command,
+// length and payload. Text is 7 bit, so the sync byte never shows up
+// in the log and both can share the port
+#define PROTOCOL_SYNC 0xA5
+#define PROTOCOL_OVERHEAD 4
+#define PROTOCOL_TIMEOUT 100        // ms between bytes before a frame is dropped
+
+// What feed() made of a byte
+#define PROTOCOL_TEXT 0             // not part of a frame, a text command
+#define PROTOCOL_PARTIAL 1          // frame in progress
+#define PROTOCOL_FRAME 2            // valid frame ready
+#define PROTOCOL_INVALID 3          // frame dropped
+#define PROTOCOL_OVERSIZE 4         // valid frame skipped, its payload too long
+
+/**
+ * Incremental frame parser, takes the received bytes one at a time so
+ * it never waits for the rest of a frame
+ */
+class Protocol {
+
+  private:
+
+    uint8_t * _payload;
+    uint8_t _size;
+    uint8_t _state;
+    uint8_t _command;
+    uint8_t _length;
+    uint8_t _received;
+    uint8_t _crc;
+    unsigned long _last;
+    unsigned long _frames;
+    unsigned long _errors;
+
+    uint8_t _drop();
+
+  public:
+
+    Protocol(uint8_t * payload, uint8_t size);
+    uint8_t feed(uint8_t c, unsigned long now);
+    uint8_t command();
+    uint8_t length();
+    const uint8_t * payload();
+    unsigned long frames();
+    unsigned long errors();
+    static uint8_t crc(uint8_t crc, uint8_t data);
+    static uint8_t frame(uint8_t * buffer, uint8_t command, const uint8_t * payload, uint8_t length);
+    static uint8_t begin(Print * out, uint8_t command, uint8_t length);
+    static uint8_t write(Print * out, uint8_t crc, uint8_t data);
+    static void end(Print * out, uint8_t crc);
+
+};
+
+#endif
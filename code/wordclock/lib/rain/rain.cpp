@@ -0,0 +1,239 @@
+/*
+
+  Falling rays particle engine
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "rain.h"
+
+// Shades per pixel away from the tip for every ray length, 8.8 fixed point
+#define RAIN_STEP(length) ((RAIN_SHADES << 8) / (length))
+const uint16_t rain_gradient[RAIN_LENGTH_MAX] PROGMEM = {
+  0, RAIN_STEP(1), RAIN_STEP(2), RAIN_STEP(3), RAIN_STEP(4),
+  RAIN_STEP(5), RAIN_STEP(6), RAIN_STEP(7), RAIN_STEP(8), RAIN_STEP(9),
+  RAIN_STEP(10), RAIN_STEP(11), RAIN_STEP(12), RAIN_STEP(13), RAIN_STEP(14),
+  RAIN_STEP(15), RAIN_STEP(16), RAIN_STEP(17), RAIN_STEP(18), RAIN_STEP(19)
+};
+
+Rain::Rain(ray_t * rays, uint8_t size) {
+  _rays = rays;
+  _size = size < RAIN_MAX_RAYS ? size : RAIN_MAX_RAYS;
+}
+
+/**
+ * Clears all rays and restarts the random sequence, the same seed
+ * always plays the same animation
+ * @param  uint16_t seed          Random seed
+ * @param  unsigned long period   Milliseconds per step
+ */
+void Rain::begin(uint16_t seed, unsigned long period) {
+  for (uint8_t i=0; i<RAIN_SETS; i++) _live[i] = 0;
+  _alive = 0;
+  _seed = seed == 0 ? 1 : seed;   // xorshift never leaves 0
+  _period = period;
+  _last = millis() - period / 2;
+  _dropped = 0;
+}
+
+/**
+ * 16 bit xorshift
+ */
+uint16_t Rain::random16() {
+  _seed ^= _seed << 7;
+  _seed ^= _seed >> 9;
+  _seed ^= _seed << 8;
+  return _seed;
+}
+
+/**
+ * Random number from min to max, max excluded, without a division
+ */
+uint8_t Rain::random(uint8_t min, uint8_t max) {
+  return min + (((random16() >> 8) * (uint8_t) (max - min)) >> 8);
+}
+
+/**
+ * Number of steps to run at time now. Steps that are too late are
+ * dropped and counted, long gaps restart the timeline.
+ * The timeline runs half a period ahead to absorb the caller jitter
+ * @param  unsigned long now      Current millis()
+ * @return uint8_t                Steps to run
+ */
+uint8_t Rain::due(unsigned long now) {
+
+  unsigned long elapsed = now - _last;
+  if (elapsed > RAIN_RESYNC * _period) {
+    _last = now - _period / 2;
+    return 1;
+  }
+
+  uint8_t steps = 0;
+  while (elapsed >= _period) {
+    elapsed -= _period;
+    steps++;
+  }
+  _last = now - elapsed;
+
+  if (steps > RAIN_CATCHUP) {
+    _dropped += steps - RAIN_CATCHUP;
+    steps = RAIN_CATCHUP;
+  }
+  return steps;
+
+}
+
+/**
+ * Maybe spawns a ray in the first free slot
+ * @return bool       True if a ray has been born
+ */
+bool Rain::spawn() {
+
+  if (_alive >= _size) return false;
+  if ((random16() >> 8) >= RAIN_BIRTH) return false;
+
+  uint8_t set = 0;
+  while (_live[set] == 0xFF) set++;
+  uint8_t bit = 0;
+  while (_live[set] & (1 << bit)) bit++;
+  uint8_t i = (set << 3) + bit;
+  if (i >= _size) return false;
+
+  ray_t * ray = &_rays[i];
+  ray->x = random(0, RAIN_WIDTH);
+  ray->y = (int8_t) random(0, RAIN_TOP_MAX - RAIN_TOP_MIN) + RAIN_TOP_MIN;
+  ray->speed = ray->tick = random(RAIN_SPEED_MIN, RAIN_SPEED_MAX);
+  ray->length = random(RAIN_LENGTH_MIN, RAIN_LENGTH_MAX);
+  ray->life = random(RAIN_LIFE_MIN, RAIN_LIFE_MAX);
+
+  _live[set] |= (1 << bit);
+  _alive++;
+  return true;
+
+}
+
+void Rain::_kill(uint8_t i) {
+  _live[i >> 3] &= ~(1 << (i & 7));
+  _alive--;
+}
+
+/**
+ * Moves every live ray that is due one row down and frees the ones
+ * that have run out of life or left the matrix
+ * @return bool       True if any ray has moved or died
+ */
+bool Rain::step() {
+
+  bool changed = false;
+
+  for (uint8_t set=0; set<RAIN_SETS; set++) {
+    uint8_t i = set << 3;
+    for (uint8_t bits = _live[set]; bits > 0; bits >>= 1, i++) {
+      if ((bits & 1) == 0) continue;
+      ray_t * ray = &_rays[i];
+      if (--ray->tick == 0) {
+        ray->tick = ray->speed;
+        ray->y++;
+        ray->life--;
+        changed = true;
+      }
+      if ((ray->life == 0) || (ray->y - ray->length + 1 >= RAIN_HEIGHT)) {
+        _kill(i);
+        changed = true;
+      }
+    }
+  }
+
+  return changed;
+
+}
+
+/**
+ * Stops the rays whose tip is on a target pixel not hit before and
+ * marks it as hit, the ray then fades out
+ * @param  const rain_row_t *     Target pattern, one row mask per row
+ * @param  rain_row_t *           Pixels hit so far
+ * @return uint8_t                Number of new hits
+ */
+uint8_t Rain::hit(const rain_row_t * target, rain_row_t * hits) {
+
+  uint8_t count = 0;
+
+  for (uint8_t set=0; set<RAIN_SETS; set++) {
+    uint8_t i = set << 3;
+    for (uint8_t bits = _live[set]; bits > 0; bits >>= 1, i++) {
+      if ((bits & 1) == 0) continue;
+      ray_t * ray = &_rays[i];
+      if (ray->y < 0 || ray->y >= RAIN_HEIGHT) continue;
+      rain_row_t value = (rain_row_t) 1 << ray->x;
+      if ((target[ray->y] & value) && !(hits[ray->y] & value)) {
+        hits[ray->y] |= value;
+        ray->life = ray->length - 1;
+        count++;
+      }
+    }
+  }
+
+  return count;
+
+}
+
+/**
+ * Draws every live ray, yellow tip fading from green to black
+ * @param  rain_pixel_t pixel     Callback to set a pixel shade
+ */
+void Rain::draw(rain_pixel_t pixel) {
+
+  for (uint8_t set=0; set<RAIN_SETS; set++) {
+    uint8_t i = set << 3;
+    for (uint8_t bits = _live[set]; bits > 0; bits >>= 1, i++) {
+      if ((bits & 1) == 0) continue;
+      ray_t * ray = &_rays[i];
+
+      // a dying ray loses its pixels from the tip
+      uint8_t start = ray->life < ray->length ? ray->length - ray->life : 0;
+      uint16_t gradient = pgm_read_word(&rain_gradient[ray->length]);
+      uint16_t level = start * gradient;
+
+      int8_t y = ray->y - start;
+      for (uint8_t p=start; p<ray->length; p++, y--, level += gradient) {
+        if (y < 0) break;
+        if (y >= RAIN_HEIGHT) continue;
+        pixel(ray->x, y, p == 0 ? 0 : 1 + (level >> 8));
+      }
+    }
+  }
+
+}
+
+uint8_t Rain::alive() {
+  return _alive;
+}
+
+unsigned long Rain::dropped() {
+  return _dropped;
+}
+
+/**
+ * Color of a shade, as 0xRRGGBB
+ * @param  uint8_t shade          0 for the tip, 1 to RAIN_SHADES
+ */
+unsigned long Rain::color(uint8_t shade) {
+  if (shade == 0) return 0xFFFF00;
+  unsigned long green = 255 - (255 * (shade - 1)) / RAIN_SHADES;
+  return green << 8;
+}
@@ -0,0 +1,125 @@
+/*
+
+  Falling rays particle engine
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _RAIN_h
+#define _RAIN_h
+
+#ifndef RAIN_WIDTH
+#define RAIN_WIDTH 16
+#endif
+#ifndef RAIN_HEIGHT
+#define RAIN_HEIGHT 16
+#endif
+
+// Hit patterns are one mask per row, bit x is column x
+#if RAIN_WIDTH <= 8
+typedef uint8_t rain_row_t;
+#elif RAIN_WIDTH <= 16
+typedef uint16_t rain_row_t;
+#elif RAIN_WIDTH <= 32
+typedef uint32_t rain_row_t;
+#elif RAIN_WIDTH <= 64
+typedef uint64_t rain_row_t;
+#else
+#error "RAIN_WIDTH must be 64 or less"
+#endif
+
+// Up to 64 rays, one bit each in the live set
+#define RAIN_MAX_RAYS 64
+#define RAIN_SETS (RAIN_MAX_RAYS / 8)
+
+// Spawn probability per step, out of 256 (~75%)
+#define RAIN_BIRTH 192
+
+// Ranges for new rays, maximum values excluded
+#define RAIN_TOP_MIN -5
+#define RAIN_TOP_MAX 5
+#define RAIN_SPEED_MIN 2
+#define RAIN_SPEED_MAX 4
+#define RAIN_LENGTH_MIN 5
+#define RAIN_LENGTH_MAX 20
+#define RAIN_LIFE_MIN 10
+#define RAIN_LIFE_MAX 40
+
+// Speed and tick share a byte
+#if RAIN_SPEED_MAX > 16
+#error "RAIN_SPEED_MAX must be 16 or less"
+#endif
+
+// The tip row is signed and goes down to the matrix bottom plus a ray
+#if RAIN_HEIGHT + RAIN_LENGTH_MAX > 127
+#error "RAIN_HEIGHT too large for the ray rows"
+#endif
+
+// Steps run at most to catch up a late frame, the rest are dropped
+#define RAIN_CATCHUP 4
+
+// Longer gaps (in steps) are a pause, not a late frame
+#define RAIN_RESYNC 50
+
+// Shades drawn: 0 is the tip, then RAIN_SHADES from bright to dim green
+#define RAIN_SHADES 10
+
+struct ray_t {
+  uint8_t x;
+  int8_t y;         // row of the tip, negative above the matrix
+  uint8_t speed:4;  // steps per row
+  uint8_t tick:4;   // steps left to move down
+  uint8_t length;
+  uint8_t life;     // rows left to fall
+};
+
+typedef void (*rain_pixel_t)(uint8_t x, uint8_t y, uint8_t shade);
+
+class Rain {
+
+  private:
+
+    ray_t * _rays;
+    uint8_t _size;
+    uint8_t _live[RAIN_SETS];
+    uint8_t _alive;
+    uint16_t _seed;
+
+    unsigned long _period;
+    unsigned long _last;
+    unsigned long _dropped;
+
+    void _kill(uint8_t i);
+
+  public:
+
+    Rain(ray_t * rays, uint8_t size);
+    void begin(uint16_t seed, unsigned long period);
+    uint16_t random16();
+    uint8_t random(uint8_t min, uint8_t max);
+    uint8_t due(unsigned long now);
+    bool spawn();
+    bool step();
+    uint8_t hit(const rain_row_t * target, rain_row_t * hits);
+    void draw(rain_pixel_t pixel);
+    uint8_t alive();
+    unsigned long dropped();
+
+    static unsigned long color(uint8_t shade);
+
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+
+  Cooperative task scheduler
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+/**
+ * @param  const task_config_t * config   PROGMEM array with the tasks
+ * @param  task_t * tasks                 RAM array as long, for their state
+ * @param  uint8_t count                  Number of tasks
+ */
+Scheduler::Scheduler(const task_config_t * config, task_t * tasks, uint8_t count) {
+  _config = config;
+  _tasks = tasks;
+  _count = count;
+}
+
+/**
+ * Releases every task now
+ */
+void Scheduler::begin() {
+  unsigned long now = millis();
+  for (uint8_t i=0; i<_count; i++) _tasks[i].release = now;
+  reset();
+}
+
+/**
+ * Runs the highest priority task that has been released, if any
+ * @return bool       True if a task has run
+ */
+bool Scheduler::loop() {
+
+  unsigned long now = millis();
+
+  // pick the ready task with the lowest priority value
+  uint8_t index = _count;
+  uint8_t priority = 0;
+  for (uint8_t i=0; i<_count; i++) {
+    if ((long) (now - _tasks[i].release) < 0) continue;
+    uint8_t p = pgm_read_byte(&_config[i].priority);
+    if ((index == _count) || (p < priority)) {
+      index = i;
+      priority = p;
+    }
+  }
+  if (index == _count) return false;
+
+  // run it
+  task_t * task = &_tasks[index];
+  task_config_t config;
+  memcpy_P(&config, &_config[index], sizeof(task_config_t));
+  unsigned long jitter = now - task->release;
+  config.callback();
+  unsigned long end = millis();
+
+  // statistics
+  task->runs++;
+  task->jitterSum += jitter;
+  if (jitter > task->jitterMax) task->jitterMax = jitter;
+  if (end - task->release > config.deadline) task->missed++;
+
+  // next release, skipping the periods we have fallen behind
+  task->release += config.period;
+  if ((long) (end - task->release) >= 0) task->release = end + config.period;
+
+  return true;
+
+}
+
+/**
+ * Milliseconds until the next task is released
+ */
+unsigned long Scheduler::next() {
+  unsigned long now = millis();
+  unsigned long wait = 0xFFFFFFFF;
+  for (uint8_t i=0; i<_count; i++) {
+    long left = (long) (_tasks[i].release - now);
+    if (left <= 0) return 0;
+    if ((unsigned long) left < wait) wait = left;
+  }
+  return wait;
+}
+
+/**
+ * Clears the statistics
+ */
+void Scheduler::reset() {
+  for (uint8_t i=0; i<_count; i++) {
+    _tasks[i].runs = _tasks[i].missed = 0;
+    _tasks[i].jitterSum = _tasks[i].jitterMax = 0;
+  }
+}
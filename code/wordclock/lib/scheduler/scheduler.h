@@ -0,0 +1,63 @@
+/*
+
+  Cooperative task scheduler
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _SCHEDULER_h
+#define _SCHEDULER_h
+
+typedef void(*task_callback_t)();
+
+// What a task runs and when, kept in flash
+struct task_config_t {
+    task_callback_t callback;
+    uint16_t period;            // ms between releases
+    uint16_t deadline;          // ms after release the task must have finished
+    uint8_t priority;           // lower value runs first
+};
+
+// Next release and statistics of a task, in RAM
+struct task_t {
+    unsigned long release;
+    unsigned long runs;
+    unsigned long missed;
+    unsigned long jitterSum;
+    unsigned long jitterMax;
+};
+
+#define TASK(callback, period, deadline, priority) { callback, period, deadline, priority }
+
+class Scheduler {
+
+    private:
+
+        const task_config_t * _config;
+        task_t * _tasks;
+        uint8_t _count;
+
+    public:
+
+        Scheduler(const task_config_t * config, task_t * tasks, uint8_t count);
+        void begin();
+        bool loop();
+        unsigned long next();
+        void reset();
+
+};
+
+#endif
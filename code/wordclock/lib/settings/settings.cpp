@@ -0,0 +1,170 @@
+/*
+
+  Wear leveled settings store
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "settings.h"
+
+/**
+ * @param  void * data            Settings, loaded and saved as they are
+ * @param  uint8_t size           Size of the settings
+ * @param  uint8_t version        Records of other versions are ignored
+ * @param  unsigned long quiet    Milliseconds without changes to write
+ */
+Settings::Settings(void * data, uint8_t size, uint8_t version, unsigned long quiet) {
+  _data = (uint8_t *) data;
+  _size = size;
+  _version = version;
+  _quiet = quiet;
+  _dirty = false;
+  _position = 0;
+  _writes = 0;
+}
+
+/**
+ * Loads the newest valid record of the area, if any. The data keeps
+ * what it had otherwise, set the defaults before
+ * @param  uint16_t start         First EEPROM address
+ * @param  uint16_t length        Bytes of EEPROM to use
+ * @return bool                   True if a record has been loaded
+ */
+bool Settings::begin(uint16_t start, uint16_t length) {
+
+  _start = start;
+  _slots = length / SETTINGS_RECORD(_size);
+
+  // newest valid record, sequences compared wrapping around
+  bool found = false;
+  for (uint16_t slot=0; slot<_slots; slot++) {
+    uint16_t sequence;
+    if (!_valid(slot, &sequence)) continue;
+    if (!found || ((int16_t) (sequence - _sequence) > 0)) {
+      found = true;
+      _slot = slot;
+      _sequence = sequence;
+    }
+  }
+
+  if (found) {
+    uint16_t address = _address(_slot) + SETTINGS_HEADER;
+    for (uint8_t i=0; i<_size; i++) _data[i] = EEPROM.read(address + i);
+  } else {
+    _slot = _slots - 1;
+    _sequence = 0;
+  }
+  return found;
+
+}
+
+uint16_t Settings::_address(uint16_t slot) {
+  return _start + slot * SETTINGS_RECORD(_size);
+}
+
+bool Settings::_valid(uint16_t slot, uint16_t * sequence) {
+  uint16_t address = _address(slot);
+  if (EEPROM.read(address) != _version) return false;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i=0; i<SETTINGS_HEADER + _size; i++) crc = Settings::crc(crc, EEPROM.read(address + i));
+  uint16_t stored = EEPROM.read(address + SETTINGS_HEADER + _size);
+  stored |= (uint16_t) EEPROM.read(address + SETTINGS_HEADER + _size + 1) << 8;
+  if (crc != stored) return false;
+  *sequence = EEPROM.read(address + 1) | ((uint16_t) EEPROM.read(address + 2) << 8);
+  return true;
+}
+
+/**
+ * Flags the settings as changed, they are written once they have been
+ * quiet for a while
+ */
+void Settings::save() {
+  _dirty = true;
+  _changedAt = millis();
+}
+
+// Byte of the record being written, the data is read as it goes
+uint8_t Settings::_byte(uint8_t position) {
+  if (position == 0) return _version;
+  if (position == 1) return _sequence;
+  if (position == 2) return _sequence >> 8;
+  if (position < SETTINGS_HEADER + _size) return _data[position - SETTINGS_HEADER];
+  if (position == SETTINGS_HEADER + _size) return _crc;
+  return _crc >> 8;
+}
+
+/**
+ * Writes the next byte of a pending record if the EEPROM is ready.
+ * The CRC covers the bytes actually written, so changes while writing
+ * leave a valid record and another one pending
+ * @return bool       True while writing
+ */
+bool Settings::loop() {
+
+  if (_position == 0) {
+    if (!_dirty || (millis() - _changedAt < _quiet)) return false;
+    _dirty = false;
+    _slot = (_slot + 1) % _slots;
+    _sequence++;
+    _crc = 0xFFFF;
+  }
+
+  #ifdef __AVR__
+    if (!eeprom_is_ready()) return true;
+  #endif
+
+  uint8_t value = _byte(_position);
+  if (_position < SETTINGS_HEADER + _size) _crc = crc(_crc, value);
+  EEPROM.update(_address(_slot) + _position, value);
+
+  if (++_position == SETTINGS_RECORD(_size)) {
+    _position = 0;
+    _writes++;
+    return false;
+  }
+  return true;
+
+}
+
+/**
+ * Whether there are changes not written yet
+ */
+bool Settings::pending() {
+  return _dirty || (_position > 0);
+}
+
+uint16_t Settings::slot() {
+  return _slot;
+}
+
+unsigned long Settings::writes() {
+  return _writes;
+}
+
+/**
+ * CRC-16/CCITT, one byte at a time
+ * @param  uint16_t crc           CRC so far, 0xFFFF to start
+ * @param  uint8_t data           Next byte
+ */
+uint16_t Settings::crc(uint16_t crc, uint8_t data) {
+  crc ^= (uint16_t) data << 8;
+  for (uint8_t i=0; i<8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
@@ -0,0 +1,78 @@
+/*
+
+  Wear leveled settings store
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _SETTINGS_h
+#define _SETTINGS_h
+
+// Record: version, 16 bit sequence, data, 16 bit CRC of all the rest
+#define SETTINGS_HEADER 3
+#define SETTINGS_CRC 2
+#define SETTINGS_RECORD(size) (SETTINGS_HEADER + (size) + SETTINGS_CRC)
+
+// Milliseconds without changes before a record is written
+#define SETTINGS_QUIET 5000
+
+/**
+ * Keeps a block of settings in EEPROM. Every save goes to the next
+ * slot with a higher sequence, so the writes spread over the whole
+ * area, and a record torn by a reset fails its CRC and the previous
+ * one is used. Saves are deferred until the settings have been quiet
+ * for a while and then written one byte per loop(), the EEPROM takes
+ * ~3.3ms per byte
+ */
+class Settings {
+
+  private:
+
+    uint8_t * _data;
+    uint8_t _size;
+    uint8_t _version;
+    unsigned long _quiet;
+
+    uint16_t _start;
+    uint16_t _slots;
+    uint16_t _slot;             // last slot written
+    uint16_t _sequence;
+
+    bool _dirty;
+    unsigned long _changedAt;
+    uint8_t _position;          // byte being written, 0 when idle
+    uint16_t _crc;
+    unsigned long _writes;
+
+    uint16_t _address(uint16_t slot);
+    uint8_t _byte(uint8_t position);
+    bool _valid(uint16_t slot, uint16_t * sequence);
+
+  public:
+
+    Settings(void * data, uint8_t size, uint8_t version, unsigned long quiet = SETTINGS_QUIET);
+    bool begin(uint16_t start, uint16_t length);
+    void save();
+    bool loop();
+    bool pending();
+    uint16_t slot();
+    unsigned long writes();
+
+    static uint16_t crc(uint16_t crc, uint8_t data);
+
+};
+
+#endif
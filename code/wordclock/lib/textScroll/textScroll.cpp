@@ -0,0 +1,245 @@
+/*
+
+  Scrolling text
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "textScroll.h"
+
+// Columns of every glyph from FONT_FIRST to FONT_LAST, top row in bit 0
+const uint8_t text_font[(FONT_LAST - FONT_FIRST + 1) * FONT_WIDTH] PROGMEM = {
+  0x00, 0x00, 0x00, 0x00, 0x00,   // space
+  0x00, 0x00, 0x5F, 0x00, 0x00,   // !
+  0x00, 0x07, 0x00, 0x07, 0x00,   // "
+  0x14, 0x7F, 0x14, 0x7F, 0x14,   // #
+  0x24, 0x2A, 0x7F, 0x2A, 0x12,   // $
+  0x23, 0x13, 0x08, 0x64, 0x62,   // %
+  0x36, 0x49, 0x55, 0x22, 0x50,   // &
+  0x00, 0x05, 0x03, 0x00, 0x00,   // '
+  0x00, 0x1C, 0x22, 0x41, 0x00,   // (
+  0x00, 0x41, 0x22, 0x1C, 0x00,   // )
+  0x08, 0x2A, 0x1C, 0x2A, 0x08,   // *
+  0x08, 0x08, 0x3E, 0x08, 0x08,   // +
+  0x00, 0x50, 0x30, 0x00, 0x00,   // ,
+  0x08, 0x08, 0x08, 0x08, 0x08,   // -
+  0x00, 0x60, 0x60, 0x00, 0x00,   // .
+  0x20, 0x10, 0x08, 0x04, 0x02,   // /
+  0x3E, 0x51, 0x49, 0x45, 0x3E,   // 0
+  0x00, 0x42, 0x7F, 0x40, 0x00,   // 1
+  0x42, 0x61, 0x51, 0x49, 0x46,   // 2
+  0x21, 0x41, 0x45, 0x4B, 0x31,   // 3
+  0x18, 0x14, 0x12, 0x7F, 0x10,   // 4
+  0x27, 0x45, 0x45, 0x45, 0x39,   // 5
+  0x3C, 0x4A, 0x49, 0x49, 0x30,   // 6
+  0x01, 0x71, 0x09, 0x05, 0x03,   // 7
+  0x36, 0x49, 0x49, 0x49, 0x36,   // 8
+  0x06, 0x49, 0x49, 0x29, 0x1E,   // 9
+  0x00, 0x36, 0x36, 0x00, 0x00,   // :
+  0x00, 0x56, 0x36, 0x00, 0x00,   // ;
+  0x08, 0x14, 0x22, 0x41, 0x00,   // <
+  0x14, 0x14, 0x14, 0x14, 0x14,   // =
+  0x00, 0x41, 0x22, 0x14, 0x08,   // >
+  0x02, 0x01, 0x51, 0x09, 0x06,   // ?
+  0x32, 0x49, 0x79, 0x41, 0x3E,   // @
+  0x7E, 0x11, 0x11, 0x11, 0x7E,   // A
+  0x7F, 0x49, 0x49, 0x49, 0x36,   // B
+  0x3E, 0x41, 0x41, 0x41, 0x22,   // C
+  0x7F, 0x41, 0x41, 0x22, 0x1C,   // D
+  0x7F, 0x49, 0x49, 0x49, 0x41,   // E
+  0x7F, 0x09, 0x09, 0x09, 0x01,   // F
+  0x3E, 0x41, 0x49, 0x49, 0x7A,   // G
+  0x7F, 0x08, 0x08, 0x08, 0x7F,   // H
+  0x00, 0x41, 0x7F, 0x41, 0x00,   // I
+  0x20, 0x40, 0x41, 0x3F, 0x01,   // J
+  0x7F, 0x08, 0x14, 0x22, 0x41,   // K
+  0x7F, 0x40, 0x40, 0x40, 0x40,   // L
+  0x7F, 0x02, 0x0C, 0x02, 0x7F,   // M
+  0x7F, 0x04, 0x08, 0x10, 0x7F,   // N
+  0x3E, 0x41, 0x41, 0x41, 0x3E,   // O
+  0x7F, 0x09, 0x09, 0x09, 0x06,   // P
+  0x3E, 0x41, 0x51, 0x21, 0x5E,   // Q
+  0x7F, 0x09, 0x19, 0x29, 0x46,   // R
+  0x46, 0x49, 0x49, 0x49, 0x31,   // S
+  0x01, 0x01, 0x7F, 0x01, 0x01,   // T
+  0x3F, 0x40, 0x40, 0x40, 0x3F,   // U
+  0x1F, 0x20, 0x40, 0x20, 0x1F,   // V
+  0x3F, 0x40, 0x38, 0x40, 0x3F,   // W
+  0x63, 0x14, 0x08, 0x14, 0x63,   // X
+  0x07, 0x08, 0x70, 0x08, 0x07,   // Y
+  0x61, 0x51, 0x49, 0x45, 0x43,   // Z
+  0x00, 0x7F, 0x41, 0x41, 0x00,   // [
+  0x02, 0x04, 0x08, 0x10, 0x20,   // backslash
+  0x00, 0x41, 0x41, 0x7F, 0x00,   // ]
+  0x04, 0x02, 0x01, 0x02, 0x04,   // ^
+  0x40, 0x40, 0x40, 0x40, 0x40,   // _
+  0x00, 0x01, 0x02, 0x04, 0x00,   // `
+  0x20, 0x54, 0x54, 0x54, 0x78,   // a
+  0x7F, 0x48, 0x44, 0x44, 0x38,   // b
+  0x38, 0x44, 0x44, 0x44, 0x20,   // c
+  0x38, 0x44, 0x44, 0x48, 0x7F,   // d
+  0x38, 0x54, 0x54, 0x54, 0x18,   // e
+  0x08, 0x7E, 0x09, 0x01, 0x02,   // f
+  0x0C, 0x52, 0x52, 0x52, 0x3E,   // g
+  0x7F, 0x08, 0x04, 0x04, 0x78,   // h
+  0x00, 0x44, 0x7D, 0x40, 0x00,   // i
+  0x20, 0x40, 0x44, 0x3D, 0x00,   // j
+  0x7F, 0x10, 0x28, 0x44, 0x00,   // k
+  0x00, 0x41, 0x7F, 0x40, 0x00,   // l
+  0x7C, 0x04, 0x18, 0x04, 0x78,   // m
+  0x7C, 0x08, 0x04, 0x04, 0x78,   // n
+  0x38, 0x44, 0x44, 0x44, 0x38,   // o
+  0x7C, 0x14, 0x14, 0x14, 0x08,   // p
+  0x08, 0x14, 0x14, 0x18, 0x7C,   // q
+  0x7C, 0x08, 0x04, 0x04, 0x08,   // r
+  0x48, 0x54, 0x54, 0x54, 0x20,   // s
+  0x04, 0x3F, 0x44, 0x40, 0x20,   // t
+  0x3C, 0x40, 0x40, 0x20, 0x7C,   // u
+  0x1C, 0x20, 0x40, 0x20, 0x1C,   // v
+  0x3C, 0x40, 0x30, 0x40, 0x3C,   // w
+  0x44, 0x28, 0x10, 0x28, 0x44,   // x
+  0x0C, 0x50, 0x50, 0x50, 0x3C,   // y
+  0x44, 0x64, 0x54, 0x4C, 0x44,   // z
+  0x00, 0x08, 0x36, 0x41, 0x00,   // {
+  0x00, 0x00, 0x7F, 0x00, 0x00,   // |
+  0x00, 0x41, 0x36, 0x08, 0x00,   // }
+  0x10, 0x08, 0x08, 0x10, 0x08    // ~
+};
+
+/**
+ * Leds of a column of a character, top row in bit 0
+ * @param  uint8_t index          Character in the text
+ * @param  uint8_t x              Glyph column, 0 to FONT_WIDTH - 1
+ */
+uint8_t TextScroll::_glyph(uint8_t index, uint8_t x) {
+  uint8_t c = _text[index];
+  if ((c < FONT_FIRST) || (c > FONT_LAST)) c = FONT_MISSING;
+  return pgm_read_byte(&text_font[(c - FONT_FIRST) * FONT_WIDTH + x]);
+}
+
+TextScroll::TextScroll(char * buffer, uint8_t size) {
+  _text = buffer;
+  _size = size;
+  _length = 0;
+}
+
+/**
+ * Sets the pace, the text stays empty until set
+ * @param  unsigned long period   Milliseconds per column
+ */
+void TextScroll::begin(unsigned long period) {
+  _period = period;
+  _length = 0;
+  _started = millis();
+}
+
+/**
+ * Copies a text to scroll, what does not fit the buffer is cut
+ * @param  const char * text      Text, not null terminated
+ * @param  uint8_t length         Characters
+ * @return uint8_t                Characters kept
+ */
+uint8_t TextScroll::set(const char * text, uint8_t length) {
+  _length = length < _size ? length : _size;
+  for (uint8_t i=0; i<_length; i++) _text[i] = text[i];
+  return _length;
+}
+
+/**
+ * Copies a text stored in flash, what does not fit the buffer is cut
+ * @param  const __FlashStringHelper * text   Null terminated text
+ * @return uint8_t                            Characters kept
+ */
+uint8_t TextScroll::set(const __FlashStringHelper * text) {
+  const char * p = (const char *) text;
+  _length = 0;
+  char c;
+  while ((_length < _size) && ((c = pgm_read_byte(p++)) != 0)) {
+    _text[_length++] = c;
+  }
+  return _length;
+}
+
+/**
+ * Starts scrolling, the text enters from the right edge
+ * @param  unsigned long now      Current millis()
+ */
+void TextScroll::start(unsigned long now) {
+  _started = now;
+}
+
+/**
+ * Text column on the left edge, in 1/256 column. Negative while the
+ * text has not reached the left edge yet, it stops once it has left.
+ * The time is clamped there too, shifted by 8 it would wrap after
+ * 4.6 hours and show the text again
+ * @param  unsigned long now      Current millis()
+ * @return long                   Column << 8 | fraction
+ */
+long TextScroll::position(unsigned long now) {
+  unsigned long elapsed = now - _started;
+  unsigned long end = (unsigned long) (columns() + TEXT_WIDTH) * _period;
+  if (elapsed > end) elapsed = end;
+  return (long) ((elapsed << 8) / _period) - ((long) TEXT_WIDTH << 8);
+}
+
+/**
+ * Columns the whole text takes, blank ones included
+ */
+int TextScroll::columns() {
+  return (int) _length * TEXT_ADVANCE;
+}
+
+/**
+ * Whether the text has left the matrix
+ * @param  unsigned long now      Current millis()
+ */
+bool TextScroll::done(unsigned long now) {
+  return (position(now) >> 8) >= columns();
+}
+
+/**
+ * ORs the TEXT_WIDTH columns starting at a text column into a pattern,
+ * column by column, only the lit leds of every column are visited
+ * @param  text_row_t * rows      FONT_HEIGHT rows, the top one first
+ * @param  int column             Text column on the left edge
+ */
+void TextScroll::draw(text_row_t * rows, int column) {
+
+  // character and column within it, walked along without dividing
+  int index = column / TEXT_ADVANCE;
+  int x = column - index * TEXT_ADVANCE;
+  if (x < 0) {
+    index--;
+    x += TEXT_ADVANCE;
+  }
+
+  for (uint8_t i=0; i<TEXT_WIDTH; i++) {
+    if ((index >= 0) && (index < _length) && (x < FONT_WIDTH)) {
+      uint8_t bits = _glyph(index, x);
+      text_row_t mask = (text_row_t) 1 << (TEXT_WIDTH - 1 - i);
+      for (; bits > 0; bits &= bits - 1) {
+        rows[__builtin_ctz(bits)] |= mask;
+      }
+    }
+    if (++x == TEXT_ADVANCE) {
+      x = 0;
+      index++;
+    }
+  }
+
+}
@@ -0,0 +1,86 @@
+/*
+
+  Scrolling text
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _TEXT_SCROLL_h
+#define _TEXT_SCROLL_h
+
+#ifndef TEXT_WIDTH
+#define TEXT_WIDTH 16
+#endif
+
+// Text patterns are one mask per font row, bit x is column
+// TEXT_WIDTH - 1 - x, as the word masks of the languages
+#if TEXT_WIDTH <= 8
+typedef uint8_t text_row_t;
+#elif TEXT_WIDTH <= 16
+typedef uint16_t text_row_t;
+#elif TEXT_WIDTH <= 32
+typedef uint32_t text_row_t;
+#elif TEXT_WIDTH <= 64
+typedef uint64_t text_row_t;
+#else
+#error "TEXT_WIDTH must be 64 or less"
+#endif
+
+// 5x7 font in flash, a byte per column with the top row in bit 0,
+// printable ASCII only, anything else shows as FONT_MISSING
+#define FONT_WIDTH 5
+#define FONT_HEIGHT 7
+#define FONT_FIRST ' '
+#define FONT_LAST '~'
+#define FONT_MISSING '?'
+
+// Columns taken by a character, the glyph and a blank one
+#define TEXT_ADVANCE (FONT_WIDTH + 1)
+
+/**
+ * Scrolls a line of text from the right edge to the left one at a
+ * constant pace. The position has 1/256 column resolution so the
+ * caller can blend between two columns and move smoothly at any
+ * frame rate. The text lives in a buffer owned by the caller
+ */
+class TextScroll {
+
+  private:
+
+    char * _text;
+    uint8_t _size;
+    uint8_t _length;
+
+    unsigned long _period;
+    unsigned long _started;
+
+    uint8_t _glyph(uint8_t index, uint8_t x);
+
+  public:
+
+    TextScroll(char * buffer, uint8_t size);
+    void begin(unsigned long period);
+    uint8_t set(const char * text, uint8_t length);
+    uint8_t set(const __FlashStringHelper * text);
+    void start(unsigned long now);
+    long position(unsigned long now);
+    int columns();
+    bool done(unsigned long now);
+    void draw(text_row_t * rows, int column);
+
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+
+  Cached time source backed by a real time clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "timeSource.h"
+
+TimeSource::TimeSource(time_read_t read, time_write_t write) {
+  _read = read;
+  _write = write;
+  _useTicks = false;
+  _ticks = 0;
+  _base = _baseMillis = _readMillis = _last = 0;
+  _resync = TIME_RESYNC_MILLIS;
+  _reads = _rejected = 0;
+  _drift = _jump = 0;
+  _jumped = false;
+}
+
+/**
+ * Reads the RTC and starts extrapolating from it
+ * @param  bool useTicks          Advance on tick() calls (1Hz square wave)
+ *                                instead of millis()
+ * @param  unsigned long resync   Milliseconds between RTC reads, 0 for default
+ */
+void TimeSource::begin(bool useTicks, unsigned long resync) {
+  _useTicks = useTicks;
+  if (resync > 0) {
+    _resync = resync;
+  } else {
+    _resync = useTicks ? TIME_RESYNC_TICKS : TIME_RESYNC_MILLIS;
+  }
+  _reads++;
+  _sync(_read());
+  _readMillis = _baseMillis;
+  _last = _base;
+  _drift = 0;
+  _jumped = false;
+}
+
+/**
+ * Time elapsed since the last sync added to the last RTC reading
+ */
+unsigned long TimeSource::_estimate() {
+  if (_useTicks) {
+    noInterrupts();
+    unsigned int ticks = _ticks;
+    interrupts();
+    return _base + ticks;
+  }
+  return _base + (millis() - _baseMillis) / 1000;
+}
+
+void TimeSource::_sync(unsigned long time) {
+  noInterrupts();
+  _ticks = 0;
+  interrupts();
+  _base = time;
+  _baseMillis = millis();
+}
+
+/**
+ * Returns current unix time without talking to the RTC. It does not go
+ * back for the few seconds a resync may find the estimate ahead, it
+ * holds until the RTC catches up instead
+ */
+unsigned long TimeSource::now() {
+  unsigned long time = _estimate();
+  if ((long) (time - _last) > 0) _last = time;
+  return _last;
+}
+
+/**
+ * Reads the RTC again if a resync is due
+ * @return bool       True if the RTC has been read
+ */
+bool TimeSource::loop() {
+  if (millis() - _readMillis < _resync) return false;
+  resync();
+  return true;
+}
+
+/**
+ * Writes the time to the RTC and restarts extrapolating from it
+ */
+void TimeSource::adjust(unsigned long time) {
+  _write(time);
+  _sync(time);
+  _readMillis = _baseMillis;
+  _last = time;
+  _jumped = false;
+}
+
+/**
+ * Reads the RTC and records how far the estimate had drifted. An
+ * estimate that agrees keeps its base, and with it the fraction of
+ * second elapsed, so that frequent resyncs don't slow the time down.
+ * An invalid read is rejected, and so is a jump until the next read
+ * confirms it: a garbage read must not freeze the clock on a time
+ * years ahead. A confirmed jump back is taken at once
+ */
+void TimeSource::resync() {
+
+  unsigned long estimate = _estimate();
+  unsigned long time = _read();
+  _reads++;
+  _readMillis = millis();
+
+  long drift = (long) (time - estimate);
+  bool jump = labs(drift) > TIME_RESYNC_JUMP;
+  bool confirmed = _jumped && (labs(drift - _jump) <= 1);
+  if ((time == TIME_INVALID) || (jump && !confirmed)) {
+    _rejected++;
+    _jumped = (time != TIME_INVALID);
+    _jump = drift;
+    if (_resync > TIME_RESYNC_RETRY) _readMillis -= _resync - TIME_RESYNC_RETRY;
+    return;
+  }
+
+  _jumped = false;
+  _drift = drift;
+  if (_drift != 0) _sync(time);
+  if (_drift < -TIME_RESYNC_JUMP) _last = time;
+
+}
+
+/**
+ * Advances one second, to be called from the square wave interrupt
+ */
+void TimeSource::tick() {
+  _ticks++;
+}
+
+/**
+ * Number of RTC reads so far
+ */
+unsigned long TimeSource::reads() {
+  return _reads;
+}
+
+/**
+ * RTC reads rejected as invalid or as an unconfirmed jump
+ */
+unsigned long TimeSource::rejected() {
+  return _rejected;
+}
+
+/**
+ * Seconds the estimate was behind the RTC on the last resync
+ */
+long TimeSource::drift() {
+  return _drift;
+}
@@ -0,0 +1,76 @@
+/*
+
+  Cached time source backed by a real time clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _TIME_SOURCE_h
+#define _TIME_SOURCE_h
+
+#define TIME_RESYNC_MILLIS 60000
+#define TIME_RESYNC_TICKS 3600000
+
+// A read further than TIME_RESYNC_JUMP seconds from the estimate is only
+// taken once another one TIME_RESYNC_RETRY ms later agrees with it
+#define TIME_RESYNC_JUMP 5
+#define TIME_RESYNC_RETRY 1000
+
+// What the read backend returns when the RTC gave no valid time
+#define TIME_INVALID 0
+
+// Backend to read and write the RTC as unix time
+typedef unsigned long(*time_read_t)();
+typedef void(*time_write_t)(unsigned long time);
+
+class TimeSource {
+
+    private:
+
+        time_read_t _read;
+        time_write_t _write;
+        bool _useTicks;
+        volatile unsigned int _ticks;
+        unsigned long _base;
+        unsigned long _baseMillis;
+        unsigned long _readMillis;
+        unsigned long _last;
+        unsigned long _resync;
+        unsigned long _reads;
+        unsigned long _rejected;
+        long _drift;
+        long _jump;                 // drift of the last read rejected
+        bool _jumped;
+
+        unsigned long _estimate();
+        void _sync(unsigned long time);
+
+    public:
+
+        TimeSource(time_read_t read, time_write_t write);
+        void begin(bool useTicks = false, unsigned long resync = 0);
+        unsigned long now();
+        void adjust(unsigned long time);
+        bool loop();
+        void resync();
+        void tick();
+        unsigned long reads();
+        unsigned long rejected();
+        long drift();
+
+};
+
+#endif
@@ -18,169 +18,126 @@
 
 */
 
+// Generated by tools/langc.py from languages/castellano.lang, do not edit
+
 #include <Arduino.h>
-#include "wordclock.h"
+#include "language.h"
 #include "castellano.h"
 
-void loadLanguageCastellano(byte hour, byte minute, unsigned int * matrix) {
-
-  /*
-
-  00 => en punto
-  01 => pasada/s
-  02 => pasada/s
-
-  03 => casi y cinco
-  04 => casi y cinco
-  05 => y cinco
-  06 => y cinco pasadas
-  07 => y cinco pasadas
-
-  08 => casi y diez
-  09 => casi y diez
-  10 => y diez
-  11 => y diez pasadas
-  12 => y diez pasadas
-
-  13 => casi y cuarto
-  14 => casi y cuarto
-  15 => y cuarto
-  16 => y cuarto pasadas
-  17 => y cuarto pasadas
-
-  18 => casi y veinte
-  19 => casi y veinte
-  20 => y veinte
-  21 => y veinte pasadas
-  22 => y veinte pasadas
-
-  23 => casi y veinticinco
-  24 => casi y veinticinco
-  25 => y veinticinco
-  26 => y veinticinco pasadas
-  27 => y veinticinco pasadas
-
-  28 => casi y media
-  29 => casi y media
-  30 => y media
-  31 => y media pasadas
-  32 => y media pasadas
-
-  33 => casi menos veinticinco
-  34 => casi menos veinticinco
-  35 => menos veinticinco
-  36 => menos veinticinco pasadas
-  37 => menos veinticinco pasadas
-
-  38 => casi menos veinte
-  39 => casi menos veinte
-  40 => menos veinte
-  41 => menos veinte pasadas
-  42 => menos veinte pasadas
-
-  43 => casi menos cuarto
-  44 => casi menos cuarto
-  45 => menos cuarto
-  46 => menos cuarto pasadas
-  47 => menos cuarto pasadas
-
-  48 => casi menos diez
-  49 => casi menos diez
-  50 => menos diez
-  51 => menos diez pasadas
-  52 => menos diez pasadas
-
-  53 => casi menos cinco
-  54 => casi menos cinco
-  55 => menos cinco
-  56 => menos cinco pasadas
-  57 => menos cinco pasadas
-
-  58 => casi
-  59 => casi
-
-  */
-
-  // indica si la hora se referencia a la actual o a la posterior
-  bool hour_is_current = (minute < 33);
-
-  // hora en formato 12 y referida
-  byte hour_12 = (hour > 12) ? hour - 12 : hour;
-  if (!hour_is_current) hour_12++;
-  if (hour_12 == 13) hour_12 = 1;
-
-  // indica si la hora es plural o singular
-  bool hour_is_singular = (hour_12 == 1);
-
-  // ARTICLE
-  if (hour_is_singular) {
-    loadCode((clockword) ESP_ES, matrix);
-    loadCode((clockword) ESP_LA, matrix);
-  } else {
-    loadCode((clockword) ESP_SON, matrix);
-    loadCode((clockword) ESP_LAS, matrix);
-  }
-
-  // BLOCKS
-  byte reference = ((minute + 2) / 5) % 12;
-  byte index = (minute + 2) % 5;
-  if (reference == 0) {
-    // NOP
-  } else if (reference < 7) {
-    loadCode((clockword) ESP_Y, matrix);
-  } else {
-    loadCode((clockword) ESP_MENOS, matrix);
-  }
-  if (reference ==  1) loadCode((clockword) ESP_CINCO_B, matrix);
-  if (reference ==  2) loadCode((clockword) ESP_DIEZ_B, matrix);
-  if (reference ==  3) loadCode((clockword) ESP_CUARTO, matrix);
-  if (reference ==  4) loadCode((clockword) ESP_VEINTE, matrix);
-  if (reference ==  5) loadCode((clockword) ESP_VEINTICINCO, matrix);
-  if (reference ==  6) loadCode((clockword) ESP_MEDIA, matrix);
-  if (reference ==  7) loadCode((clockword) ESP_VEINTICINCO, matrix);
-  if (reference ==  8) loadCode((clockword) ESP_VEINTE, matrix);
-  if (reference ==  9) loadCode((clockword) ESP_CUARTO, matrix);
-  if (reference == 10) loadCode((clockword) ESP_DIEZ_B, matrix);
-  if (reference == 11) loadCode((clockword) ESP_CINCO_B, matrix);
-
-  // MODIFIERS
-  if (index < 2) loadCode((clockword) ESP_CASI, matrix);
-  if (index > 2) {
-    if (hour_is_singular) {
-      loadCode((clockword) ESP_PASADA, matrix);
-    } else {
-      loadCode((clockword) ESP_PASADAS, matrix);
-    }
-  }
-  if (minute == 0) loadCode((clockword) ESP_EN_PUNTO, matrix);
-
-  // HORAS
-  switch (hour_12) {
-    case  1: loadCode((clockword) ESP_UNA, matrix); break;
-    case  2: loadCode((clockword) ESP_DOS, matrix); break;
-    case  3: loadCode((clockword) ESP_TRES, matrix); break;
-    case  4: loadCode((clockword) ESP_CUATRO, matrix); break;
-    case  5: loadCode((clockword) ESP_CINCO, matrix); break;
-    case  6: loadCode((clockword) ESP_SEIS, matrix); break;
-    case  7: loadCode((clockword) ESP_SIETE, matrix); break;
-    case  8: loadCode((clockword) ESP_OCHO, matrix); break;
-    case  9: loadCode((clockword) ESP_NUEVE, matrix); break;
-    case 10: loadCode((clockword) ESP_DIEZ, matrix); break;
-    case 11: loadCode((clockword) ESP_ONCE, matrix); break;
-    default: loadCode((clockword) ESP_DOCE, matrix); break;
-  }
-
-  // FRANJA HORARIA
-  loadCode((clockword) ESP_DE_F, matrix);
-  loadCode((clockword) ESP_LA_F, matrix);
-  if (hour < 6) {
-    loadCode((clockword) ESP_NOCHE, matrix);
-  } else if (hour < 13) {
-    loadCode((clockword) ESP_MANANA, matrix);
-  } else if (hour < 21) {
-    loadCode((clockword) ESP_TARDE, matrix);
-  } else {
-    loadCode((clockword) ESP_NOCHE, matrix);
-  }
-
-}
+// Words that depend on the minutes, in singular and plural form
+#define ESP_M_VERB        (1UL << 0)
+#define ESP_M_ARTICLE     (1UL << 1)
+#define ESP_M_EN_PUNTO    (1UL << 2)
+#define ESP_M_PASADA      (1UL << 3)
+#define ESP_M_CASI        (1UL << 4)
+#define ESP_M_Y           (1UL << 5)
+#define ESP_M_MENOS       (1UL << 6)
+#define ESP_M_CINCO_B     (1UL << 7)
+#define ESP_M_DIEZ_B      (1UL << 8)
+#define ESP_M_CUARTO      (1UL << 9)
+#define ESP_M_VEINTE      (1UL << 10)
+#define ESP_M_VEINTICINCO (1UL << 11)
+#define ESP_M_MEDIA       (1UL << 12)
+#define ESP_WORDS         13
+
+const clockword castellano_words[ESP_WORDS][2] PROGMEM = {
+  { ESP_ES, ESP_SON },
+  { ESP_LA, ESP_LAS },
+  { ESP_EN_PUNTO, ESP_EN_PUNTO },
+  { ESP_PASADA, ESP_PASADAS },
+  { ESP_CASI, ESP_CASI },
+  { ESP_Y, ESP_Y },
+  { ESP_MENOS, ESP_MENOS },
+  { ESP_CINCO_B, ESP_CINCO_B },
+  { ESP_DIEZ_B, ESP_DIEZ_B },
+  { ESP_CUARTO, ESP_CUARTO },
+  { ESP_VEINTE, ESP_VEINTE },
+  { ESP_VEINTICINCO, ESP_VEINTICINCO },
+  { ESP_MEDIA, ESP_MEDIA }
+};
+
+const unsigned long castellano_minutes[60] PROGMEM = {
+  /* 00 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_EN_PUNTO, // en punto
+  /* 01 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA, // pasada/s
+  /* 02 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA, // pasada/s
+  /* 03 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_CINCO_B, // casi y cinco
+  /* 04 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_CINCO_B, // casi y cinco
+  /* 05 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_CINCO_B, // y cinco
+  /* 06 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_CINCO_B, // y cinco pasadas
+  /* 07 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_CINCO_B, // y cinco pasadas
+  /* 08 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_DIEZ_B, // casi y diez
+  /* 09 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_DIEZ_B, // casi y diez
+  /* 10 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_DIEZ_B, // y diez
+  /* 11 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_DIEZ_B, // y diez pasadas
+  /* 12 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_DIEZ_B, // y diez pasadas
+  /* 13 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_CUARTO, // casi y cuarto
+  /* 14 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_CUARTO, // casi y cuarto
+  /* 15 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_CUARTO, // y cuarto
+  /* 16 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_CUARTO, // y cuarto pasadas
+  /* 17 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_CUARTO, // y cuarto pasadas
+  /* 18 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_VEINTE, // casi y veinte
+  /* 19 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_VEINTE, // casi y veinte
+  /* 20 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_VEINTE, // y veinte
+  /* 21 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_VEINTE, // y veinte pasadas
+  /* 22 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_VEINTE, // y veinte pasadas
+  /* 23 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_VEINTICINCO, // casi y veinticinco
+  /* 24 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_VEINTICINCO, // casi y veinticinco
+  /* 25 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_VEINTICINCO, // y veinticinco
+  /* 26 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_VEINTICINCO, // y veinticinco pasadas
+  /* 27 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_VEINTICINCO, // y veinticinco pasadas
+  /* 28 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_MEDIA, // casi y media
+  /* 29 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_Y | ESP_M_MEDIA, // casi y media
+  /* 30 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_Y | ESP_M_MEDIA, // y media
+  /* 31 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_MEDIA, // y media pasadas
+  /* 32 */ RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_Y | ESP_M_MEDIA, // y media pasadas
+  /* 33 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_VEINTICINCO, // casi menos veinticinco
+  /* 34 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_VEINTICINCO, // casi menos veinticinco
+  /* 35 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_MENOS | ESP_M_VEINTICINCO, // menos veinticinco
+  /* 36 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_VEINTICINCO, // menos veinticinco pasadas
+  /* 37 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_VEINTICINCO, // menos veinticinco pasadas
+  /* 38 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_VEINTE, // casi menos veinte
+  /* 39 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_VEINTE, // casi menos veinte
+  /* 40 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_MENOS | ESP_M_VEINTE, // menos veinte
+  /* 41 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_VEINTE, // menos veinte pasadas
+  /* 42 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_VEINTE, // menos veinte pasadas
+  /* 43 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_CUARTO, // casi menos cuarto
+  /* 44 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_CUARTO, // casi menos cuarto
+  /* 45 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_MENOS | ESP_M_CUARTO, // menos cuarto
+  /* 46 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_CUARTO, // menos cuarto pasadas
+  /* 47 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_CUARTO, // menos cuarto pasadas
+  /* 48 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_DIEZ_B, // casi menos diez
+  /* 49 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_DIEZ_B, // casi menos diez
+  /* 50 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_MENOS | ESP_M_DIEZ_B, // menos diez
+  /* 51 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_DIEZ_B, // menos diez pasadas
+  /* 52 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_DIEZ_B, // menos diez pasadas
+  /* 53 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_CINCO_B, // casi menos cinco
+  /* 54 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI | ESP_M_MENOS | ESP_M_CINCO_B, // casi menos cinco
+  /* 55 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_MENOS | ESP_M_CINCO_B, // menos cinco
+  /* 56 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_CINCO_B, // menos cinco pasadas
+  /* 57 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_PASADA | ESP_M_MENOS | ESP_M_CINCO_B, // menos cinco pasadas
+  /* 58 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI, // casi
+  /* 59 */ RULE_NEXT_HOUR | RULE_AGREE | ESP_M_VERB | ESP_M_ARTICLE | ESP_M_CASI, // casi
+};
+
+// Hours in 12 hour format, position 0 is twelve
+const clockword castellano_hours[12] PROGMEM = {
+  ESP_DOCE, ESP_UNA, ESP_DOS, ESP_TRES, ESP_CUATRO, ESP_CINCO,
+  ESP_SEIS, ESP_SIETE, ESP_OCHO, ESP_NUEVE, ESP_DIEZ, ESP_ONCE
+};
+
+// Day periods, by starting hour
+const byte castellano_period_starts[4] PROGMEM = { 0, 6, 13, 21 };
+const clockword castellano_periods[4][LANGUAGE_PERIOD_WORDS] PROGMEM = {
+  { ESP_DE_F, ESP_LA_F, ESP_NOCHE },
+  { ESP_DE_F, ESP_LA_F, ESP_MANANA },
+  { ESP_DE_F, ESP_LA_F, ESP_TARDE },
+  { ESP_DE_F, ESP_LA_F, ESP_NOCHE }
+};
+
+const language_t language_castellano PROGMEM = {
+  castellano_words, ESP_WORDS, ESP_M_PASADA,
+  castellano_minutes,
+  castellano_hours,
+  NULL,
+  castellano_period_starts, castellano_periods, 4
+};
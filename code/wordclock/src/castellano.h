@@ -18,6 +18,12 @@
 
 */
 
+// Generated by tools/langc.py from languages/castellano.lang, do not edit
+
+#if (MATRIX_WIDTH != 16) || (MATRIX_HEIGHT < 16)
+#error "castellano.lang is drawn on a 16x16 stencil"
+#endif
+
 #define ESP_ES          {0, 0x0C00}
 #define ESP_SON         {0, 0x0700}
 #define ESP_CASI        {0, 0x000F}
@@ -63,5 +69,4 @@
 #define ESP_TARDE       {15, 0x03E0}
 #define ESP_NOCHE       {15, 0x001F}
 
-void loadCode(clockword code, unsigned int * matrix);
-void loadLanguageCastellano(byte hour, byte minute, unsigned int * matrix);
+extern const language_t language_castellano PROGMEM;
@@ -18,266 +18,142 @@
 
 */
 
+// Generated by tools/langc.py from languages/catalan.lang, do not edit
+
 #include <Arduino.h>
-#include "wordclock.h"
+#include "language.h"
 #include "catalan.h"
 
-void loadLanguageCatalan(byte hour, byte minute, unsigned int * matrix) {
-
-  /*
-
-  00 => en punt
-  01 => tocada/es
-  02 => tocada/es
-  03 => ben tocada/es
-  04 => ben tocada/es
-
-  05 => vora mig quart
-
-  06 => vora mig quart
-  07 => mig quart
-  08 => mig quart tocat
-  09 => vora un quart menys 5
-  10 => un quart menys 5
-  11 => un quart menys 5 tocat
-  12 => un quart menys 5 tocat
-  13 => un quart menys 5 ben tocat
-  14 => vora un quart
-  15 => un quart
-  16 => un quart tocat
-  17 => un quart tocat
-  18 => un quart ben tocat
-  19 => vora un quart i 5
-  20 => un quart i 5
-
-  21 => vora un quart i mig
-  22 => un quart i mig
-  23 => un quart i mig tocat
-  24 => vora dos quarts menys 5
-  25 => dos quarts menys 5
-  26 => dos quarts menys 5 tocats
-  27 => dos quarts menys 5 tocats
-  28 => dos quarts menys 5 ben tocats
-  29 => vora dos quarts
-  30 => dos quarts
-  31 => dos quarts tocats
-  32 => dos quarts tocats
-  33 => dos quarts ben tocats
-  34 => vora dos quarts i 5
-  35 => dos quarts i 5
-
-  36 => vora dos quarts i mig
-  37 => dos quarts i mig
-  38 => dos quarts i mig tocats
-  39 => vora tres quarts menys 5
-  40 => tres quarts menys 5
-  41 => tres quarts menys 5 tocats
-  42 => tres quarts menys 5 tocats
-  43 => tres quarts menys 5 ben tocats
-  44 => vora tres quarts
-  45 => tres quarts
-  46 => tres quarts tocats
-  47 => tres quarts tocats
-  48 => tres quarts ben tocats
-  49 => vora tres quarts i 5
-  50 => tres quarts i 5
-
-  51 => vora tres quart i mig
-  52 => tres quarts i mig
-  53 => tres quarts i mig tocats
-  54 => vora menys 5
-  55 => menys 5
-  56 => menys 5 tocats
-  57 => menys 5 tocats
-  58 => menys 5 ben tocats
-  59 => vora
-
-  */
-
-  // indica si l'hora es referencia a l'actual o la posterior
-  bool hour_is_current = (minute < 5);
-
-  // hora en format 12 i referida
-  byte hour_12 = (hour > 12) ? hour - 12 : hour;
-  if (!hour_is_current) hour_12++;
-  if (hour_12 == 13) hour_12 = 1;
-
-  // indica si l'hora va precedida de l'article (la, les) o del determinant (de, d')
-  bool hour_with_article = (minute < 5) || (minute > 58);
-
-  // indica si l'hora és plural o singular
-  bool hour_is_singular = ((5 <= minute) && (minute <= 23)) || ((minute < 5) && (hour_12 == 1));
-
-  // VERB
-  if (hour_is_singular) {
-    loadCode((clockword) CAT_ES, matrix);
-  } else {
-    loadCode((clockword) CAT_SON, matrix);
-  }
-
-  // EN PUNT
-  if (minute == 0) {
-    loadCode((clockword) CAT_EN_PUNT, matrix);
-  }
-
-  // PRIMERS MINUTS
-  if ((1 <= minute) && (minute <= 4)) {
-    if (hour_is_singular) {
-      loadCode((clockword) CAT_TOCADA, matrix);
-    } else {
-      loadCode((clockword) CAT_TOCADES, matrix);
-    }
-    if (minute > 2) {
-      loadCode((clockword) CAT_BEN, matrix);
-    }
-  }
-  if (minute == 5) {
-    loadCode((clockword) CAT_VORA, matrix);
-    loadCode((clockword) CAT_MIG, matrix);
-    loadCode((clockword) CAT_QUART, matrix);
-  }
-
-  // FRANJA DEL MIG
-  //if ((6 <= minute) && (minute <= 53)) {
-  if (6 <= minute) {
-
-    // convenient words
-    clockword tocat = (hour_is_singular) ? (clockword) CAT_TOCAT : (clockword) CAT_TOCATS;
-
-    byte quarts = (minute - 6) / 15;
-    byte index = (minute - 6) % 15;
-    if (index >= 3) quarts++;
-
-    if (quarts == 1) loadCode((clockword) CAT_UN_Q, matrix);
-    if (quarts == 2) loadCode((clockword) CAT_DOS_Q, matrix);
-    if (quarts == 3) loadCode((clockword) CAT_TRES_Q, matrix);
-    if (index < 3) {
-      if (quarts == 0) {
-        loadCode((clockword) CAT_MIG, matrix);
-      } else {
-        loadCode((clockword) CAT_I_MIG, matrix);
-      }
-    }
-    if (quarts < 2) {
-        loadCode((clockword) CAT_QUART, matrix);
-    } else if (quarts < 4) {
-        loadCode((clockword) CAT_QUARTS, matrix);
-    }
-
-    switch (index) {
-
-      case 0:
-        loadCode((clockword) CAT_VORA, matrix);
-        break;
-
-      case 2:
-        loadCode(tocat, matrix);
-        break;
-
-      case 3:
-        loadCode((clockword) CAT_VORA, matrix);
-        loadCode((clockword) CAT_MENYS, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        break;
-
-      case 4:
-        loadCode((clockword) CAT_MENYS, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        break;
-
-      case 5:
-      case 6:
-        loadCode((clockword) CAT_MENYS, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        loadCode(tocat, matrix);
-        break;
-
-      case 7:
-        loadCode((clockword) CAT_MENYS, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        loadCode((clockword) CAT_BEN_Q, matrix);
-        loadCode(tocat, matrix);
-        break;
-
-      case 8:
-        loadCode((clockword) CAT_VORA, matrix);
-        break;
-
-      case 10:
-      case 11:
-        loadCode(tocat, matrix);
-        break;
-
-      case 12:
-        loadCode((clockword) CAT_BEN_Q, matrix);
-        loadCode(tocat, matrix);
-        break;
-
-      case 13:
-        loadCode((clockword) CAT_VORA, matrix);
-        loadCode((clockword) CAT_I, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        break;
-
-      case 14:
-        loadCode((clockword) CAT_I, matrix);
-        loadCode((clockword) CAT_CINC_Q, matrix);
-        break;
-
-    }
-
-  }
-
-  // HORES
-  switch (hour_12) {
-    case  1: loadCode((clockword) CAT_UNA, matrix); break;
-    case  2: loadCode((clockword) CAT_DUES, matrix); break;
-    case  3: loadCode((clockword) CAT_TRES, matrix); break;
-    case  4: loadCode((clockword) CAT_QUATRE, matrix); break;
-    case  5: loadCode((clockword) CAT_CINC, matrix); break;
-    case  6: loadCode((clockword) CAT_SIS, matrix); break;
-    case  7: loadCode((clockword) CAT_SET, matrix); break;
-    case  8: loadCode((clockword) CAT_VUIT, matrix); break;
-    case  9: loadCode((clockword) CAT_NOU, matrix); break;
-    case 10: loadCode((clockword) CAT_DEU, matrix); break;
-    case 11: loadCode((clockword) CAT_ONZE, matrix); break;
-    default: loadCode((clockword) CAT_DOTZE, matrix); break;
-  }
-
-
-  // PARTICULES DE LES HORES
-  if (hour_with_article) {
-    if (hour_is_singular) {
-      loadCode((clockword) CAT_LA, matrix);
-    } else {
-      loadCode((clockword) CAT_LES, matrix);
-    }
-  } else {
-    if (hour_12 == 1) {
-      loadCode((clockword) CAT_D_UNA, matrix);
-    } else if (hour_12 == 11) {
-      loadCode((clockword) CAT_D_ONZE, matrix);
-    } else {
-      loadCode((clockword) CAT_DE, matrix);
-    }
-  }
-
-  // FRANJA HORARIA
-  if (hour < 6) {
-    loadCode((clockword) CAT_DE_F, matrix);
-    loadCode((clockword) CAT_LA_F, matrix);
-    loadCode((clockword) CAT_NIT, matrix);
-  } else if (hour < 13) {
-    loadCode((clockword) CAT_DEL, matrix);
-    loadCode((clockword) CAT_MATI, matrix);
-  } else if (hour < 21) {
-    loadCode((clockword) CAT_DE_F, matrix);
-    loadCode((clockword) CAT_LA_F, matrix);
-    loadCode((clockword) CAT_TARDA, matrix);
-  } else {
-    loadCode((clockword) CAT_DE_F, matrix);
-    loadCode((clockword) CAT_LA_F, matrix);
-    loadCode((clockword) CAT_NIT, matrix);
-  }
-
-}
+// Words that depend on the minutes, in singular and plural form
+#define CAT_M_VERB    (1UL << 0)
+#define CAT_M_ARTICLE (1UL << 1)
+#define CAT_M_EN_PUNT (1UL << 2)
+#define CAT_M_TOCADA  (1UL << 3)
+#define CAT_M_BEN     (1UL << 4)
+#define CAT_M_VORA    (1UL << 5)
+#define CAT_M_MIG     (1UL << 6)
+#define CAT_M_QUART   (1UL << 7)
+#define CAT_M_QUARTS  (1UL << 8)
+#define CAT_M_UN_Q    (1UL << 9)
+#define CAT_M_DOS_Q   (1UL << 10)
+#define CAT_M_TRES_Q  (1UL << 11)
+#define CAT_M_I_MIG   (1UL << 12)
+#define CAT_M_I       (1UL << 13)
+#define CAT_M_MENYS   (1UL << 14)
+#define CAT_M_CINC_Q  (1UL << 15)
+#define CAT_M_BEN_Q   (1UL << 16)
+#define CAT_M_TOCAT   (1UL << 17)
+#define CAT_WORDS     18
+
+const clockword catalan_words[CAT_WORDS][2] PROGMEM = {
+  { CAT_ES, CAT_SON },
+  { CAT_LA, CAT_LES },
+  { CAT_EN_PUNT, CAT_EN_PUNT },
+  { CAT_TOCADA, CAT_TOCADES },
+  { CAT_BEN, CAT_BEN },
+  { CAT_VORA, CAT_VORA },
+  { CAT_MIG, CAT_MIG },
+  { CAT_QUART, CAT_QUART },
+  { CAT_QUARTS, CAT_QUARTS },
+  { CAT_UN_Q, CAT_UN_Q },
+  { CAT_DOS_Q, CAT_DOS_Q },
+  { CAT_TRES_Q, CAT_TRES_Q },
+  { CAT_I_MIG, CAT_I_MIG },
+  { CAT_I, CAT_I },
+  { CAT_MENYS, CAT_MENYS },
+  { CAT_CINC_Q, CAT_CINC_Q },
+  { CAT_BEN_Q, CAT_BEN_Q },
+  { CAT_TOCAT, CAT_TOCATS }
+};
+
+const unsigned long catalan_minutes[60] PROGMEM = {
+  /* 00 */ RULE_AGREE | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_EN_PUNT, // en punt
+  /* 01 */ RULE_AGREE | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_TOCADA, // tocada/es
+  /* 02 */ RULE_AGREE | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_TOCADA, // tocada/es
+  /* 03 */ RULE_AGREE | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_TOCADA | CAT_M_BEN, // ben tocada/es
+  /* 04 */ RULE_AGREE | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_TOCADA | CAT_M_BEN, // ben tocada/es
+  /* 05 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_MIG | CAT_M_QUART, // vora mig quart
+  /* 06 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_MIG | CAT_M_QUART, // vora mig quart
+  /* 07 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MIG | CAT_M_QUART, // mig quart
+  /* 08 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MIG | CAT_M_QUART | CAT_M_TOCAT, // mig quart tocat
+  /* 09 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUART | CAT_M_UN_Q | CAT_M_MENYS | CAT_M_CINC_Q, // vora un quart menys 5
+  /* 10 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_MENYS | CAT_M_CINC_Q, // un quart menys 5
+  /* 11 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // un quart menys 5 tocat
+  /* 12 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // un quart menys 5 tocat
+  /* 13 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // un quart menys 5 ben tocat
+  /* 14 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUART | CAT_M_UN_Q, // vora un quart
+  /* 15 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q, // un quart
+  /* 16 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_TOCAT, // un quart tocat
+  /* 17 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_TOCAT, // un quart tocat
+  /* 18 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // un quart ben tocat
+  /* 19 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUART | CAT_M_UN_Q | CAT_M_I | CAT_M_CINC_Q, // vora un quart i 5
+  /* 20 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_I | CAT_M_CINC_Q, // un quart i 5
+  /* 21 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUART | CAT_M_UN_Q | CAT_M_I_MIG, // vora un quart i mig
+  /* 22 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_I_MIG, // un quart i mig
+  /* 23 */ RULE_NEXT_HOUR | RULE_SINGULAR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUART | CAT_M_UN_Q | CAT_M_I_MIG | CAT_M_TOCAT, // un quart i mig tocat
+  /* 24 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_MENYS | CAT_M_CINC_Q, // vora dos quarts menys 5
+  /* 25 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_MENYS | CAT_M_CINC_Q, // dos quarts menys 5
+  /* 26 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // dos quarts menys 5 tocats
+  /* 27 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // dos quarts menys 5 tocats
+  /* 28 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // dos quarts menys 5 ben tocats
+  /* 29 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_DOS_Q, // vora dos quarts
+  /* 30 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q, // dos quarts
+  /* 31 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_TOCAT, // dos quarts tocats
+  /* 32 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_TOCAT, // dos quarts tocats
+  /* 33 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // dos quarts ben tocats
+  /* 34 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_I | CAT_M_CINC_Q, // vora dos quarts i 5
+  /* 35 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_I | CAT_M_CINC_Q, // dos quarts i 5
+  /* 36 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_I_MIG, // vora dos quarts i mig
+  /* 37 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_I_MIG, // dos quarts i mig
+  /* 38 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_DOS_Q | CAT_M_I_MIG | CAT_M_TOCAT, // dos quarts i mig tocats
+  /* 39 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_MENYS | CAT_M_CINC_Q, // vora tres quarts menys 5
+  /* 40 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_MENYS | CAT_M_CINC_Q, // tres quarts menys 5
+  /* 41 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // tres quarts menys 5 tocats
+  /* 42 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // tres quarts menys 5 tocats
+  /* 43 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // tres quarts menys 5 ben tocats
+  /* 44 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_TRES_Q, // vora tres quarts
+  /* 45 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q, // tres quarts
+  /* 46 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_TOCAT, // tres quarts tocats
+  /* 47 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_TOCAT, // tres quarts tocats
+  /* 48 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // tres quarts ben tocats
+  /* 49 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_I | CAT_M_CINC_Q, // vora tres quarts i 5
+  /* 50 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_I | CAT_M_CINC_Q, // tres quarts i 5
+  /* 51 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_I_MIG, // vora tres quart i mig
+  /* 52 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_I_MIG, // tres quarts i mig
+  /* 53 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_QUARTS | CAT_M_TRES_Q | CAT_M_I_MIG | CAT_M_TOCAT, // tres quarts i mig tocats
+  /* 54 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_VORA | CAT_M_MENYS | CAT_M_CINC_Q, // vora menys 5
+  /* 55 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MENYS | CAT_M_CINC_Q, // menys 5
+  /* 56 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // menys 5 tocats
+  /* 57 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_TOCAT, // menys 5 tocats
+  /* 58 */ RULE_NEXT_HOUR | RULE_DETERMINER | CAT_M_VERB | CAT_M_MENYS | CAT_M_CINC_Q | CAT_M_BEN_Q | CAT_M_TOCAT, // menys 5 ben tocats
+  /* 59 */ RULE_NEXT_HOUR | CAT_M_VERB | CAT_M_ARTICLE | CAT_M_VORA, // vora
+};
+
+// Hours in 12 hour format, position 0 is twelve
+const clockword catalan_hours[12] PROGMEM = {
+  CAT_DOTZE, CAT_UNA, CAT_DUES, CAT_TRES, CAT_QUATRE, CAT_CINC,
+  CAT_SIS, CAT_SET, CAT_VUIT, CAT_NOU, CAT_DEU, CAT_ONZE
+};
+
+// Determiner of every hour
+const clockword catalan_determiners[12] PROGMEM = {
+  CAT_DE, CAT_D_UNA, CAT_DE, CAT_DE, CAT_DE, CAT_DE,
+  CAT_DE, CAT_DE, CAT_DE, CAT_DE, CAT_DE, CAT_D_ONZE
+};
+
+// Day periods, by starting hour
+const byte catalan_period_starts[4] PROGMEM = { 0, 6, 13, 21 };
+const clockword catalan_periods[4][LANGUAGE_PERIOD_WORDS] PROGMEM = {
+  { CAT_DE_F, CAT_LA_F, CAT_NIT },
+  { CAT_DEL, CAT_MATI, WORD_NONE },
+  { CAT_DE_F, CAT_LA_F, CAT_TARDA },
+  { CAT_DE_F, CAT_LA_F, CAT_NIT }
+};
+
+const language_t language_catalan PROGMEM = {
+  catalan_words, CAT_WORDS, CAT_M_TOCAT,
+  catalan_minutes,
+  catalan_hours,
+  catalan_determiners,
+  catalan_period_starts, catalan_periods, 4
+};
@@ -18,6 +18,12 @@
 
 */
 
+// Generated by tools/langc.py from languages/catalan.lang, do not edit
+
+#if (MATRIX_WIDTH != 16) || (MATRIX_HEIGHT < 16)
+#error "catalan.lang is drawn on a 16x16 stencil"
+#endif
+
 #define CAT_ES          {0, 0xC000}
 #define CAT_SON         {0, 0x7000}
 #define CAT_VORA        {0, 0x00F0}
@@ -50,8 +56,6 @@
 #define CAT_UNA         {5, 0x0007}
 #define CAT_D_UNA       {5, 0x000F}
 
-#define CAT_DOS         {6, 0xE000}
-
 #define CAT_QUATRE      {7, 0xFC00}
 #define CAT_TRES        {7, 0x1E00}
 
@@ -74,5 +78,4 @@
 #define CAT_NIT         {14, 0x0070}
 #define CAT_TARDA       {14, 0x001F}
 
-void loadCode(clockword code, unsigned int * matrix);
-void loadLanguageCatalan(byte hour, byte minute, unsigned int * matrix);
+extern const language_t language_catalan PROGMEM;
@@ -0,0 +1,152 @@
+/*
+
+  Word Clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "language.h"
+#include "catalan.h"
+#include "castellano.h"
+
+// Same order as the LANGUAGE_* indexes
+const language_t * const languages[] PROGMEM = {
+  &language_catalan,
+  &language_castellano
+};
+
+const byte languages_count = sizeof(languages) / sizeof(language_t *);
+
+/**
+ * Builds the list of words lit for the given time
+ * @param  byte language          Language index
+ * @param  byte hour              Hour, 0 to 23
+ * @param  byte minute            Minute, 0 to 59
+ * @param  sentence_t *           Sentence to fill
+ */
+void loadSentence(byte language, byte hour, byte minute, sentence_t * sentence) {
+
+  language_t lang;
+  memcpy_P(&lang, (const language_t *) pgm_read_ptr(&languages[language]), sizeof(language_t));
+
+  unsigned long rule = pgm_read_dword(&lang.minutes[minute]);
+
+  // 12h hour referred by the sentence (0 => twelve)
+  byte hour_12 = hour % 12;
+  if (rule & RULE_NEXT_HOUR) hour_12 = (hour_12 + 1) % LANGUAGE_HOURS;
+
+  // singular or plural forms
+  byte form = 1;
+  if ((rule & RULE_SINGULAR) || ((rule & RULE_AGREE) && (hour_12 == 1))) form = 0;
+
+  sentence->language = language;
+  sentence->form = form;
+  sentence->hour = hour_12;
+  sentence->period = 0;
+  sentence->count = 0;
+
+  // minute words, langc checks the longest sentence fits
+  for (byte i=0; i<lang.word_count; i++) {
+    if (rule & (1UL << i)) {
+      sentence->words[sentence->count++] = (lang.highlights & (1UL << i)) ? i | WORD_HIGHLIGHT : i;
+    }
+  }
+
+  // hour and its determiner
+  sentence->words[sentence->count++] = WORD_HOUR;
+  if ((rule & RULE_DETERMINER) && (lang.determiners != NULL)) {
+    sentence->words[sentence->count++] = WORD_DETERMINER;
+  }
+
+  // day period, the last one starting before the hour, without its empty words
+  if (lang.period_count == 0) return;
+  for (byte i=1; i<lang.period_count; i++) {
+    if (hour >= pgm_read_byte(&lang.period_starts[i])) sentence->period = i;
+  }
+  for (byte i=0; i<LANGUAGE_PERIOD_WORDS; i++) {
+    clockword word;
+    memcpy_P(&word, &lang.periods[sentence->period][i], sizeof(clockword));
+    if (word.positions > 0) sentence->words[sentence->count++] = WORD_PERIOD + i;
+  }
+
+}
+
+/**
+ * Reads a word of a sentence from flash
+ * @param  sentence_t *           Sentence
+ * @param  byte index             Word in the sentence, 0 to count - 1
+ * @param  clockword *            Word read
+ */
+void sentenceWord(const sentence_t * sentence, byte index, clockword * word) {
+
+  language_t lang;
+  memcpy_P(&lang, (const language_t *) pgm_read_ptr(&languages[sentence->language]), sizeof(language_t));
+
+  byte id = sentence->words[index] & WORD_ID;
+  const clockword * code;
+  if (id < WORD_HOUR) {
+    code = &lang.words[id][sentence->form];
+  } else if (id == WORD_HOUR) {
+    code = &lang.hours[sentence->hour];
+  } else if (id == WORD_DETERMINER) {
+    code = &lang.determiners[sentence->hour];
+  } else {
+    code = &lang.periods[sentence->period][id - WORD_PERIOD];
+  }
+  memcpy_P(word, code, sizeof(clockword));
+
+}
+
+/**
+ * Loads a word code into the time matrix
+ * @param  clockword code          a tupla defining the leds to be lit to form a word
+ * @param  row_t *                LED matrix array representation
+ */
+void loadCode(clockword code, row_t * matrix) {
+  matrix[code.row] = matrix[code.row] | code.positions;
+}
+
+/**
+ * Loads a word code stored in flash into the time matrix
+ * @param  clockword *             pointer to a PROGMEM tupla defining the word
+ * @param  row_t *                LED matrix array representation
+ */
+void loadCode_P(const clockword * code, row_t * matrix) {
+  clockword word;
+  memcpy_P(&word, code, sizeof(clockword));
+  loadCode(word, matrix);
+}
+
+/**
+ * Loads the sentence for the given time in the time matrix
+ * @param  byte language          Language index
+ * @param  byte hour              Hour, 0 to 23
+ * @param  byte minute            Minute, 0 to 59
+ * @param  row_t *                LED matrix array representation
+ */
+void loadLanguage(byte language, byte hour, byte minute, row_t * matrix) {
+
+  sentence_t sentence;
+  loadSentence(language, hour, minute, &sentence);
+
+  for (byte i=0; i<sentence.count; i++) {
+    clockword word;
+    sentenceWord(&sentence, i, &word);
+    loadCode(word, matrix);
+  }
+
+}
@@ -0,0 +1,89 @@
+/*
+
+  Word Clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _LANGUAGE_h
+#define _LANGUAGE_h
+
+#include "wordclock.h"
+
+// Each minute of a language is a rule: the low bits select minute
+// words and the high bits tell how to build the rest of the sentence
+#define RULE_NEXT_HOUR      (1UL << 28) // the hour referred is the next one
+#define RULE_SINGULAR       (1UL << 29) // words always in singular
+#define RULE_AGREE          (1UL << 30) // words in singular if the hour is one
+#define RULE_DETERMINER     (1UL << 31) // hour preceded by its determiner
+#define LANGUAGE_MAX_WORDS  28
+
+#define LANGUAGE_HOURS      12
+#define LANGUAGE_PERIOD_WORDS 3
+
+// Word ids of a sentence: the minute words are their slot, then the
+// hour, its determiner and the words of the day period
+#define WORD_HOUR           LANGUAGE_MAX_WORDS
+#define WORD_DETERMINER     (WORD_HOUR + 1)
+#define WORD_PERIOD         (WORD_DETERMINER + 1)
+#define WORD_HIGHLIGHT      0x80        // flag, the language highlights the word
+#define WORD_ID             0x7F
+#define SENTENCE_MAX_WORDS  13
+
+struct language_t {
+
+  // minute words, singular and plural forms, and the ones to highlight
+  const clockword (*words)[2];
+  byte word_count;
+  unsigned long highlights;
+
+  // one rule per minute
+  const unsigned long * minutes;
+
+  // hour words, index 0 is twelve
+  const clockword * hours;
+
+  // hour determiners (de, d'), NULL if the language has none
+  const clockword * determiners;
+
+  // day periods, each one starting at an hour of the day
+  const byte * period_starts;
+  const clockword (*periods)[LANGUAGE_PERIOD_WORDS];
+  byte period_count;
+
+};
+
+// The words lit for a time, as ids, and what is needed to find them
+// in flash. Much smaller than the pattern they light
+struct sentence_t {
+  byte language;
+  byte form;          // 0 singular, 1 plural
+  byte hour;          // 12h hour referred, 0 is twelve
+  byte period;
+  byte count;
+  byte words[SENTENCE_MAX_WORDS];
+};
+
+extern const language_t * const languages[] PROGMEM;
+extern const byte languages_count;
+
+void loadCode(clockword code, row_t * matrix);
+void loadCode_P(const clockword * code, row_t * matrix);
+void loadSentence(byte language, byte hour, byte minute, sentence_t * sentence);
+void sentenceWord(const sentence_t * sentence, byte index, clockword * word);
+void loadLanguage(byte language, byte hour, byte minute, row_t * matrix);
+
+#endif
@@ -0,0 +1,121 @@
+/*
+
+  Word Clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _LAYOUT_h
+#define _LAYOUT_h
+
+// Wiring inside a tile, rows always start at the tile's left
+#define LAYOUT_PROGRESSIVE 0      // every row left to right
+#define LAYOUT_SERPENTINE 1       // odd rows right to left
+
+// Clockwise rotation of the image on the panels
+#define LAYOUT_ROTATE_0 0
+#define LAYOUT_ROTATE_90 1
+#define LAYOUT_ROTATE_180 2
+#define LAYOUT_ROTATE_270 3
+
+// -----------------------------------------------------------------------------
+// Compile time list of indexes 0..N-1 (C++11 has no std::make_index_sequence)
+// -----------------------------------------------------------------------------
+
+template <unsigned int... I> struct layout_seq {};
+
+template <class A, class B> struct layout_cat;
+template <unsigned int... A, unsigned int... B>
+struct layout_cat<layout_seq<A...>, layout_seq<B...> > {
+  typedef layout_seq<A..., (sizeof...(A) + B)...> type;
+};
+
+template <unsigned int N> struct layout_gen {
+  typedef typename layout_cat<typename layout_gen<N / 2>::type, typename layout_gen<N - N / 2>::type>::type type;
+};
+template <> struct layout_gen<0> { typedef layout_seq<> type; };
+template <> struct layout_gen<1> { typedef layout_seq<0> type; };
+
+// Smallest type that holds a pixel index
+template <bool Small> struct layout_index { typedef uint16_t type; };
+template <> struct layout_index<true> { typedef uint8_t type; };
+
+inline uint8_t layoutRead(const uint8_t * p) { return pgm_read_byte(p); }
+inline uint16_t layoutRead(const uint16_t * p) { return pgm_read_word(p); }
+
+// -----------------------------------------------------------------------------
+// Layout
+// -----------------------------------------------------------------------------
+
+/**
+ * Maps display coordinates to the position of the led on the strip.
+ * Tiles of TileWidth x TileHeight leds are chained row by row, first
+ * tile top left. The image is mirrored first and then rotated.
+ * The whole map is computed by the compiler into a flash table, so
+ * index() is a single lookup
+ */
+template <uint8_t TileWidth, uint8_t TileHeight, uint8_t TilesX, uint8_t TilesY,
+          uint8_t Wiring, uint8_t Rotation = LAYOUT_ROTATE_0, bool Mirror = false>
+struct Layout {
+
+  static const uint8_t panelWidth = TileWidth * TilesX;
+  static const uint8_t panelHeight = TileHeight * TilesY;
+  static const bool swapped = (Rotation == LAYOUT_ROTATE_90) || (Rotation == LAYOUT_ROTATE_270);
+  static const uint8_t width = swapped ? panelHeight : panelWidth;
+  static const uint8_t height = swapped ? panelWidth : panelHeight;
+  static const unsigned int pixels = (unsigned int) panelWidth * panelHeight;
+
+  typedef typename layout_index<pixels <= 256>::type index_t;
+
+  // led in the chain for a position on the panels
+  static constexpr unsigned int wire(unsigned int px, unsigned int py) {
+    return ((py / TileHeight) * TilesX + px / TileWidth) * (TileWidth * TileHeight)
+      + (py % TileHeight) * TileWidth
+      + (((Wiring == LAYOUT_SERPENTINE) && ((py % TileHeight) & 1)) ? TileWidth - 1 - px % TileWidth : px % TileWidth);
+  }
+
+  // position on the panels for an image position, mirrored x already applied
+  static constexpr unsigned int rotate(unsigned int x, unsigned int y) {
+    return Rotation == LAYOUT_ROTATE_90 ? wire(panelWidth - 1 - y, x)
+      : Rotation == LAYOUT_ROTATE_180 ? wire(panelWidth - 1 - x, panelHeight - 1 - y)
+      : Rotation == LAYOUT_ROTATE_270 ? wire(y, panelHeight - 1 - x)
+      : wire(x, y);
+  }
+
+  static constexpr unsigned int map(unsigned int x, unsigned int y) {
+    return rotate(Mirror ? width - 1 - x : x, y);
+  }
+
+  template <class S> struct Table;
+  template <unsigned int... I> struct Table<layout_seq<I...> > {
+    static const index_t map[sizeof...(I)];
+  };
+  typedef Table<typename layout_gen<pixels>::type> table;
+
+  static inline unsigned int index(uint8_t x, uint8_t y) {
+    return layoutRead(&table::map[y * width + x]);
+  }
+
+};
+
+template <uint8_t TW, uint8_t TH, uint8_t TX, uint8_t TY, uint8_t W, uint8_t R, bool M>
+template <unsigned int... I>
+const typename Layout<TW, TH, TX, TY, W, R, M>::index_t
+Layout<TW, TH, TX, TY, W, R, M>::Table<layout_seq<I...> >::map[sizeof...(I)] PROGMEM = {
+  (typename Layout<TW, TH, TX, TY, W, R, M>::index_t) Layout<TW, TH, TX, TY, W, R, M>::map(I % Layout<TW, TH, TX, TY, W, R, M>::width, I / Layout<TW, TH, TX, TY, W, R, M>::width)...
+};
+
+#endif
@@ -18,15 +18,65 @@
 
 */
 
+#ifndef _WORDCLOCK_h
+#define _WORDCLOCK_h
+
+// Matrix size, larger panels set both in build_flags along with
+// RAIN_WIDTH, RAIN_HEIGHT and TEXT_WIDTH, e.g. -DMATRIX_WIDTH=32
+// -DRAIN_WIDTH=32 -DTEXT_WIDTH=32
+#ifndef MATRIX_WIDTH
+#define MATRIX_WIDTH 16
+#endif
+#ifndef MATRIX_HEIGHT
+#define MATRIX_HEIGHT 16
+#endif
+
+#if MATRIX_HEIGHT > 255
+#error "MATRIX_HEIGHT must fit in a byte"
+#endif
+
+// A pattern is one mask per row, bit x lights column x
+#if MATRIX_WIDTH <= 8
+typedef uint8_t row_t;
+#elif MATRIX_WIDTH <= 16
+typedef uint16_t row_t;
+#elif MATRIX_WIDTH <= 32
+typedef uint32_t row_t;
+#elif MATRIX_WIDTH <= 64
+typedef uint64_t row_t;
+#else
+#error "MATRIX_WIDTH must be 64 or less"
+#endif
+
+/**
+ * Column of the lowest lit led in a row, row must not be 0.
+ * Iterate with row &= row - 1 to visit only the lit leds
+ */
+inline byte rowFirst(row_t row) {
+  #if MATRIX_WIDTH <= 16
+    return __builtin_ctz(row);
+  #elif MATRIX_WIDTH <= 32
+    return __builtin_ctzl(row);
+  #else
+    return __builtin_ctzll(row);
+  #endif
+}
+
 struct clockword {
   byte row;
-  unsigned int positions;
+  row_t positions;
 };
 
-struct ray_struct {
-  byte x;
-  byte y;
-  byte speed;
-  byte length;
-  byte life;
+#define WORD_NONE       {0, 0}
+
+// Settings kept in EEPROM, bump the version when the layout changes
+#define SETTINGS_VERSION 1
+
+struct settings_t {
+  byte mode;
+  byte language;
+  byte color;
+  byte brightness;
 };
+
+#endif
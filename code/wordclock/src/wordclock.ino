@@ -21,51 +21,198 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <Wire.h>
 #include <EEPROM.h>
 #include <RTClib.h>
-#include <Adafruit_NeoPixel.h>
 #include "debounceEvent.h"
+#include "pinChange.h"
+#include "timeSource.h"
+#include "scheduler.h"
+#include "idle.h"
+#include "logBuffer.h"
+#include "protocol.h"
+#include "profiler.h"
+#include "memoryMonitor.h"
+#include "settings.h"
+#include "rain.h"
+#include "textScroll.h"
+#include "paletteStrip.h"
 #include "wordclock.h"
-#include "catalan.h"
-#include "castellano.h"
+#include "layout.h"
+#include "language.h"
 
 // =============================================================================
 // Configuration
 // =============================================================================
 
-#define DEBUG
-#define SERIAL_BAUD 9600
+// log messages above LOG_LEVEL compile out, levels in logBuffer.h
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#define SERIAL_BAUD 115200
+
+// stream the frames shown throu serial to tools/capture.py once asked
+// by COMMAND_CAPTURE, needs a longer log ring to fit a rain frame
+//#define CAPTURE
+
+// queued log bytes, a power of two up to 256
+#ifdef CAPTURE
+   #define LOG_BUFFER 256
+#else
+   #define LOG_BUFFER 128
+#endif
 #define DEBOUNCE_DELAY 100
 
-// matrix configuration
-#define MATRIX_WIDTH 16
-#define MATRIX_HEIGHT 16
-#define TOTAL_PIXELS MATRIX_WIDTH * MATRIX_HEIGHT
-#define DEFAULT_BRIGHTNESS 32
+// matrix configuration, MATRIX_WIDTH and MATRIX_HEIGHT live in wordclock.h
+#define TOTAL_PIXELS (MATRIX_WIDTH * MATRIX_HEIGHT)
+
+// panel wiring, see layout.h
+#define MATRIX_TILE_WIDTH 16
+#define MATRIX_TILE_HEIGHT 16
+#define MATRIX_TILES_X 1
+#define MATRIX_TILES_Y 1
+#define MATRIX_WIRING LAYOUT_SERPENTINE
+#define MATRIX_ROTATION LAYOUT_ROTATE_0
+#define MATRIX_MIRROR false
+
+// brightness is a perceived level, the button walks it in even steps
+#define BRIGHTNESS_MIN 31
+#define BRIGHTNESS_STEP 16
+#define DEFAULT_BRIGHTNESS 111
+
+// dither the levels between two led steps, the frame is then pushed
+// on every render while any color has a fraction. Off by default: a
+// show of 256 leds keeps interrupts off for 7.7ms, 40% of the time at
+// one every 20ms, so serial bytes can be lost, the CPU never sleeps
+// and the slow dither patterns flicker. Worth it on short strips only
+//#define DITHER
 
 // clock configuration
 #define TOTAL_COLORS 5
 #define DEFAULT_COLOR 3
-#define TOTAL_LANGUAGES 2
 #define LANGUAGE_CATALAN 0
 #define LANGUAGE_SPANISH 1
 
+// scheduler configuration, periods and deadlines in ms
+#define TASK_BUTTONS_PERIOD 5
+#define TASK_BUTTONS_DEADLINE 20
+#define TASK_RTC_PERIOD 1000
+#define TASK_RTC_DEADLINE 100
+#define TASK_RENDER_PERIOD UPDATE_MATRIX
+#define TASK_RENDER_DEADLINE UPDATE_MATRIX
+#define TASK_SERIAL_PERIOD 5
+#define TASK_SERIAL_DEADLINE 20
+#define TASK_EEPROM_PERIOD 5
+#define TASK_EEPROM_DEADLINE 1000
+#define TASK_MEMORY_PERIOD 1000
+#define TASK_MEMORY_DEADLINE 100
+
+// sleep between tasks until the next release or event, comment out to
+// busy loop
+#define IDLE_SLEEP
+
+// profiler sections, enable with build_flags = -DPROFILER
+#define PROFILE_BUTTONS 0
+#define PROFILE_RTC 1
+#define PROFILE_PATTERN 2
+#define PROFILE_FILL 3
+#define PROFILE_SHOW 4
+
 // matrix configuration
 #define UPDATE_MATRIX 20
-#define MATRIX_BIRTH_RATIO 75
-#define MATRIX_SPEED_MIN 4
-#define MATRIX_SPEED_MAX 2
-#define MATRIX_LENGTH_MIN 5
-#define MATRIX_LENGTH_MAX 20
-#define MATRIX_LIFE_MIN 10
-#define MATRIX_LIFE_MAX 40
 #define MATRIX_MAX_RAYS 60
+//#define MATRIX_SEED 1234   // replays the same rain on every boot
 #define STICKY_COUNT 1000
 #define STICKY_PAUSE 5000
 #define STICKY_MAX 500
 
+// matrix effect phases
+#define MATRIX_RAIN 0         // rays fall freely
+#define MATRIX_STICKY 1       // rays stop on the time leds
+#define MATRIX_CLOSING 2      // time complete, no new rays
+#define MATRIX_HOLD 3         // time shown alone for STICKY_PAUSE ms
+
+// word styles, the clock draws every word of the sentence with the
+// palette entries of its style
+#define STYLE_MINUTES 0
+#define STYLE_HOUR 1          // hour and its determiner
+#define STYLE_PERIOD 2        // day period
+#define STYLE_HIGHLIGHT 3     // minute words the language highlights
+#define TOTAL_STYLES 4
+
+// word colors as COLOR_*, 0 follows the clock color
+#define WORD_COLOR_MINUTES 0
+#define WORD_COLOR_HOUR 0
+#define WORD_COLOR_PERIOD 0
+#define WORD_COLOR_HIGHLIGHT 0
+
+// highlighted words pulse with this period in ms, down to
+// WORD_PULSE_MIN/256 of their color, comment out to keep them steady
+#define WORD_PULSE 2000
+#define WORD_PULSE_MIN 64
+
+// palette entries, the clock words, the matrix effect and the text
+// take turns on the same entries, each mode loads its own when it draws
+#define PALETTE_OFF 0
+#define PALETTE_WORD 1                                   // + style, steady words
+#define PALETTE_WORD_IN (PALETTE_WORD + TOTAL_STYLES)    // + style, words arriving
+#define PALETTE_WORD_OUT (PALETTE_WORD_IN + TOTAL_STYLES) // + style, words leaving
+#define PALETTE_TIME 2        // time assembled by the rain
+#define PALETTE_RAIN 3        // ray tip and RAIN_SHADES greens
+#define PALETTE_TEXT 1        // text leds lit in both columns blended
+#define PALETTE_TEXT_IN 2     // leds the text moves into
+#define PALETTE_TEXT_OUT 3    // leds the text leaves
+#if PALETTE_WORD_OUT + TOTAL_STYLES > PALETTE_SIZE
+   #error "The word styles do not fit in the palette"
+#endif
+#if PALETTE_RAIN + RAIN_SHADES >= PALETTE_SIZE
+   #error "The rain shades do not fit in the palette"
+#endif
+
+// minute transitions, words cross-fade during FADE_DURATION ms (0 to
+// disable) following one of the curves
+#define FADE_LINEAR 0
+#define FADE_EASE_IN 1
+#define FADE_SMOOTH 2
+#define FADE_DURATION 600
+#define FADE_CURVE FADE_SMOOTH
+
+// text mode, scrolls the date or a message received throu serial at
+// TEXT_PERIOD ms per column, blending two columns on every frame
+#define TEXT_MAX 16
+#define TEXT_PERIOD 70
+#define TEXT_TOP ((MATRIX_HEIGHT - FONT_HEIGHT) / 2)
+
+// binary commands, see protocol.h, replies carry the command with
+// COMMAND_REPLY set, failures come as COMMAND_ERROR with the command
+// and the error code. Multibyte values are little endian
+#define COMMAND_PING 0x01           // -> protocol version
+#define COMMAND_GET_TIME 0x02       // -> unix time (4)
+#define COMMAND_SET_TIME 0x03       // unix time (4) ->
+#define COMMAND_GET_SETTINGS 0x04   // -> mode, language, color, brightness
+#define COMMAND_SET_SETTINGS 0x05   // mode, language, color, brightness ->
+#define COMMAND_GET_STATS 0x06      // -> COMMAND_STATS counters (4 each)
+#define COMMAND_CAPTURE 0x07        // period ms (2), 0 stops -> width, height, row bytes
+#define COMMAND_TEXT 0x08           // text (up to TEXT_MAX) scrolled once, empty stops ->
+#define COMMAND_ERROR 0x7F
+#define COMMAND_REPLY 0x80
+#define COMMAND_VERSION 1
+#define COMMAND_PAYLOAD TEXT_MAX    // longest request, longer ones get ERROR_LENGTH
+#define COMMAND_STATS 10
+#define COMMAND_REPLY_MAX (COMMAND_STATS * 4)
+#define ERROR_UNKNOWN 1
+#define ERROR_LENGTH 2
+#define ERROR_RANGE 3
+
+// frames streamed while capturing, they start with a sequence number,
+// the low 16 bits of millis() and the brightness. The lit leds come as
+// a bitmap of the rows with any, then the mask of each of those rows
+#define CAPTURE_CLOCK 0x40          // + color (3), rows: a single color frame
+#define CAPTURE_PIXELS 0x41         // + rows, palette index of every lit led, 4 bits each
+#define CAPTURE_PALETTE 0x42        // color of every entry (3 each)
+#define CAPTURE_ROWS ((MATRIX_HEIGHT + 7) / 8)
+#define CAPTURE_HEADER 4
+
 // modes
-#define TOTAL_MODES 2
+#define TOTAL_MODES 3
 #define MODE_CLOCK 0
 #define MODE_MATRIX 1
+#define MODE_TEXT 2
 #define MODE_CHANGE 8
 #define MODE_CHANGED 9
 
@@ -76,6 +223,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define COLOR_BLUE 658175
 #define COLOR_YELLOW 16309760
 
+// buttons, pin changes queued until the buttons task runs (a power of two)
+#define TOTAL_BUTTONS 4
+#define BUTTON_QUEUE 16
+
 // pin definitions
 #define PIN_BUTTON_MODE 5
 #define PIN_BUTTON_BRIGHTNESS 6
@@ -83,6 +234,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PIN_BUTTON_LANGUAGE 8
 #define PIN_LEDSTRIP 4
 
+// DS1307 1Hz square wave output, comment out to extrapolate time with millis()
+// and read the RTC every second while frames are being shown
+//#define PIN_RTC_SQW 2
+
 // =============================================================================
 // Globals
 // =============================================================================
@@ -92,47 +247,217 @@ byte language = LANGUAGE_CATALAN;
 byte color = DEFAULT_COLOR;
 byte brightness = DEFAULT_BRIGHTNESS;
 
-// Pixel strip
-Adafruit_NeoPixel matrix = Adafruit_NeoPixel(TOTAL_PIXELS, PIN_LEDSTRIP, NEO_GRB + NEO_KHZ800);
+// Pixel strip, 4 bit palette indexes expanded to GRB while streaming
+byte pixels[PALETTE_BUFFER(TOTAL_PIXELS)];
+PaletteStrip matrix = PaletteStrip(pixels, TOTAL_PIXELS, PIN_LEDSTRIP);
 
-// Buttons
-void buttonCallback(uint8_t pin, uint8_t event);
-DebounceEvent buttonHour = DebounceEvent(PIN_BUTTON_BRIGHTNESS, buttonCallback);
-DebounceEvent buttonMinute = DebounceEvent(PIN_BUTTON_COLOR, buttonCallback);
-DebounceEvent buttonMode = DebounceEvent(PIN_BUTTON_MODE, buttonCallback);
-DebounceEvent buttonFunction = DebounceEvent(PIN_BUTTON_LANGUAGE, buttonCallback);
-
-// RTC
-RTC_DS1307 rtc;
+// Log, queued and sent by the serial task as fast as the port takes it
+byte log_buffer[LOG_BUFFER];
+LogBuffer logger = LogBuffer(log_buffer, LOG_BUFFER, &Serial);
 
-// Clock colors
-unsigned long colors[TOTAL_COLORS] = { COLOR_WHITE, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW };
+// Binary commands received throu serial
+byte command_payload[COMMAND_PAYLOAD];
+Protocol protocol = Protocol(command_payload, COMMAND_PAYLOAD);
 
-// The matrix array holds the time pattern matrix values
-unsigned int time_pattern[16] = {0};
+// Buttons, their edges are queued by the pin change interrupt with
+// a timestamp and replayed by the buttons task, bit i is button i
+void buttonCallback(uint8_t pin, uint8_t event);
+const byte button_pins[TOTAL_BUTTONS] = { PIN_BUTTON_BRIGHTNESS, PIN_BUTTON_COLOR, PIN_BUTTON_MODE, PIN_BUTTON_LANGUAGE };
+DebounceEvent buttons[TOTAL_BUTTONS] = {
+   DebounceEvent(PIN_BUTTON_BRIGHTNESS, buttonCallback),
+   DebounceEvent(PIN_BUTTON_COLOR, buttonCallback),
+   DebounceEvent(PIN_BUTTON_MODE, buttonCallback),
+   DebounceEvent(PIN_BUTTON_LANGUAGE, buttonCallback)
+};
+pin_change_t button_queue[BUTTON_QUEUE];
+PinChange buttonChanges = PinChange(button_queue, BUTTON_QUEUE);
+byte buttons_levels = 0;
+unsigned long buttons_at = 0;
+
+// A button asked for a redraw, done by the render task
+bool update_pending = false;
+
+// RTC, read once and then extrapolated
+RTC_DS1307 rtc;
+unsigned long rtcRead();
+void rtcWrite(unsigned long time);
+TimeSource timeSource = TimeSource(rtcRead, rtcWrite);
+
+// Tasks, sorted by priority
+void buttonsTask();
+void rtcTask();
+void renderTask();
+void serialTask();
+void eepromTask();
+void memoryTask();
+const task_config_t task_configs[] PROGMEM = {
+   TASK(buttonsTask, TASK_BUTTONS_PERIOD, TASK_BUTTONS_DEADLINE, 0),
+   TASK(rtcTask, TASK_RTC_PERIOD, TASK_RTC_DEADLINE, 1),
+   TASK(renderTask, TASK_RENDER_PERIOD, TASK_RENDER_DEADLINE, 2),
+   TASK(serialTask, TASK_SERIAL_PERIOD, TASK_SERIAL_DEADLINE, 3),
+   TASK(eepromTask, TASK_EEPROM_PERIOD, TASK_EEPROM_DEADLINE, 4),
+   TASK(memoryTask, TASK_MEMORY_PERIOD, TASK_MEMORY_DEADLINE, 5)
+};
+#define TOTAL_TASKS (sizeof(task_configs) / sizeof(task_config_t))
+task_t tasks[TOTAL_TASKS];
+Scheduler scheduler = Scheduler(task_configs, tasks, TOTAL_TASKS);
+
+// CPU sleep between tasks, woken by the timer, the buttons and the RTC
+Idle idle;
+
+// Statistics dumped by the text commands, a line at a time through the
+// log as it empties, so the longest lines fit whole. Bit i of the
+// pending ones is DUMP_* i, they go in that order
+#define DUMP_STATS 0
+#define DUMP_MEMORY 1
+#define DUMP_PROFILER 2
+#define DUMP_ROOM (LOG_BUFFER - 1 - LOG_BUFFER_CUT_SIZE)
+byte dump_pending = 0;
+byte dump_line = 0;
+bool schedulerStatsDisplay(byte line);
+bool idleStatsDisplay(byte line);
+bool profilerDisplay(byte line);
+
+// Settings as stored in EEPROM, a copy taken on every change
+settings_t settings_record;
+Settings settings = Settings(&settings_record, sizeof(settings_t), SETTINGS_VERSION);
+
+// Clock colors and the color of every word style
+const unsigned long colors[TOTAL_COLORS] PROGMEM = { COLOR_WHITE, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW };
+const unsigned long word_colors[TOTAL_STYLES] PROGMEM = { WORD_COLOR_MINUTES, WORD_COLOR_HOUR, WORD_COLOR_PERIOD, WORD_COLOR_HIGHLIGHT };
+
+// The words lit for the current time, and the pattern they light
+sentence_t time_sentence;
+row_t time_pattern[MATRIX_HEIGHT] = {0};
+
+// Mode whose palette entries are loaded, and the styles of the words shown
+byte palette_mode = TOTAL_MODES;
+byte clock_styles = 0;
+
+// Frame diff state: lit pixels in the strip buffer, their color and brightness
+row_t frame_pattern[MATRIX_HEIGHT] = {0};
+row_t frame_next[MATRIX_HEIGHT] = {0};
+unsigned long frame_color = 0;
+byte frame_brightness = 255;
+bool frame_uniform = false;
+
+// Minute transition, the leds that change take the fade entries of their style
+bool fade_active = false;
+unsigned long fade_since = 0;
+void fadeStep();
+void fadeEnd();
+unsigned int fadeEase(unsigned int t);
+unsigned long fadeColor(unsigned long color, unsigned int level);
+
+// Matrix effect: rays and the time pattern they are assembling
+ray_t rays[MATRIX_MAX_RAYS];
+Rain rain = Rain(rays, MATRIX_MAX_RAYS);
+byte matrix_phase = MATRIX_RAIN;
+unsigned long matrix_since = 0;
+unsigned long matrix_count = 0;
+unsigned int matrix_countdown = 0;
+byte matrix_total = 0;
+byte matrix_hits = 0;
+row_t matrix_pattern[MATRIX_HEIGHT] = {0};
+
+// Text mode: the text, the column drawn on the left edge and the mode
+// to go back to once a message has scrolled, MODE_TEXT for the date
+char text_buffer[TEXT_MAX];
+TextScroll scroller = TextScroll(text_buffer, TEXT_MAX);
+int text_column = 0;
+byte text_return = MODE_TEXT;
+
+// Frame statistics
+unsigned long frames_shown = 0;
+unsigned long frames_skipped = 0;
+unsigned long pixels_touched = 0;
+
+// Frames shown when the RTC task last ran
+unsigned long rtc_frames = 0;
+
+#ifdef CAPTURE
+// Frame capture, on while capture_period is not 0
+unsigned int capture_period = 0;
+unsigned long capture_last = 0;
+bool capture_pending = false;         // frame shown not streamed yet
+bool capture_colors = false;          // palette streamed still valid
+unsigned int capture_crc = 0;         // of the palette streamed
+byte capture_sequence = 0;
+unsigned long capture_skipped = 0;
+#endif
 
 
 // =============================================================================
 // Interrupt routines
 // =============================================================================
 
+#ifdef PIN_RTC_SQW
+/**
+ * DS1307 square wave falling edge, one per second
+ */
+void rtcTick() {
+   timeSource.tick();
+   idle.wake(IDLE_WAKE_RTC);
+}
+#endif
+
+/**
+ * A button edge has been queued
+ */
+void buttonsWake() {
+   idle.wake(IDLE_WAKE_BUTTON);
+}
+
 // =============================================================================
 // Methods
 // =============================================================================
 
-// Get pixel index in matrix from X,Y coords
-unsigned int pixelIndex(int x, int y) {
-   return MATRIX_WIDTH * y + ((y % 2 == 0) ? x : MATRIX_HEIGHT - x - 1);
+typedef Layout<MATRIX_TILE_WIDTH, MATRIX_TILE_HEIGHT, MATRIX_TILES_X, MATRIX_TILES_Y,
+   MATRIX_WIRING, MATRIX_ROTATION, MATRIX_MIRROR> MatrixLayout;
+static_assert(MatrixLayout::width == MATRIX_WIDTH && MatrixLayout::height == MATRIX_HEIGHT,
+   "panel layout does not match the matrix size");
+static_assert(RAIN_WIDTH == MATRIX_WIDTH && RAIN_HEIGHT == MATRIX_HEIGHT,
+   "rain size does not match the matrix size");
+static_assert(TEXT_WIDTH == MATRIX_WIDTH && FONT_HEIGHT <= MATRIX_HEIGHT,
+   "text size does not match the matrix size");
+
+// Get pixel index in matrix from X,Y coords, a lookup in the flash table
+inline unsigned int pixelIndex(byte x, byte y) {
+   return MatrixLayout::index(x, y);
 }
 
 // === TIME ====================================================================
 
+/**
+ * Time source backend, reads the DS1307 over I2C
+ * @return unsigned long         Unix time, TIME_INVALID if the read failed
+ */
+unsigned long rtcRead() {
+   PROFILE_START(PROFILE_RTC);
+   DateTime now = rtc.now();
+   PROFILE_STOP(PROFILE_RTC);
+   // a failed I2C read gives 0xFF bytes, out of range once decoded
+   if ((now.second() > 59) || (now.minute() > 59) || (now.hour() > 23)
+      || (now.day() < 1) || (now.day() > 31) || (now.month() < 1) || (now.month() > 12)) {
+      return TIME_INVALID;
+   }
+   return now.unixtime();
+}
+
+/**
+ * Time source backend, writes the DS1307 over I2C
+ * @param  unsigned long time    Unix time
+ */
+void rtcWrite(unsigned long time) {
+   rtc.adjust(DateTime(time));
+}
+
 /**
  * Resets DS1307 time to compile time
  */
 void resetTime() {
-   #ifdef DEBUG
-      Serial.println(F("Reseting DS1307"));
+   #if LOG_LEVEL >= LOG_LEVEL_WARNING
+      logger.println(F("Reseting DS1307"));
    #endif
    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
 }
@@ -144,8 +469,7 @@ void resetTime() {
  * @param  int seconds       Number of seconds forward positive
  */
 void shiftTime(int hours, int minutes, int seconds) {
-   DateTime newTime = DateTime(rtc.now().unixtime() + seconds+60*(minutes+60*hours));
-   rtc.adjust(newTime);
+   timeSource.adjust(timeSource.now() + seconds+60*(minutes+60*hours));
    mode = MODE_CHANGED;
 }
 
@@ -153,7 +477,7 @@ void shiftTime(int hours, int minutes, int seconds) {
  * Sets seconds to 0 for current hour:minute
  */
 void resetSeconds() {
-   shiftTime(0, 0, -rtc.now().second());
+   shiftTime(0, 0, -DateTime(timeSource.now()).second());
 }
 
 /**
@@ -162,9 +486,9 @@ void resetSeconds() {
  * @param  bool semicolon     Whether to prepend a semicolon or not, defaults to false
  */
 void printDigits(int digits, bool semicolon = false){
-   if (semicolon) Serial.print(F(":"));
-   if(digits < 10) Serial.print(F("0"));
-   Serial.print(digits);
+   if (semicolon) logger.print(F(":"));
+   if(digits < 10) logger.print(F("0"));
+   logger.print(digits);
 }
 
 /**
@@ -172,26 +496,124 @@ void printDigits(int digits, bool semicolon = false){
  * @param  DateTime now           DateTime object
  */
 void digitalClockDisplay(DateTime now){
-   Serial.print(F("Time: "));
+   logger.print(F("Time: "));
    printDigits(now.hour(), false);
    printDigits(now.minute(), true);
    printDigits(now.second(), true);
-   Serial.println();
+   logger.println();
 }
 
-// === CLOCK ===================================================================
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+/**
+ * Displays time source statistics throu serial
+ */
+void timeStatsDisplay() {
+   logger.print(F("RTC: "));
+   logger.print(timeSource.reads());
+   logger.print(F(" reads, "));
+   logger.print(timeSource.rejected());
+   logger.print(F(" rejected, drift "));
+   logger.println(timeSource.drift());
+}
+#endif
+
+// === FRAME ===================================================================
 
 /**
- * Loads a word code into the time matrix
- * @param  clockword code          a tupla defining the leds to be lit to form a word
- * @param  unsigned  int *         LED matrix array representation
+ * Sets the strip brightness, only rescales the palette when it changes
+ * @param  byte level         Brightness level
+ * @return bool               True if the brightness has changed
  */
-void loadCode(clockword code, unsigned int * matrix) {
-   matrix[code.row] = matrix[code.row] | code.positions;
+bool frameBrightness(byte level) {
+   if (level == frame_brightness) return false;
+   matrix.setBrightness(level);
+   frame_brightness = level;
+   return true;
 }
 
 /**
- * Loads current time pattern in time_pattern matrix
+ * Pushes the frame to the strip if it has changed or is being dithered
+ * @param  bool changed       Whether the frame differs from the one shown
+ */
+void frameShow(bool changed) {
+   if (changed || matrix.dithering()) {
+      PROFILE_START(PROFILE_SHOW);
+      matrix.show();
+      PROFILE_STOP(PROFILE_SHOW);
+      frames_shown++;
+      #ifdef CAPTURE
+         if (changed && (capture_period > 0)) {
+            if (capture_pending) capture_skipped++;
+            capture_pending = true;
+         }
+      #endif
+   } else {
+      frames_skipped++;
+   }
+}
+
+/**
+ * Starts a new multicolor frame, pixels not set before frameEnd are cleared
+ * @param  byte level         Brightness level
+ * @return bool               True if the brightness has changed
+ */
+bool frameBegin(byte level) {
+   for (byte y=0; y<MATRIX_HEIGHT; y++) frame_next[y] = 0;
+   return frameBrightness(level);
+}
+
+/**
+ * Sets a pixel of the frame being drawn
+ * @param  byte x             Column
+ * @param  byte y             Row
+ * @param  byte index         Palette entry
+ */
+void frameSetPixel(byte x, byte y, byte index) {
+   matrix.setPixel(pixelIndex(x, y), index);
+   frame_next[y] |= (row_t) 1 << x;
+   pixels_touched++;
+}
+
+/**
+ * Clears the pixels lit in the previous frame but not in this one
+ * and pushes the frame if any pixel has been lit or cleared
+ * @param  bool changed       Whether the colors have changed
+ */
+void frameEnd(bool changed) {
+   for (byte y=0; y<MATRIX_HEIGHT; y++) {
+      if (frame_pattern[y] != frame_next[y]) changed = true;
+      row_t stale = frame_pattern[y] & ~frame_next[y];
+      for (; stale > 0; stale &= stale - 1) {
+         matrix.setPixel(pixelIndex(rowFirst(stale), y), PALETTE_OFF);
+         pixels_touched++;
+      }
+      frame_pattern[y] = frame_next[y];
+   }
+   frame_uniform = false;
+   frameShow(changed);
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+/**
+ * Displays frame statistics throu serial
+ */
+void frameStatsDisplay() {
+   logger.print(F("Frames: "));
+   logger.print(frames_shown);
+   logger.print(F(" shown, "));
+   logger.print(frames_skipped);
+   logger.print(F(" skipped, "));
+   logger.print(pixels_touched);
+   logger.print(F(" pixels, "));
+   logger.print(rain.dropped());
+   logger.println(F(" dropped"));
+}
+#endif
+
+// === CLOCK ===================================================================
+
+/**
+ * Loads current time sentence and its pattern in time_pattern matrix
  * @param  bool force         Update regardless the time since last update
  */
 bool loadTimePattern(bool force = false) {
@@ -201,24 +623,33 @@ bool loadTimePattern(bool force = false) {
 
    // Check previous values for hour and minute and
    // update only if they have changed
-   DateTime now = rtc.now();
+   DateTime now = DateTime(timeSource.now());
    int current_hour = now.hour();
    int current_minute = now.minute();
    if ((!force) && (current_hour == previous_hour) && (current_minute == previous_minute)) return false;
    previous_hour = current_hour;
    previous_minute = current_minute;
 
-   digitalClockDisplay(now);
+   #if LOG_LEVEL >= LOG_LEVEL_INFO
+      digitalClockDisplay(now);
+   #endif
+   #if LOG_LEVEL >= LOG_LEVEL_DEBUG
+      frameStatsDisplay();
+      timeStatsDisplay();
+   #endif
 
    // Reset time pattern
    for (byte i=0; i<MATRIX_HEIGHT; i++) time_pattern[i] = 0;
 
-   // Load strings
-   if (language == LANGUAGE_CATALAN) {
-      loadLanguageCatalan(current_hour, current_minute, time_pattern);
-   } else {
-      loadLanguageCastellano(current_hour, current_minute, time_pattern);
+   // Load the words, and the leds they light
+   PROFILE_START(PROFILE_PATTERN);
+   loadSentence(language, current_hour, current_minute, &time_sentence);
+   for (byte i=0; i<time_sentence.count; i++) {
+      clockword word;
+      sentenceWord(&time_sentence, i, &word);
+      loadCode(word, time_pattern);
    }
+   PROFILE_STOP(PROFILE_PATTERN);
 
    return true;
 
@@ -233,10 +664,8 @@ byte countLEDs() {
    byte char_total = 0;
 
    for (byte y=0; y<MATRIX_HEIGHT; y++) {
-      unsigned int row = time_pattern[y];
-      while (row>0) {
-         if (row & 1) char_total++;
-         row >>= 1;
+      for (row_t row = time_pattern[y]; row > 0; row &= row - 1) {
+         char_total++;
       }
    }
 
@@ -244,208 +673,561 @@ byte countLEDs() {
 
 }
 
-void loadTimeInMatrix(unsigned int * pattern, unsigned long color) {
+/**
+ * Draws a pattern into the frame being built, visiting only lit leds
+ * @param  row_t *            Pattern to draw
+ * @param  byte index         Palette entry
+ */
+void loadTimeInMatrix(row_t * pattern, byte index) {
 
-   for (byte y=0; y < 16; y++) {
-      unsigned int value = 1;
-      for (byte x=0; x < 16; x++) {
-         if ((pattern[y] & value) > 0) {
-            matrix.setPixelColor(pixelIndex(x, y), color);
-         }
-         value <<= 1;
+   for (byte y=0; y < MATRIX_HEIGHT; y++) {
+      for (row_t row = pattern[y]; row > 0; row &= row - 1) {
+         frameSetPixel(rowFirst(row), y, index);
       }
    }
 
 }
 
 /**
- * Load current time into LED matrix
+ * Style a word of the sentence is drawn with
+ * @param  byte id            Word id, see language.h
+ * @return byte               Style
  */
-void updateClock() {
-   matrix.clear();
-   matrix.setBrightness(brightness);
-   loadTimeInMatrix(time_pattern, colors[color]);
-   matrix.show();
+byte wordStyle(byte id) {
+   if (id & WORD_HIGHLIGHT) return STYLE_HIGHLIGHT;
+   if (id < WORD_HOUR) return STYLE_MINUTES;
+   if (id < WORD_PERIOD) return STYLE_HOUR;
+   return STYLE_PERIOD;
 }
 
-// === MATRIX ==================================================================
+/**
+ * Color of a word style, the highlighted words follow their pulse
+ * @param  byte style         Style
+ * @return unsigned long      0xRRGGBB
+ */
+unsigned long wordColor(byte style) {
+   unsigned long value = pgm_read_dword(&word_colors[style]);
+   if (value == 0) value = pgm_read_dword(&colors[color]);
+   #ifdef WORD_PULSE
+      if (style == STYLE_HIGHLIGHT) {
+         unsigned int t = ((millis() % WORD_PULSE) << 9) / WORD_PULSE;
+         if (t > 256) t = 512 - t;
+         value = fadeColor(value, 256 - (((256UL - WORD_PULSE_MIN) * fadeEase(t)) >> 8));
+      }
+   #endif
+   return value;
+}
 
 /**
- * Calculates color of the falling ray depending on distance to the tip
- * @param  byte current       Position of current led in ray
- * @param  byte total         Ray length
+ * Whether the frame shows highlighted words that pulse
  */
-unsigned long getMatrixColor(byte current, byte total) {
-   byte green = map(current, 0, total, 255, 0);
-   byte red = current == 0 ? 255 : 0;
-   return matrix.Color(red, green, 0);
+bool clockPulsing() {
+   #ifdef WORD_PULSE
+      return (palette_mode == MODE_CLOCK) && (clock_styles & (1 << STYLE_HIGHLIGHT));
+   #else
+      return false;
+   #endif
 }
 
 /**
- * Updates matrix effect
- * @param  bool force         Update regardless the time since last update
+ * Loads the steady color of every word style
  */
-void updateMatrix(bool force = false) {
+void clockPalette() {
+   for (byte style=0; style<TOTAL_STYLES; style++) {
+      matrix.setPalette(PALETTE_WORD + style, wordColor(style));
+   }
+   palette_mode = MODE_CLOCK;
+}
+
+/**
+ * Moves the highlighted words along their pulse, only their palette
+ * entry changes so no pixel is written
+ */
+void clockPulse() {
+   matrix.setPalette(PALETTE_WORD + STYLE_HIGHLIGHT, wordColor(STYLE_HIGHLIGHT));
+}
 
-   static unsigned long count = 0;
-   static unsigned long next_update = millis();
-   static byte current_num_rays = 0;
-   static ray_struct ray[MATRIX_MAX_RAYS];
-   static unsigned int countdown = 0;
-
-   static bool sticky = false;
-   static bool create = true;
-   static byte char_total = 0;
-   static byte char_so_far = 0;
-   static unsigned int local_pattern[MATRIX_HEIGHT];
-
-   byte i = 0;
-
-   if (!force && (next_update > millis())) return;
-
-   if (create && (current_num_rays < MATRIX_MAX_RAYS)) {
-      bool do_create = random(0, 100) < MATRIX_BIRTH_RATIO;
-      if (do_create) {
-         i=0;
-         while (ray[i].life > 0) i++;
-         ray[i].x = random(0, MATRIX_WIDTH);
-         ray[i].y = random(-5, 5);
-         ray[i].speed = random(MATRIX_SPEED_MAX, MATRIX_SPEED_MIN);
-         ray[i].length = random(MATRIX_LENGTH_MIN, MATRIX_LENGTH_MAX);
-         ray[i].life = random(MATRIX_LIFE_MIN, MATRIX_LIFE_MAX);
-         current_num_rays++;
+/**
+ * Draws the words of the time sentence in a single pass over their leds,
+ * each one with the palette entry of its style. When fading, the leds
+ * arriving take the fade in entry of their style and the ones leaving
+ * stay lit with the fade out entry of the style they had
+ * @param  bool fade          Cross-fade from the words shown
+ * @return bool               True if any led arrives or leaves
+ */
+bool clockDraw(bool fade) {
+
+   PROFILE_START(PROFILE_FILL);
+   frameBegin(brightness);
+   clockPalette();
+   bool moved = false;
+
+   clock_styles = 0;
+   for (byte i=0; i<time_sentence.count; i++) {
+      clockword word;
+      sentenceWord(&time_sentence, i, &word);
+      byte style = wordStyle(time_sentence.words[i]);
+      clock_styles |= 1 << style;
+      for (row_t row = word.positions; row > 0; row &= row - 1) {
+         byte x = rowFirst(row);
+         bool arriving = fade && !((frame_pattern[word.row] >> x) & 1);
+         if (arriving) moved = true;
+         frameSetPixel(x, word.row, (arriving ? PALETTE_WORD_IN : PALETTE_WORD) + style);
       }
    }
 
-   if ((!sticky) && (count > STICKY_COUNT)) {
-      sticky = true;
-      countdown = STICKY_MAX;
-      loadTimePattern();
-      char_total = countLEDs();
-      for (i=0; i<MATRIX_HEIGHT; i++) {
-         local_pattern[i] = 0;
+   if (fade) {
+      for (byte y=0; y<MATRIX_HEIGHT; y++) {
+         for (row_t row = frame_pattern[y] & ~frame_next[y]; row > 0; row &= row - 1) {
+            byte x = rowFirst(row);
+            byte style = matrix.getPixel(pixelIndex(x, y)) - PALETTE_WORD;
+            if (style >= TOTAL_STYLES) style = STYLE_MINUTES;
+            frameSetPixel(x, y, PALETTE_WORD_OUT + style);
+            moved = true;
+         }
       }
-      char_so_far = 0;
    }
 
-   matrix.clear();
+   PROFILE_STOP(PROFILE_FILL);
+   frameEnd(true);
+
+   // words of a single color stream as a single color frame
+   frame_color = pgm_read_dword(&colors[color]);
+   frame_uniform = !fade && !clockPulsing();
+   for (byte style=0; style<TOTAL_STYLES; style++) {
+      if ((clock_styles & (1 << style)) && (wordColor(style) != frame_color)) frame_uniform = false;
+   }
+
+   return moved;
+
+}
+
+/**
+ * Load current time into LED matrix
+ * @param  bool fade          Cross-fade from the words shown
+ */
+void updateClock(bool fade = false) {
+
+   fadeEnd();
+
+   // a fade only changes the colors of the leds in the palette, so
+   // the frame must already be the clock words
+   fade = fade && (FADE_DURATION > 0) && (palette_mode == MODE_CLOCK);
+   if (!clockDraw(fade)) return;
+
+   fade_active = true;
+   fade_since = millis();
+   fadeStep();
+
+}
+
+// === FADE ====================================================================
+
+/**
+ * Easing curve, 8.8 fixed point
+ * @param  unsigned int t     Elapsed, 0 to 256
+ * @return unsigned int       Progress, 0 to 256
+ */
+unsigned int fadeEase(unsigned int t) {
+   #if FADE_CURVE == FADE_EASE_IN
+      return ((unsigned long) t * t) >> 8;
+   #elif FADE_CURVE == FADE_SMOOTH
+      return ((unsigned long) t * t * (768 - 2 * t)) >> 16;
+   #else
+      return t;
+   #endif
+}
+
+/**
+ * Scales a color
+ * @param  unsigned long color    0xRRGGBB
+ * @param  unsigned int level     0 to 256
+ */
+unsigned long fadeColor(unsigned long color, unsigned int level) {
+   byte r = ((color >> 16 & 0xFF) * level) >> 8;
+   byte g = ((color >> 8 & 0xFF) * level) >> 8;
+   byte b = ((color & 0xFF) * level) >> 8;
+   return PaletteStrip::Color(r, g, b);
+}
+
+/**
+ * Moves the fade colors of every style to the current time, only
+ * palette entries change so no pixel is written until the end
+ */
+void fadeStep() {
+   unsigned long elapsed = millis() - fade_since;
+   if (elapsed >= FADE_DURATION) {
+      fadeEnd();
+      return;
+   }
+   unsigned int level = fadeEase((elapsed << 8) / FADE_DURATION);
+   for (byte style=0; style<TOTAL_STYLES; style++) {
+      unsigned long value = wordColor(style);
+      matrix.setPalette(PALETTE_WORD_IN + style, fadeColor(value, level));
+      matrix.setPalette(PALETTE_WORD_OUT + style, fadeColor(value, 256 - level));
+   }
+   if (clockPulsing()) clockPulse();
+   frameShow(true);
+}
+
+/**
+ * Completes the running fade, if any, drawing the words in their
+ * steady colors
+ */
+void fadeEnd() {
+   if (!fade_active) return;
+   fade_active = false;
+   clockDraw(false);
+}
+
+// === MATRIX ==================================================================
 
-   for (i=0; i<MATRIX_MAX_RAYS; i++) {
-      if (ray[i].life > 0) {
+/**
+ * Switches the matrix effect to another phase
+ * @param  byte phase         New phase
+ */
+void matrixPhase(byte phase) {
+   matrix_phase = phase;
+   matrix_since = millis();
+}
 
-         // update ray position depending on speed
-         if (count % ray[i].speed == 0) {
-            ray[i].y = ray[i].y + 1;
-            ray[i].life = ray[i].life - 1;
+/**
+ * Runs one fixed step of the matrix effect, never blocks
+ * @return bool               True if the frame has changed
+ */
+bool matrixStep() {
+
+   bool changed = false;
+   byte hits;
+
+   switch (matrix_phase) {
+
+      case MATRIX_RAIN:
+         if (rain.spawn()) changed = true;
+         if (rain.step()) changed = true;
+         if (++matrix_count > STICKY_COUNT) {
+            loadTimePattern();
+            matrix_total = countLEDs();
+            matrix_hits = 0;
+            matrix_countdown = STICKY_MAX;
+            for (byte i=0; i<MATRIX_HEIGHT; i++) matrix_pattern[i] = 0;
+            matrixPhase(MATRIX_STICKY);
          }
+         break;
 
-         // get colors for each pixel
-         byte start = 0;
-         if (ray[i].life <= ray[i].length) {
-            start = ray[i].length - ray[i].life ;
+      case MATRIX_STICKY:
+         if (rain.spawn()) changed = true;
+         if (rain.step()) changed = true;
+         hits = rain.hit(time_pattern, matrix_pattern);
+         if (hits > 0) {
+            matrix_hits += hits;
+            changed = true;
+         }
+         if (matrix_hits >= matrix_total) {
+            matrixPhase(MATRIX_CLOSING);
+            changed = true;
+         } else if (--matrix_countdown == 0) {
+            #if LOG_LEVEL >= LOG_LEVEL_INFO
+               logger.println(F("Force closed"));
+            #endif
+            for (byte i=0; i<MATRIX_HEIGHT; i++) matrix_pattern[i] = time_pattern[i];
+            matrixPhase(MATRIX_CLOSING);
+            changed = true;
          }
+         break;
 
-         bool active = false;
-         for (byte p=start; p<ray[i].length; p++) {
-            int y = ray[i].y - p;
-            if (0 <= y && y < MATRIX_HEIGHT) {
-               matrix.setPixelColor(pixelIndex(ray[i].x, y), getMatrixColor(p, ray[i].length));
-            }
-            active |= (y < MATRIX_HEIGHT);
+      case MATRIX_CLOSING:
+         if (rain.step()) changed = true;
+         if (rain.alive() == 0) matrixPhase(MATRIX_HOLD);
+         break;
+
+      case MATRIX_HOLD:
+         if (millis() - matrix_since >= STICKY_PAUSE) {
+            matrix_count = 0;
+            matrixPhase(MATRIX_RAIN);
+            changed = true;
          }
-         if (!active) ray[i].life = 0;
+         break;
 
-         // we are in sticky mode
-         if (sticky) {
+   }
 
-            byte y = ray[i].y;
+   return changed;
 
-            if (0 <= y && y < MATRIX_HEIGHT) {
+}
 
-               // check if we have hit a led in the time_pattern matrix
-               unsigned int value = 1 << ray[i].x;
-               if ((time_pattern[y] & value) == value) {
+/**
+ * Loads the time and rain colors, if the clock words have taken their entries
+ * @return bool               True if the palette has changed
+ */
+bool matrixPalette() {
+   if (palette_mode == MODE_MATRIX) return false;
+   matrix.setPalette(PALETTE_TIME, COLOR_YELLOW);
+   for (byte shade=0; shade<=RAIN_SHADES; shade++) {
+      matrix.setPalette(PALETTE_RAIN + shade, Rain::color(shade));
+   }
+   palette_mode = MODE_MATRIX;
+   return true;
+}
 
-                     // check if we have already hit this led before
-                     if ((local_pattern[y] & value) != value) {
+/**
+ * Draws a ray pixel, the shades follow the time colors in the palette
+ * @param  byte x             Column
+ * @param  byte y             Row
+ * @param  byte shade         Rain shade
+ */
+void matrixPixel(byte x, byte y, byte shade) {
+   frameSetPixel(x, y, PALETTE_RAIN + shade);
+}
 
-                        // kill the ray
-                        ray[i].life = ray[i].length - 1;
-                        char_so_far++;
+/**
+ * Draws the rays and the time leds hit so far
+ * @param  bool changed       Whether the frame has to be shown
+ */
+void matrixDraw(bool changed) {
+
+   PROFILE_START(PROFILE_FILL);
+   if (frameBegin(DEFAULT_BRIGHTNESS)) changed = true;
+   if (matrixPalette()) changed = true;
+   rain.draw(matrixPixel);
+   if (matrix_phase != MATRIX_RAIN) {
+      loadTimeInMatrix(matrix_pattern, PALETTE_TIME);
+   }
+   PROFILE_STOP(PROFILE_FILL);
+   frameEnd(changed);
 
-                        // save it into local pattern
-                        local_pattern[y] = local_pattern[y] + value;
+}
 
-                        // are we done?
-                        if (char_so_far == char_total) {
-                           create = false;
-                        }
+/**
+ * Updates matrix effect, runs the steps due since the last update
+ * and draws once
+ * @param  bool force         Draw even if no step is due
+ */
+void updateMatrix(bool force = false) {
 
-                     }
+   byte steps = rain.due(millis());
+   if ((steps == 0) && !force) return;
 
-               }
+   bool changed = force;
+   while (steps-- > 0) {
+      if (matrixStep()) changed = true;
+   }
+   matrixDraw(changed);
 
-            }
+}
 
-         }
+// === TEXT ====================================================================
 
-         // free ray if dead
-         if (ray[i].life == 0) current_num_rays--;
+/**
+ * Loads the text colors, the leds the text moves into and the ones it
+ * leaves share the clock color by how far it has moved
+ * @param  byte fraction      Progress toward the next column, 0 to 255
+ */
+void textPalette(byte fraction) {
+   unsigned long value = pgm_read_dword(&colors[color]);
+   matrix.setPalette(PALETTE_TEXT, value);
+   matrix.setPalette(PALETTE_TEXT_IN, fadeColor(value, fraction));
+   matrix.setPalette(PALETTE_TEXT_OUT, fadeColor(value, 256 - fraction));
+   palette_mode = MODE_TEXT;
+}
 
+/**
+ * Draws the text from a column on the left edge blended with the next
+ * one: leds lit in both take the steady entry, the rest the entry of
+ * the column they belong to. Only the lit leds are visited
+ * @param  int column         Text column on the left edge
+ */
+void textDraw(int column) {
+
+   text_row_t now[FONT_HEIGHT] = {0};
+   text_row_t next[FONT_HEIGHT] = {0};
+
+   PROFILE_START(PROFILE_FILL);
+   scroller.draw(now, column);
+   scroller.draw(next, column + 1);
+   frameBegin(brightness);
+   for (byte i=0; i<FONT_HEIGHT; i++) {
+      for (row_t row = now[i] | next[i]; row > 0; row &= row - 1) {
+         byte x = rowFirst(row);
+         byte index = PALETTE_TEXT_IN;
+         if ((now[i] >> x) & 1) index = ((next[i] >> x) & 1) ? PALETTE_TEXT : PALETTE_TEXT_OUT;
+         frameSetPixel(x, TEXT_TOP + i, index);
       }
    }
+   PROFILE_STOP(PROFILE_FILL);
+   frameEnd(true);
 
-   if (sticky) {
-      if (countdown > 0) {
-         if (--countdown == 0) {
-            Serial.println(F("Force closed"));
-            for (i=0; i<MATRIX_HEIGHT; i++) local_pattern[i] = time_pattern[i];
-            create = false;
-         }
-      }
-   }
+}
 
-   if (sticky or !create) {
-      // draw hit leds
-      loadTimeInMatrix(local_pattern, COLOR_YELLOW);
+/**
+ * Sets the text to the current date, dd/mm/yyyy
+ */
+void textDate() {
+   DateTime now = DateTime(timeSource.now());
+   char date[10];
+   date[0] = '0' + now.day() / 10;
+   date[1] = '0' + now.day() % 10;
+   date[2] = '/';
+   date[3] = '0' + now.month() / 10;
+   date[4] = '0' + now.month() % 10;
+   date[5] = '/';
+   unsigned int year = now.year();
+   for (byte i=9; i>=6; i--) {
+      date[i] = '0' + year % 10;
+      year /= 10;
    }
+   scroller.set(date, sizeof(date));
+}
 
-   matrix.setBrightness(DEFAULT_BRIGHTNESS);
-   matrix.show();
+/**
+ * Scrolls the text set in the scroller once, then goes back to the
+ * mode shown. For status messages and the ones received throu serial
+ */
+void textMessage() {
+   if (mode != MODE_TEXT) text_return = mode < TOTAL_MODES ? mode : MODE_CLOCK;
+   scroller.start(millis());
+   mode = MODE_TEXT;
+   update_pending = true;
+}
 
-   if ((current_num_rays == 0) and !create) {
-      sticky = false;
-      create = true;
-      count = 0;
-      delay(STICKY_PAUSE);
-   } else {
-      count++;
+/**
+ * Scrolls the text, pixels are written only when it reaches another
+ * column, the frames in between only move the blend in the palette
+ * @param  bool force         Redraw even if the text has not moved
+ */
+void updateText(bool force = false) {
+
+   unsigned long now = millis();
+
+   // the date starts over as the mode is entered and after every pass,
+   // a message goes back to the mode it interrupted
+   bool entering = (palette_mode != MODE_TEXT);
+   if ((entering && (text_return == MODE_TEXT)) || scroller.done(now)) {
+      if (text_return != MODE_TEXT) {
+         mode = text_return;
+         text_return = MODE_TEXT;
+         update_pending = true;
+         return;
+      }
+      textDate();
+      scroller.start(now);
    }
 
-   next_update += UPDATE_MATRIX;
+   long position = scroller.position(now);
+   int column = position >> 8;
+   textPalette(position & 0xFF);
+   if (entering || force || (column != text_column)) {
+      text_column = column;
+      textDraw(column);
+   } else {
+      frameShow(true);
+   }
 
 }
 
 // === GENERAL =================================================================
 
+/**
+ * Flags settings to be written by the EEPROM task once they have been
+ * quiet for SETTINGS_QUIET ms
+ */
 void eeprom_save() {
-   EEPROM.update(0, mode);
-   EEPROM.update(1, language);
-   EEPROM.update(2, color);
-   EEPROM.update(3, brightness);
+   settings_record.mode = mode;
+   settings_record.language = language;
+   settings_record.color = color;
+   settings_record.brightness = brightness;
+   settings.save();
+}
+
+/**
+ * Writes the next byte of the pending settings, if any
+ */
+void eeprom_flush() {
+   settings.loop();
 }
 
+/**
+ * Loads the last settings saved, the defaults if there are none or
+ * they are out of range
+ */
 void eeprom_retrieve() {
-   mode = EEPROM.read(0);
-   language = EEPROM.read(1);
-   color = EEPROM.read(2);
-   brightness = EEPROM.read(3);
+
+   settings_record.mode = MODE_CLOCK;
+   settings_record.language = LANGUAGE_CATALAN;
+   settings_record.color = DEFAULT_COLOR;
+   settings_record.brightness = DEFAULT_BRIGHTNESS;
+   bool found = settings.begin(0, EEPROM.length());
+
+   mode = settings_record.mode < TOTAL_MODES ? settings_record.mode : MODE_CLOCK;
+   language = settings_record.language < languages_count ? settings_record.language : LANGUAGE_CATALAN;
+   color = settings_record.color < TOTAL_COLORS ? settings_record.color : DEFAULT_COLOR;
+   brightness = settings_record.brightness < BRIGHTNESS_MIN ? BRIGHTNESS_MIN : settings_record.brightness;
+
+   #if LOG_LEVEL >= LOG_LEVEL_DEBUG
+      logger.print(F("Settings: "));
+      if (found) {
+         logger.print(F("slot "));
+         logger.println(settings.slot());
+      } else {
+         logger.println(F("defaults"));
+      }
+   #endif
+
 }
 
-int freeRam () {
-  extern int __heap_start, *__brkval;
-  int v;
-  return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval);
+/**
+ * Displays a line of the RAM usage: static data, free now, lowest free
+ * ever and then the size of the main subsystems
+ * @param  byte line          Line
+ * @return bool               False past the last one
+ */
+bool memoryDisplay(byte line) {
+   switch (line) {
+      case 0:
+         logger.print(F("RAM: static "));
+         logger.print(memoryStatic());
+         logger.print(F(", free "));
+         logger.print(memoryFree());
+         logger.print(F(", min free "));
+         logger.println(memoryMinFree());
+         break;
+      case 1:
+         logger.print(F("  pixels "));
+         logger.println(sizeof(pixels) + sizeof(matrix));
+         break;
+      case 2:
+         logger.print(F("  rays "));
+         logger.println(sizeof(rays) + sizeof(rain));
+         break;
+      case 3:
+         logger.print(F("  patterns "));
+         logger.println(sizeof(time_sentence) + sizeof(time_pattern) + sizeof(frame_pattern) + sizeof(frame_next) + sizeof(matrix_pattern));
+         break;
+      case 4:
+         logger.print(F("  text "));
+         logger.println(sizeof(text_buffer) + sizeof(scroller));
+         break;
+      case 5:
+         logger.print(F("  buttons "));
+         logger.println(sizeof(buttons) + sizeof(button_queue) + sizeof(buttonChanges));
+         break;
+      case 6:
+         logger.print(F("  tasks "));
+         logger.println(sizeof(tasks));
+         break;
+      case 7:
+         logger.print(F("  serial "));
+         logger.println(sizeof(log_buffer) + sizeof(logger) + sizeof(command_payload) + sizeof(protocol));
+         break;
+      #ifdef PROFILER
+      case 8:
+         logger.print(F("  profiler "));
+         logger.println(sizeof(profiler));
+         break;
+      #endif
+      default:
+         return false;
+   }
+   return true;
 }
 
 // Update display depending on current mode
@@ -457,22 +1239,35 @@ void update(bool force = false) {
       case MODE_CHANGE:
       case MODE_CHANGED:
          if (loadTimePattern(force)) {
-            updateClock();
+            updateClock(!force);
+         } else if (fade_active) {
+            fadeStep();
+         } else if (clockPulsing()) {
+            clockPulse();
+            frameShow(true);
+         } else if (matrix.dithering()) {
+            frameShow(false);
          }
          break;
 
       case MODE_MATRIX:
+         fadeEnd();
          updateMatrix(force);
          break;
 
+      case MODE_TEXT:
+         fadeEnd();
+         updateText(force);
+         break;
+
    }
 
 }
 
 // There are 4 buttons
 // MODE button: changes mode, when hold in MODE_CLOCK enters MODE_CHANGE
-// BRIGHTNESS button: increases brightness (sums 1 to hour when in MODE_CHANGE)
-// COLOR button: changes color (sums 1 to minute when in MODE_CHANGE)
+// BRIGHTNESS button: increases brightness (sums 1 to hour when in MODE_CHANGE, repeats while hold)
+// COLOR button: changes color (sums 1 to minute when in MODE_CHANGE, repeats while hold)
 // LANGUAGE button: changes LANGUAGE
 
 void buttonCallback(uint8_t pin, uint8_t event) {
@@ -484,8 +1279,10 @@ void buttonCallback(uint8_t pin, uint8_t event) {
          case PIN_BUTTON_MODE:
             if (mode == MODE_CLOCK) {
                mode = MODE_CHANGE;
-               Serial.print(F("MODE: "));
-               Serial.println(mode);
+               #if LOG_LEVEL >= LOG_LEVEL_INFO
+                  logger.print(F("MODE: "));
+                  logger.println(mode);
+               #endif
             }
             break;
 
@@ -493,19 +1290,18 @@ void buttonCallback(uint8_t pin, uint8_t event) {
             if (mode == MODE_CHANGE || mode == MODE_CHANGED) {
                shiftTime(1, 0, 0);
             } else if (mode == MODE_CLOCK) {
-               if (brightness == 0) {
-                  brightness = 16;
+               if (brightness > 255 - BRIGHTNESS_STEP) {
+                  brightness = BRIGHTNESS_MIN;
                } else {
-                  brightness *= 2;
+                  brightness += BRIGHTNESS_STEP;
                }
-               if (brightness == 256) brightness = 0;
                eeprom_save();
             }
             break;
 
          case PIN_BUTTON_COLOR:
             if (mode == MODE_CHANGE || mode == MODE_CHANGED) {
-               shiftTime(0, rtc.now().minute() == 59 ? -59 : 1, 0);
+               shiftTime(0, DateTime(timeSource.now()).minute() == 59 ? -59 : 1, 0);
             } else if (mode == MODE_CLOCK) {
                color = (color + 1) % TOTAL_COLORS;
                eeprom_save();
@@ -514,17 +1310,32 @@ void buttonCallback(uint8_t pin, uint8_t event) {
 
          case PIN_BUTTON_LANGUAGE:
             if (mode == MODE_CLOCK) {
-               language = (language + 1) % TOTAL_LANGUAGES;
+               language = (language + 1) % languages_count;
                eeprom_save();
             }
             break;
 
       }
 
-      update(true);
+      update_pending = true;
 
    }
 
+   // Holding the hour or minute buttons while setting the time
+   // keeps shifting it
+   if (event == EVENT_REPEAT) {
+      if (mode == MODE_CHANGE || mode == MODE_CHANGED) {
+         if (pin == PIN_BUTTON_BRIGHTNESS) {
+            shiftTime(1, 0, 0);
+            update_pending = true;
+         }
+         if (pin == PIN_BUTTON_COLOR) {
+            shiftTime(0, DateTime(timeSource.now()).minute() == 59 ? -59 : 1, 0);
+            update_pending = true;
+         }
+      }
+   }
+
    if (event == EVENT_RELEASED) {
       if (pin == PIN_BUTTON_MODE) {
          if (mode == MODE_CHANGE) {
@@ -535,51 +1346,625 @@ void buttonCallback(uint8_t pin, uint8_t event) {
             mode = MODE_CLOCK;
          } else {
             mode = (mode + 1) % TOTAL_MODES;
+            text_return = MODE_TEXT;
             eeprom_save();
          }
-         Serial.print(F("MODE: "));
-         Serial.println(mode);
-         update(true);
+         #if LOG_LEVEL >= LOG_LEVEL_INFO
+            logger.print(F("MODE: "));
+            logger.println(mode);
+         #endif
+         update_pending = true;
       }
    }
 
 
 }
 
+// === COMMANDS ================================================================
+
+/**
+ * Stores a value little endian
+ * @param  byte * buffer          Where to store it
+ * @param  unsigned long value    Value
+ */
+void commandPutLong(byte * buffer, unsigned long value) {
+   for (byte i=0; i<4; i++) {
+      buffer[i] = value & 0xFF;
+      value >>= 8;
+   }
+}
+
+/**
+ * Reads a little endian value
+ * @param  const byte * buffer    Where to read it from
+ */
+unsigned long commandGetLong(const byte * buffer) {
+   unsigned long value = 0;
+   for (byte i=4; i>0; i--) value = (value << 8) | buffer[i-1];
+   return value;
+}
+
+/**
+ * Queues a reply frame, whole or not at all
+ * @param  byte command           Command
+ * @param  const byte * payload   Payload
+ * @param  byte length            Payload length
+ */
+void commandReply(byte command, const byte * payload, byte length) {
+   byte frame[COMMAND_REPLY_MAX + PROTOCOL_OVERHEAD];
+   logger.write(frame, Protocol::frame(frame, command, payload, length));
+}
+
+/**
+ * Replies with an error
+ * @param  byte command           Command that failed
+ * @param  byte error             ERROR_*
+ */
+void commandError(byte command, byte error) {
+   byte payload[2] = { command, error };
+   commandReply(COMMAND_ERROR, payload, 2);
+}
+
+/**
+ * Runs the command in the frame just received and replies
+ */
+void commandRun() {
+
+   byte command = protocol.command();
+   const byte * payload = protocol.payload();
+   byte length = protocol.length();
+   byte reply[COMMAND_REPLY_MAX];
+   byte size = 0;
+
+   switch (command) {
+
+      case COMMAND_PING:
+         reply[size++] = COMMAND_VERSION;
+         break;
+
+      case COMMAND_GET_TIME:
+         commandPutLong(reply, timeSource.now());
+         size = 4;
+         break;
+
+      case COMMAND_SET_TIME:
+         if (length != 4) {
+            commandError(command, ERROR_LENGTH);
+            return;
+         }
+         timeSource.adjust(commandGetLong(payload));
+         update_pending = true;
+         break;
+
+      case COMMAND_GET_SETTINGS:
+         reply[size++] = mode;
+         reply[size++] = language;
+         reply[size++] = color;
+         reply[size++] = brightness;
+         break;
+
+      case COMMAND_SET_SETTINGS:
+         if (length != 4) {
+            commandError(command, ERROR_LENGTH);
+            return;
+         }
+         if ((payload[0] >= TOTAL_MODES) || (payload[1] >= languages_count)
+            || (payload[2] >= TOTAL_COLORS) || (payload[3] < BRIGHTNESS_MIN)) {
+            commandError(command, ERROR_RANGE);
+            return;
+         }
+         mode = payload[0];
+         text_return = MODE_TEXT;
+         language = payload[1];
+         color = payload[2];
+         brightness = payload[3];
+         eeprom_save();
+         update_pending = true;
+         break;
+
+      #ifdef CAPTURE
+      case COMMAND_CAPTURE:
+         if (length != 2) {
+            commandError(command, ERROR_LENGTH);
+            return;
+         }
+         capture_period = payload[0] | (payload[1] << 8);
+         capture_last = millis() - capture_period;
+         capture_pending = true;
+         capture_colors = false;
+         capture_skipped = 0;
+         reply[size++] = MATRIX_WIDTH;
+         reply[size++] = MATRIX_HEIGHT;
+         reply[size++] = sizeof(row_t);
+         break;
+      #endif
+
+      case COMMAND_TEXT:
+         scroller.set((const char *) payload, length);
+         textMessage();
+         break;
+
+      case COMMAND_GET_STATS:
+         commandPutLong(&reply[0], frames_shown);
+         commandPutLong(&reply[4], frames_skipped);
+         commandPutLong(&reply[8], pixels_touched);
+         commandPutLong(&reply[12], rain.dropped());
+         commandPutLong(&reply[16], buttonChanges.overflows());
+         commandPutLong(&reply[20], logger.dropped());
+         commandPutLong(&reply[24], protocol.errors());
+         commandPutLong(&reply[28], idle.asleep());
+         commandPutLong(&reply[32], idle.awake());
+         commandPutLong(&reply[36], memoryMinFree());
+         size = COMMAND_STATS * 4;
+         break;
+
+      default:
+         commandError(command, ERROR_UNKNOWN);
+         return;
+
+   }
+
+   commandReply(command | COMMAND_REPLY, reply, size);
+
+}
+
+/**
+ * Runs a text command: 's' dumps the scheduler and sleep statistics,
+ * 'm' the RAM usage and 'p' the profiler ones. The dumps are long, the
+ * serial task writes them a line at a time
+ * @param  byte c                 Command
+ */
+void commandText(byte c) {
+   switch (c) {
+      case 's':
+         dump_pending |= 1 << DUMP_STATS;
+         break;
+      case 'm':
+         dump_pending |= 1 << DUMP_MEMORY;
+         break;
+      #ifdef PROFILER
+      case 'p':
+         dump_pending |= 1 << DUMP_PROFILER;
+         break;
+      #endif
+   }
+}
+
+/**
+ * Writes the next line of the first dump pending once the log is
+ * empty, the statistics dumped start over once it is done
+ */
+void dumpLoop() {
+
+   if ((dump_pending == 0) || (logger.room() < DUMP_ROOM)) return;
+
+   byte what = 0;
+   while (!(dump_pending & (1 << what))) what++;
+
+   bool more = false;
+   switch (what) {
+      case DUMP_STATS:
+         more = schedulerStatsDisplay(dump_line)
+            || idleStatsDisplay(dump_line - TOTAL_TASKS - 2);
+         break;
+      case DUMP_MEMORY:
+         more = memoryDisplay(dump_line);
+         break;
+      #ifdef PROFILER
+      case DUMP_PROFILER:
+         more = profilerDisplay(dump_line);
+         break;
+      #endif
+   }
+   dump_line++;
+   if (more) return;
+
+   if (what == DUMP_STATS) {
+      scheduler.reset();
+      idle.reset();
+   }
+   #ifdef PROFILER
+      if (what == DUMP_PROFILER) profiler.reset();
+   #endif
+   dump_pending &= ~(1 << what);
+   dump_line = 0;
+
+}
+
+// === CAPTURE =================================================================
+
+#ifdef CAPTURE
+
+/**
+ * Leds lit in a row of the frame shown, a fade shows the words leaving
+ * and the ones arriving
+ * @param  byte y             Row
+ */
+row_t captureRow(byte y) {
+   return fade_active ? frame_pattern[y] | frame_next[y] : frame_pattern[y];
+}
+
+/**
+ * CRC of the palette, to tell when it has changed
+ * @return unsigned int       CRC-16
+ */
+unsigned int capturePaletteCRC() {
+   unsigned int crc = 0xFFFF;
+   for (byte i=0; i<PALETTE_SIZE; i++) {
+      unsigned long color = matrix.getPalette(i);
+      crc = Settings::crc(crc, color >> 16);
+      crc = Settings::crc(crc, color >> 8);
+      crc = Settings::crc(crc, color);
+   }
+   return crc;
+}
+
+/**
+ * Streams every palette entry
+ */
+void capturePalette() {
+   byte crc = Protocol::begin(&logger, CAPTURE_PALETTE, PALETTE_SIZE * 3);
+   for (byte i=0; i<PALETTE_SIZE; i++) {
+      unsigned long color = matrix.getPalette(i);
+      crc = Protocol::write(&logger, crc, color >> 16);
+      crc = Protocol::write(&logger, crc, color >> 8);
+      crc = Protocol::write(&logger, crc, color);
+   }
+   Protocol::end(&logger, crc);
+}
+
+/**
+ * Streams the frame shown
+ * @param  bool single        Clock frame, one color for every lit led
+ * @param  byte length        Payload length
+ */
+void captureFrame(bool single, byte length) {
+
+   byte crc = Protocol::begin(&logger, single ? CAPTURE_CLOCK : CAPTURE_PIXELS, length);
+   unsigned int now = millis();
+   crc = Protocol::write(&logger, crc, capture_sequence++);
+   crc = Protocol::write(&logger, crc, now & 0xFF);
+   crc = Protocol::write(&logger, crc, now >> 8);
+   crc = Protocol::write(&logger, crc, frame_brightness);
+   if (single) {
+      crc = Protocol::write(&logger, crc, frame_color >> 16);
+      crc = Protocol::write(&logger, crc, frame_color >> 8);
+      crc = Protocol::write(&logger, crc, frame_color);
+   }
+
+   // rows with any led lit, then their masks
+   for (byte i=0; i<CAPTURE_ROWS; i++) {
+      byte bits = 0;
+      for (byte b=0; b<8; b++) {
+         byte y = (i << 3) + b;
+         if ((y < MATRIX_HEIGHT) && (captureRow(y) > 0)) bits |= 1 << b;
+      }
+      crc = Protocol::write(&logger, crc, bits);
+   }
+   for (byte y=0; y<MATRIX_HEIGHT; y++) {
+      row_t row = captureRow(y);
+      if (row == 0) continue;
+      for (byte i=0; i<sizeof(row_t); i++) {
+         crc = Protocol::write(&logger, crc, row & 0xFF);
+         row >>= 8;
+      }
+   }
+
+   // palette indexes, two leds per byte, first one in the low bits
+   if (!single) {
+      byte pair = 0;
+      bool half = false;
+      for (byte y=0; y<MATRIX_HEIGHT; y++) {
+         for (row_t row = captureRow(y); row > 0; row &= row - 1) {
+            byte index = matrix.getPixel(pixelIndex(rowFirst(row), y));
+            if (half) {
+               crc = Protocol::write(&logger, crc, pair | (index << 4));
+            } else {
+               pair = index;
+            }
+            half = !half;
+         }
+      }
+      if (half) crc = Protocol::write(&logger, crc, pair);
+   }
+
+   Protocol::end(&logger, crc);
+
+}
+
+/**
+ * Streams the frame shown if it has not been yet, at most one every
+ * capture_period ms and only once the log ring has room for all of it,
+ * so the render never waits for the port. Frames replaced before they
+ * could go are counted as skipped
+ */
+void captureLoop() {
+
+   if ((capture_period == 0) || !capture_pending) return;
+   if (millis() - capture_last < capture_period) return;
+
+   // size it first
+   bool single = frame_uniform && !fade_active;
+   unsigned int lit = 0;
+   byte rows = 0;
+   for (byte y=0; y<MATRIX_HEIGHT; y++) {
+      row_t row = captureRow(y);
+      if (row > 0) rows++;
+      for (; row > 0; row &= row - 1) lit++;
+   }
+   unsigned int length = CAPTURE_HEADER + CAPTURE_ROWS + rows * sizeof(row_t);
+   length += single ? 3 : (lit + 1) / 2;
+   if (length > 255) {
+      capture_pending = false;
+      capture_skipped++;
+      return;
+   }
+
+   // the palette goes before the first frame that needs it and then
+   // only when it changes, during fades
+   unsigned int crc = single ? 0 : capturePaletteCRC();
+   bool palette = !single && !(capture_colors && (crc == capture_crc));
+   unsigned int needed = length + PROTOCOL_OVERHEAD;
+   if (palette) needed += PALETTE_SIZE * 3 + PROTOCOL_OVERHEAD;
+   if (logger.room() < needed) return;
+
+   if (palette) {
+      capturePalette();
+      capture_crc = crc;
+      capture_colors = true;
+   }
+   captureFrame(single, length);
+   capture_pending = false;
+   capture_last = millis();
+
+}
+
+#endif
+
+// === TASKS ===================================================================
+
+/**
+ * Displays a line of the scheduler statistics, a task per line and
+ * then the queues that can lose data
+ * @param  byte line          Line
+ * @return bool               False past the last one
+ */
+bool schedulerStatsDisplay(byte line) {
+   if (line < TOTAL_TASKS) {
+      logger.print(F("Task "));
+      logger.print(line);
+      logger.print(F(": runs "));
+      logger.print(tasks[line].runs);
+      logger.print(F(", missed "));
+      logger.print(tasks[line].missed);
+      logger.print(F(", jitter max "));
+      logger.print(tasks[line].jitterMax);
+      logger.print(F("ms avg "));
+      logger.print(tasks[line].runs > 0 ? tasks[line].jitterSum / tasks[line].runs : 0);
+      logger.println(F("ms"));
+   } else if (line == TOTAL_TASKS) {
+      logger.print(F("Buttons: "));
+      logger.print(buttonChanges.overflows());
+      logger.println(F(" changes lost"));
+   } else if (line == TOTAL_TASKS + 1) {
+      logger.print(F("Serial: "));
+      logger.print(logger.dropped());
+      logger.print(F(" log bytes dropped, "));
+      logger.print(protocol.frames());
+      logger.print(F(" frames, "));
+      logger.print(protocol.errors());
+      logger.println(F(" errors"));
+   } else {
+      return false;
+   }
+   return true;
+}
+
+/**
+ * Displays the sleep statistics, a single line
+ * @param  byte line          Line
+ * @return bool               False past the last one
+ */
+bool idleStatsDisplay(byte line) {
+   if (line > 0) return false;
+   logger.print(F("Idle: asleep "));
+   logger.print(idle.asleep());
+   logger.print(F("ms, awake "));
+   logger.print(idle.awake());
+   logger.print(F("ms, wakes timer "));
+   logger.print(idle.wakes(IDLE_WAKE_TIMER));
+   logger.print(F(" button "));
+   logger.print(idle.wakes(IDLE_WAKE_BUTTON));
+   logger.print(F(" rtc "));
+   logger.println(idle.wakes(IDLE_WAKE_RTC));
+   return true;
+}
+
+#ifdef PROFILER
+/**
+ * Displays a line of the profiler statistics, a section per line and
+ * then the loop period
+ * @param  byte line          Line
+ * @return bool               False past the last one
+ */
+bool profilerDisplay(byte line) {
+   switch (line) {
+      case 0: profiler.dump(&logger, F("buttons"), PROFILE_BUTTONS); break;
+      case 1: profiler.dump(&logger, F("rtc"), PROFILE_RTC); break;
+      case 2: profiler.dump(&logger, F("pattern"), PROFILE_PATTERN); break;
+      case 3: profiler.dump(&logger, F("fill"), PROFILE_FILL); break;
+      case 4: profiler.dump(&logger, F("show"), PROFILE_SHOW); break;
+      case 5: profiler.dumpLoop(&logger); break;
+      default: return false;
+   }
+   return true;
+}
+#endif
+
+/**
+ * Runs the buttons with their levels at a given time
+ * @param  byte levels            Bit i is the level of button i
+ * @param  unsigned long at       millis() of the levels
+ */
+void buttonsRun(byte levels, unsigned long at) {
+   // a change queued while the last pass ran counts from that pass,
+   // the buttons need their readings in time order
+   if ((long) (at - buttons_at) < 0) at = buttons_at;
+   buttons_at = at;
+   buttons_levels = levels;
+   for (byte i=0; i<TOTAL_BUTTONS; i++) {
+      buttons[i].loop((levels >> i) & 1 ? HIGH : LOW, at);
+   }
+}
+
+/**
+ * Replays the queued button edges, then lets the buttons time out
+ * their debounce, long press and repeat up to now. The pass up to now
+ * takes the latest levels seen, edges lost to a full queue included
+ */
+void buttonsTask() {
+   PROFILE_START(PROFILE_BUTTONS);
+   pin_change_t change;
+   while (buttonChanges.read(&change)) {
+      buttonsRun(change.levels, change.at);
+   }
+   buttonsRun(buttonChanges.levels(), millis());
+   PROFILE_STOP(PROFILE_BUTTONS);
+}
+
+/**
+ * Keeps the time in sync with the RTC. Showing a frame turns interrupts
+ * off long enough to lose millis() ticks, the strip gives them back as
+ * counted from the timer phase, so without the square wave the RTC is
+ * read every time the task finds frames have been shown
+ */
+void rtcTask() {
+   #ifndef PIN_RTC_SQW
+      if (frames_shown != rtc_frames) {
+         rtc_frames = frames_shown;
+         timeSource.resync();
+         return;
+      }
+   #endif
+   timeSource.loop();
+}
+
+void renderTask() {
+   bool force = update_pending;
+   update_pending = false;
+   update(force);
+   #ifdef CAPTURE
+      captureLoop();
+   #endif
+}
+
+// Serial input is parsed as it comes, a byte at a time, and the log
+// and the dumps move to the port as it makes room
+void serialTask() {
+   while (Serial.available() > 0) {
+      byte c = Serial.read();
+      switch (protocol.feed(c, millis())) {
+         case PROTOCOL_FRAME:
+            commandRun();
+            break;
+         case PROTOCOL_TEXT:
+            commandText(c);
+            break;
+         case PROTOCOL_OVERSIZE:
+            commandError(protocol.command(), ERROR_LENGTH);
+            break;
+      }
+   }
+   dumpLoop();
+   logger.loop();
+}
+
+void eepromTask() {
+   eeprom_flush();
+}
+
+// Warns once when the stack has come too close to the heap
+void memoryTask() {
+   static bool warned = false;
+   if (!warned && memoryLow()) {
+      #if LOG_LEVEL >= LOG_LEVEL_WARNING
+         logger.print(F("WARNING: low RAM, "));
+         logger.print(memoryMinFree());
+         logger.println(F(" bytes left"));
+      #endif
+      warned = true;
+   }
+}
+
 void setup() {
 
    Serial.begin(SERIAL_BAUD);
 
    // Config RTC
    if (!rtc.begin()) {
-      Serial.println(F("Couldn't find RTC"));
+      #if LOG_LEVEL >= LOG_LEVEL_ERROR
+         logger.println(F("Couldn't find RTC"));
+         logger.flush();
+      #endif
       while(1);
    }
-   if (!rtc.isrunning()) {
+   bool time_lost = !rtc.isrunning();
+   if (time_lost) {
       resetTime();
    }
 
-   // Initialise random number generation
-   randomSeed(rtc.now().unixtime());
+   // Start extrapolating time from the RTC
+   #ifdef PIN_RTC_SQW
+      rtc.writeSqwPinMode(SquareWave1HZ);
+      pinMode(PIN_RTC_SQW, INPUT_PULLUP);
+      attachInterrupt(digitalPinToInterrupt(PIN_RTC_SQW), rtcTick, FALLING);
+      timeSource.begin(true);
+   #else
+      timeSource.begin();
+   #endif
+
+   // Seed the rain, a fixed seed plays the same animation every time
+   #ifdef MATRIX_SEED
+      rain.begin(MATRIX_SEED, UPDATE_MATRIX);
+   #else
+      rain.begin(timeSource.now(), UPDATE_MATRIX);
+   #endif
 
    // Start display and initialize all to OFF
    matrix.begin();
+   #ifdef DITHER
+      matrix.setDither(true);
+   #endif
    matrix.show();
 
    // get stored values from EEPROM
    eeprom_retrieve();
 
-}
+   // a clock that lost its time says so before showing it
+   scroller.begin(TEXT_PERIOD);
+   if (time_lost) {
+      scroller.set(F("RTC RESET"));
+      textMessage();
+   }
 
-void loop() {
+   // Capture button edges from now on
+   buttonChanges.begin(button_pins, TOTAL_BUTTONS, buttonsWake);
+   buttons_levels = buttonChanges.levels();
+   buttons_at = millis();
 
-   // Debounce buttons
-   buttonHour.loop();
-   buttonMinute.loop();
-   buttonMode.loop();
-   buttonFunction.loop();
+   // Start running tasks
+   #ifdef PROFILER
+      profiler.begin();
+   #endif
+   scheduler.begin();
+   idle.begin();
 
-   // Update display
-   update();
+}
 
+void loop() {
+   PROFILE_LOOP();
+   if (scheduler.loop()) return;
+   #ifdef IDLE_SLEEP
+      idle.sleep(scheduler.next());
+   #endif
 }
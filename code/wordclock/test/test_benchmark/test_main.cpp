@@ -0,0 +1,307 @@
+/*
+
+  Word Clock, host benchmark of the language and rendering hot paths
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include <unity.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_CYCLES() __rdtsc()
+#else
+#define BENCHMARK_CYCLES() 0ULL
+#endif
+
+#include "../../src/wordclock.ino"
+
+#define BENCHMARK_ROUNDS 20
+#define BENCHMARK_ITERATIONS 100000
+#define BENCHMARK_FRAMES 10000
+
+volatile unsigned long benchmark_sink = 0;
+
+struct benchmark_t {
+   unsigned long long ns;
+   unsigned long long cycles;
+};
+
+unsigned long long benchmarkClock() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void benchmarkStart(benchmark_t * b) {
+   b->ns = benchmarkClock();
+   b->cycles = BENCHMARK_CYCLES();
+}
+
+/**
+ * Reports the host time per call, and the cycles of the host time
+ * stamp counter where there is one
+ * @param  benchmark_t * b        Started with benchmarkStart()
+ * @param  const char * name      Name of the benchmarked code
+ * @param  unsigned long calls    Number of calls
+ */
+void benchmarkStop(benchmark_t * b, const char * name, unsigned long calls) {
+   unsigned long long cycles = BENCHMARK_CYCLES() - b->cycles;
+   unsigned long long ns = benchmarkClock() - b->ns;
+   char message[128];
+   snprintf(message, sizeof(message), "%s: %.1fns/call, %llu cycles/call", name,
+      (double) ns / calls, cycles / calls);
+   TEST_MESSAGE(message);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Languages, every minute of the day
+void test_loadLanguage(void) {
+   row_t pattern[MATRIX_HEIGHT];
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (byte round=0; round<BENCHMARK_ROUNDS; round++) {
+      for (byte lang=0; lang<languages_count; lang++) {
+         for (byte hour=0; hour<24; hour++) {
+            for (byte minute=0; minute<60; minute++) {
+               loadLanguage(lang, hour, minute, pattern);
+               benchmark_sink += pattern[hour % MATRIX_HEIGHT];
+            }
+         }
+      }
+   }
+   benchmarkStop(&b, "loadLanguage", BENCHMARK_ROUNDS * languages_count * 24 * 60);
+}
+
+void test_loadSentence(void) {
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (byte round=0; round<BENCHMARK_ROUNDS; round++) {
+      for (byte lang=0; lang<languages_count; lang++) {
+         for (byte hour=0; hour<24; hour++) {
+            for (byte minute=0; minute<60; minute++) {
+               loadSentence(lang, hour, minute, &time_sentence);
+               TEST_ASSERT_GREATER_THAN(0, time_sentence.count);
+            }
+         }
+      }
+   }
+   benchmarkStop(&b, "loadSentence", BENCHMARK_ROUNDS * languages_count * 24 * 60);
+}
+
+// Pixel mapping, the whole matrix
+void test_pixelIndex(void) {
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS / 10; i++) {
+      for (byte y=0; y<MATRIX_HEIGHT; y++) {
+         for (byte x=0; x<MATRIX_WIDTH; x++) {
+            benchmark_sink += pixelIndex(x, y);
+         }
+      }
+   }
+   benchmarkStop(&b, "pixelIndex", (BENCHMARK_ITERATIONS / 10) * TOTAL_PIXELS);
+}
+
+// Pattern based rendering
+void test_countLEDs(void) {
+   loadTimePattern(true);
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      benchmark_sink += countLEDs();
+   }
+   benchmarkStop(&b, "countLEDs", BENCHMARK_ITERATIONS);
+}
+
+void test_loadTimeInMatrix(void) {
+   loadTimePattern(true);
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      frameBegin(DEFAULT_BRIGHTNESS);
+      loadTimeInMatrix(time_pattern, PALETTE_WORD);
+   }
+   benchmarkStop(&b, "frameBegin + loadTimeInMatrix", BENCHMARK_ITERATIONS);
+}
+
+// Rendering cost follows the lit leds, not the matrix size
+void test_loadTimeInMatrixEmptyFull(void) {
+   row_t pattern[MATRIX_HEIGHT];
+   benchmark_t b;
+
+   for (byte y=0; y<MATRIX_HEIGHT; y++) pattern[y] = 0;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      frameBegin(DEFAULT_BRIGHTNESS);
+      loadTimeInMatrix(pattern, PALETTE_WORD);
+   }
+   benchmarkStop(&b, "frameBegin + loadTimeInMatrix (empty)", BENCHMARK_ITERATIONS);
+
+   for (byte y=0; y<MATRIX_HEIGHT; y++) pattern[y] = ~(row_t) 0;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS / 10; i++) {
+      frameBegin(DEFAULT_BRIGHTNESS);
+      loadTimeInMatrix(pattern, PALETTE_WORD);
+   }
+   benchmarkStop(&b, "frameBegin + loadTimeInMatrix (full)", BENCHMARK_ITERATIONS / 10);
+}
+
+/**
+ * Sets a pattern with lit leds spread over the matrix
+ * @param  row_t * pattern        Pattern
+ * @param  unsigned int lit       Leds to light
+ */
+void benchmarkPattern(row_t * pattern, unsigned int lit) {
+   for (byte y=0; y<MATRIX_HEIGHT; y++) pattern[y] = 0;
+   for (unsigned int i=0; i<lit; i++) {
+      unsigned int n = (unsigned long) i * TOTAL_PIXELS / lit;
+      pattern[n / MATRIX_WIDTH] |= (row_t) 1 << (n % MATRIX_WIDTH);
+   }
+}
+
+/**
+ * Draws a pattern testing every led of the matrix, as the renderers did
+ * before rowFirst(), to compare with
+ */
+void benchmarkScan(row_t * pattern, byte index) {
+   for (byte y=0; y<MATRIX_HEIGHT; y++) {
+      for (byte x=0; x<MATRIX_WIDTH; x++) {
+         if (pattern[y] & ((row_t) 1 << x)) frameSetPixel(x, y, index);
+      }
+   }
+}
+
+// The cost of drawing a pattern grows with its lit leds, only they are
+// visited, where a scan of the matrix costs the same for any pattern
+void test_rowScaling(void) {
+   const unsigned int lits[] = { 0, 8, 32, 128, TOTAL_PIXELS };
+   row_t pattern[MATRIX_HEIGHT];
+   char name[64];
+   benchmark_t b;
+
+   for (byte i=0; i<sizeof(lits) / sizeof(lits[0]); i++) {
+      benchmarkPattern(pattern, lits[i]);
+
+      // every lit led is drawn once, nothing else
+      unsigned long touched = pixels_touched;
+      frameBegin(DEFAULT_BRIGHTNESS);
+      loadTimeInMatrix(pattern, PALETTE_WORD);
+      TEST_ASSERT_EQUAL(lits[i], pixels_touched - touched);
+      TEST_ASSERT_EQUAL_MEMORY(pattern, frame_next, sizeof(pattern));
+
+      benchmarkStart(&b);
+      for (unsigned long n=0; n<BENCHMARK_ITERATIONS / 10; n++) {
+         frameBegin(DEFAULT_BRIGHTNESS);
+         loadTimeInMatrix(pattern, PALETTE_WORD);
+      }
+      snprintf(name, sizeof(name), "loadTimeInMatrix, %d lit", lits[i]);
+      benchmarkStop(&b, name, BENCHMARK_ITERATIONS / 10);
+
+      benchmarkStart(&b);
+      for (unsigned long n=0; n<BENCHMARK_ITERATIONS / 10; n++) {
+         frameBegin(DEFAULT_BRIGHTNESS);
+         benchmarkScan(pattern, PALETTE_WORD);
+      }
+      snprintf(name, sizeof(name), "matrix scan, %d lit", lits[i]);
+      benchmarkStop(&b, name, BENCHMARK_ITERATIONS / 10);
+   }
+}
+
+// A brightness change rescales the 16 palette entries through the
+// gamma table, the pixels are not touched
+void test_setBrightness(void) {
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      matrix.setBrightness(i);
+   }
+   benchmarkStop(&b, "PaletteStrip::setBrightness", BENCHMARK_ITERATIONS);
+   matrix.setBrightness(frame_brightness);
+}
+
+// Matrix effect steps, then full frames as updateMatrix() draws them,
+// show() included
+void test_matrixStep(void) {
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      benchmark_sink += matrixStep();
+   }
+   benchmarkStop(&b, "matrixStep", BENCHMARK_ITERATIONS);
+}
+
+void test_matrixFrame(void) {
+   benchmark_t b;
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_FRAMES; i++) {
+      matrixDraw(matrixStep());
+   }
+   benchmarkStop(&b, "matrixFrame", BENCHMARK_FRAMES);
+}
+
+// Text, a column step draws two windows, the frames in between only
+// move the blend in the palette, both including show()
+void test_text(void) {
+   benchmark_t b;
+   scroller.set(F("18/10/2015"));
+
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_ITERATIONS; i++) {
+      text_row_t rows[FONT_HEIGHT] = {0};
+      scroller.draw(rows, i % scroller.columns());
+      benchmark_sink += rows[FONT_HEIGHT / 2];
+   }
+   benchmarkStop(&b, "TextScroll::draw", BENCHMARK_ITERATIONS);
+
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_FRAMES; i++) {
+      textPalette(0);
+      textDraw(i % scroller.columns());
+   }
+   benchmarkStop(&b, "textFrame (step)", BENCHMARK_FRAMES);
+
+   benchmarkStart(&b);
+   for (unsigned long i=0; i<BENCHMARK_FRAMES; i++) {
+      textPalette(i);
+      frameShow(true);
+   }
+   benchmarkStop(&b, "textFrame (blend)", BENCHMARK_FRAMES);
+}
+
+int main(int argc, char **argv) {
+   nativeReset();
+   setup();
+   UNITY_BEGIN();
+   RUN_TEST(test_loadLanguage);
+   RUN_TEST(test_loadSentence);
+   RUN_TEST(test_pixelIndex);
+   RUN_TEST(test_countLEDs);
+   RUN_TEST(test_loadTimeInMatrix);
+   RUN_TEST(test_loadTimeInMatrixEmptyFull);
+   RUN_TEST(test_rowScaling);
+   RUN_TEST(test_setBrightness);
+   RUN_TEST(test_matrixStep);
+   RUN_TEST(test_matrixFrame);
+   RUN_TEST(test_text);
+   return UNITY_END();
+}
@@ -0,0 +1,184 @@
+/*
+
+  Word Clock, button events
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+#include "debounceEvent.h"
+
+#define PIN 4
+#define EVENTS 64
+
+// Events raised, in order
+uint8_t events[EVENTS];
+unsigned long events_at[EVENTS];
+byte events_count = 0;
+unsigned long current = 0;
+
+void callback(uint8_t pin, uint8_t event) {
+  TEST_ASSERT_EQUAL(PIN, pin);
+  if (event == EVENT_CHANGED) return;
+  TEST_ASSERT_LESS_THAN(EVENTS, events_count);
+  events_at[events_count] = current;
+  events[events_count++] = event;
+}
+
+byte count(uint8_t event) {
+  byte n = 0;
+  for (byte i=0; i<events_count; i++) {
+    if (events[i] == event) n++;
+  }
+  return n;
+}
+
+/**
+ * Polls the button every millisecond up to a time
+ * @param  DebounceEvent * button Button
+ * @param  uint8_t reading        Pin level meanwhile
+ * @param  unsigned long until    Time to stop at
+ */
+void poll(DebounceEvent * button, uint8_t reading, unsigned long until) {
+  for (; current < until; current++) button->loop(reading, current);
+}
+
+void setUp(void) {
+  events_count = 0;
+  current = 1000;
+}
+
+void tearDown(void) {
+}
+
+void test_press_release(void) {
+  DebounceEvent button(PIN, callback);
+  poll(&button, LOW, 1000 + DEBOUNCE_DELAY - 1);
+  TEST_ASSERT_EQUAL(0, events_count);
+  poll(&button, LOW, 1000 + DEBOUNCE_DELAY + 1);
+  TEST_ASSERT_EQUAL(1, events_count);
+  TEST_ASSERT_EQUAL(EVENT_PRESSED, events[0]);
+  TEST_ASSERT_EQUAL(1000 + DEBOUNCE_DELAY, events_at[0]);
+  poll(&button, HIGH, 1400);
+  TEST_ASSERT_EQUAL(2, events_count);
+  TEST_ASSERT_EQUAL(EVENT_RELEASED, events[1]);
+}
+
+void test_bounce(void) {
+  DebounceEvent button(PIN, callback);
+  for (byte i=0; i<10; i++) {
+    poll(&button, LOW, current + 5);
+    poll(&button, HIGH, current + 5);
+  }
+  TEST_ASSERT_EQUAL(0, events_count);
+  unsigned long settled = current;
+  poll(&button, LOW, current + DEBOUNCE_DELAY + 1);
+  TEST_ASSERT_EQUAL(1, events_count);
+  TEST_ASSERT_EQUAL(settled + DEBOUNCE_DELAY, events_at[0]);
+}
+
+void test_long_press(void) {
+  DebounceEvent button(PIN, callback);
+  poll(&button, LOW, 1000 + DEBOUNCE_DELAY + LONG_PRESS_DELAY * 3);
+  TEST_ASSERT_EQUAL(1, count(EVENT_LONG_PRESS));
+  for (byte i=0; i<events_count; i++) {
+    if (events[i] == EVENT_LONG_PRESS) {
+      TEST_ASSERT_EQUAL(1000 + DEBOUNCE_DELAY + LONG_PRESS_DELAY, events_at[i]);
+    }
+  }
+  poll(&button, HIGH, current + DEBOUNCE_DELAY + 1);
+  poll(&button, LOW, current + DEBOUNCE_DELAY + LONG_PRESS_DELAY / 2);
+  TEST_ASSERT_EQUAL(1, count(EVENT_LONG_PRESS));
+}
+
+void test_double_click(void) {
+  DebounceEvent button(PIN, callback);
+  poll(&button, LOW, 1200);
+  poll(&button, HIGH, 1400);
+  poll(&button, LOW, 1600);
+  TEST_ASSERT_EQUAL(1, count(EVENT_DOUBLE_CLICK));
+  TEST_ASSERT_EQUAL(EVENT_PRESSED, events[events_count - 2]);
+  TEST_ASSERT_EQUAL(EVENT_DOUBLE_CLICK, events[events_count - 1]);
+}
+
+void test_double_click_late(void) {
+  DebounceEvent button(PIN, callback);
+  poll(&button, LOW, 1200);
+  poll(&button, HIGH, 1200 + DEBOUNCE_DELAY + DOUBLE_CLICK_DELAY);
+  poll(&button, LOW, current + 200);
+  TEST_ASSERT_EQUAL(0, count(EVENT_DOUBLE_CLICK));
+}
+
+void test_repeat(void) {
+  DebounceEvent button(PIN, callback);
+  unsigned long pressed = 1000 + DEBOUNCE_DELAY;
+  poll(&button, LOW, pressed + REPEAT_DELAY + REPEAT_INTERVAL * 4 + 1);
+  TEST_ASSERT_EQUAL(5, count(EVENT_REPEAT));
+  byte n = 0;
+  for (byte i=0; i<events_count; i++) {
+    if (events[i] == EVENT_REPEAT) {
+      TEST_ASSERT_EQUAL(pressed + REPEAT_DELAY + REPEAT_INTERVAL * n, events_at[i]);
+      n++;
+    }
+  }
+  poll(&button, HIGH, current + DEBOUNCE_DELAY + REPEAT_INTERVAL * 4);
+  TEST_ASSERT_EQUAL(5, count(EVENT_REPEAT));
+}
+
+void test_repeat_stall(void) {
+  DebounceEvent button(PIN, callback);
+  unsigned long pressed = 1000 + DEBOUNCE_DELAY;
+  poll(&button, LOW, pressed + REPEAT_DELAY + 1);
+  TEST_ASSERT_EQUAL(1, count(EVENT_REPEAT));
+
+  // the loop stalls for ten intervals: one repeat, then the usual pace
+  current += REPEAT_INTERVAL * 10;
+  button.loop(LOW, current);
+  TEST_ASSERT_EQUAL(2, count(EVENT_REPEAT));
+  button.loop(LOW, current + 1);
+  TEST_ASSERT_EQUAL(2, count(EVENT_REPEAT));
+  unsigned long stalled = current;
+  poll(&button, LOW, stalled + REPEAT_INTERVAL + 1);
+  TEST_ASSERT_EQUAL(3, count(EVENT_REPEAT));
+  TEST_ASSERT_EQUAL(stalled + REPEAT_INTERVAL, events_at[events_count - 1]);
+}
+
+void test_replay(void) {
+  DebounceEvent button(PIN, callback);
+
+  // readings from a pin change queue: the press lasted long enough
+  // even if the next reading comes much later
+  button.loop(LOW, 1000);
+  current = 1500;
+  button.loop(HIGH, 1500);
+  TEST_ASSERT_EQUAL(1, count(EVENT_PRESSED));
+  poll(&button, HIGH, 1500 + DEBOUNCE_DELAY + 1);
+  TEST_ASSERT_EQUAL(1, count(EVENT_RELEASED));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_press_release);
+  RUN_TEST(test_bounce);
+  RUN_TEST(test_long_press);
+  RUN_TEST(test_double_click);
+  RUN_TEST(test_double_click_late);
+  RUN_TEST(test_repeat);
+  RUN_TEST(test_repeat_stall);
+  RUN_TEST(test_replay);
+  return UNITY_END();
+}
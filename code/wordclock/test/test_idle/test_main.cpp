@@ -0,0 +1,165 @@
+/*
+
+  Word Clock, time the CPU sleeps on the native clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <unity.h>
+
+#include "../../src/wordclock.ino"
+
+// Clicks per run, a press and its release apart in microseconds, far
+// enough from the next press not to make a double click
+#define CLICKS 20
+#define CLICK_HOLD 150000UL
+#define CLICK_GAP (DOUBLE_CLICK_DELAY + 100)
+
+// Per mille of the wall time left to sleep with a frame every render,
+// the shows keep the CPU awake
+#define SHOWING_ASLEEP (1000 - TOTAL_PIXELS * PALETTE_LED_TIME / UPDATE_MATRIX)
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+/**
+ * Runs the sketch for a while
+ * @param  unsigned long ms       Wall time to run
+ */
+void run(unsigned long ms) {
+   unsigned long long until = nativeNow() + ms * 1000ULL;
+   while (nativeNow() < until) loop();
+}
+
+/**
+ * Color button edges, raised as the pin change interrupt would
+ */
+void colorPress() {
+   nativeSetPin(PIN_BUTTON_COLOR, LOW);
+   buttonChanges.sample();
+}
+
+void colorRelease() {
+   nativeSetPin(PIN_BUTTON_COLOR, HIGH);
+   buttonChanges.sample();
+}
+
+/**
+ * Runs the sketch and reports the share of the wall time spent asleep.
+ * micros() loses the ticks of the shows, millis() is given them back,
+ * so the time they take is counted neither asleep nor awake
+ * @param  const char * name      What runs
+ * @param  unsigned long ms       Wall time to run
+ * @return unsigned int           Per mille of the wall time asleep
+ */
+unsigned int asleep(const char * name, unsigned long ms) {
+   char message[96];
+   frames_shown = 0;
+   idle.reset();
+   run(ms);
+   unsigned long asleep = idle.asleep();
+   unsigned long awake = idle.awake();
+   unsigned int ratio = asleep * 1000UL / ms;
+   snprintf(message, sizeof(message), "%s: %lums asleep, %lums awake, %lums shows, %u.%u%% asleep, %lu frames",
+      name, asleep, awake, ms - asleep - awake, ratio / 10, ratio % 10, frames_shown);
+   TEST_MESSAGE(message);
+   return ratio;
+}
+
+/**
+ * Clicks the color button at times that fall anywhere in the render
+ * period, every click has to change the color
+ */
+void clicks() {
+   unsigned long seed = 1;
+   for (byte i=0; i<CLICKS; i++) {
+      byte expected = (color + 1) % TOTAL_COLORS;
+      unsigned long wakes = idle.wakes(IDLE_WAKE_BUTTON);
+      seed = seed * 1103515245UL + 12345UL;
+      unsigned long offset = (seed >> 8) % (UPDATE_MATRIX * 1000UL);
+      nativeInterrupt(offset, colorPress);
+      nativeInterrupt(offset + CLICK_HOLD, colorRelease);
+      run(CLICK_HOLD / 1000 + CLICK_GAP);
+      TEST_ASSERT_EQUAL(expected, color);
+      TEST_ASSERT_EQUAL(HIGH, (buttons_levels >> 1) & 1);
+      TEST_ASSERT_TRUE(idle.wakes(IDLE_WAKE_BUTTON) - wakes >= 2);
+   }
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * The clock shows a frame a minute, the CPU sleeps nearly all the time
+ * and wakes for every button edge
+ */
+void test_clock(void) {
+   matrix.setDither(false);
+   mode = MODE_CLOCK;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+   TEST_ASSERT_GREATER_OR_EQUAL(990, asleep("clock", 60000UL));
+   clicks();
+}
+
+/**
+ * Dithering shows a frame every render, the show keeps interrupts off
+ * and the CPU awake for 7.7ms of every 20ms. Button edges raised
+ * meanwhile are still served
+ */
+void test_dither(void) {
+   matrix.setDither(true);
+   mode = MODE_CLOCK;
+   brightness = BRIGHTNESS_MIN + BRIGHTNESS_STEP;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+   TEST_ASSERT_TRUE(matrix.dithering());
+   unsigned int ratio = asleep("clock, dithered", 10000UL);
+   TEST_ASSERT_UINT_WITHIN(30, SHOWING_ASLEEP, ratio);
+   clicks();
+   matrix.setDither(false);
+}
+
+/**
+ * The matrix effect shows a frame every render as well
+ */
+void test_matrix(void) {
+   mode = MODE_MATRIX;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+   unsigned int ratio = asleep("matrix", 10000UL);
+   TEST_ASSERT_UINT_WITHIN(30, SHOWING_ASLEEP, ratio);
+}
+
+int main(int argc, char **argv) {
+   nativeReset();
+   rtc.adjust(DateTime(2016, 1, 1, 10, 0, 0));
+   setup();
+   UNITY_BEGIN();
+   RUN_TEST(test_clock);
+   RUN_TEST(test_dither);
+   RUN_TEST(test_matrix);
+   return UNITY_END();
+}
@@ -0,0 +1,534 @@
+/*
+
+  Original language code, the branch trees the generated word tables
+  replaced. Kept as the reference the tables are tested against
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include "reference.h"
+
+struct reference_word {
+  byte row;
+  unsigned int positions;
+};
+
+static void referenceCode(reference_word code, unsigned int * matrix) {
+  matrix[code.row] = matrix[code.row] | code.positions;
+}
+
+#define CAT_ES          {0, 0xC000}
+#define CAT_SON         {0, 0x7000}
+#define CAT_VORA        {0, 0x00F0}
+#define CAT_UN_Q        {1, 0xC000}
+#define CAT_DOS_Q       {1, 0x3800}
+#define CAT_TRES_Q      {1, 0x0780}
+#define CAT_MIG         {1, 0x0007}
+#define CAT_QUART       {2, 0xF800}
+#define CAT_QUARTS      {2, 0xFC00}
+#define CAT_I           {2, 0x0100}
+#define CAT_I_MIG       {2, 0x0107}
+#define CAT_MENYS       {2, 0x00F8}
+#define CAT_CINC_Q      {3, 0xF000}
+#define CAT_BEN_Q       {3, 0x0700}
+#define CAT_TOCAT       {3, 0x003E}
+#define CAT_TOCATS      {3, 0x003F}
+#define CAT_LES         {4, 0xE000}
+#define CAT_DE          {4, 0x1800}
+#define CAT_LA          {4, 0x0600}
+#define CAT_DUES        {4, 0x00F0}
+#define CAT_SIS         {4, 0x001C}
+#define CAT_SET         {4, 0x0007}
+#define CAT_CINC        {5, 0xF000}
+#define CAT_VUIT        {5, 0x00F0}
+#define CAT_UNA         {5, 0x0007}
+#define CAT_D_UNA       {5, 0x000F}
+#define CAT_DOS         {6, 0xE000}
+#define CAT_QUATRE      {7, 0xFC00}
+#define CAT_TRES        {7, 0x1E00}
+#define CAT_ONZE        {9, 0x7800}
+#define CAT_D_ONZE      {9, 0xF800}
+#define CAT_DOTZE       {9, 0x07C0}
+#define CAT_NOU         {9, 0x0038}
+#define CAT_DEU         {9, 0x0007}
+#define CAT_BEN         {12, 0xE000}
+#define CAT_TOCADES     {12, 0x0FE0}
+#define CAT_EN_PUNT     {12, 0x601E}
+#define CAT_TOCADA      {13, 0xFC00}
+#define CAT_DE_F        {14, 0xC000}
+#define CAT_DEL         {14, 0xE000}
+#define CAT_LA_F        {14, 0x1800}
+#define CAT_MATI        {14, 0x0780}
+#define CAT_NIT         {14, 0x0070}
+#define CAT_TARDA       {14, 0x001F}
+
+#define ESP_ES          {0, 0x0C00}
+#define ESP_SON         {0, 0x0700}
+#define ESP_CASI        {0, 0x000F}
+#define ESP_LA          {4, 0x0600}
+#define ESP_LAS         {4, 0x0700}
+#define ESP_CINCO       {5, 0xF800}
+#define ESP_OCHO        {5, 0x0F00}
+#define ESP_UNA         {5, 0x0007}
+#define ESP_DOS         {6, 0xE000}
+#define ESP_NUEVE       {6, 0x1F00}
+#define ESP_DIEZ        {6, 0x00F0}
+#define ESP_ONCE        {6, 0x000F}
+#define ESP_TRES        {7, 0x1E00}
+#define ESP_SEIS        {7, 0x03C0}
+#define ESP_CUATRO      {7, 0x003F}
+#define ESP_SIETE       {8, 0xF800}
+#define ESP_DOCE        {8, 0x0780}
+#define ESP_Y           {8, 0x0020}
+#define ESP_MENOS       {8, 0x001F}
+#define ESP_VEINTICINCO {10, 0xFFE0}
+#define ESP_CINCO_B     {10, 0x03E0}
+#define ESP_MEDIA       {10, 0x001F}
+#define ESP_CUARTO      {11, 0xFC00}
+#define ESP_DIEZ_B      {11, 0x03C0}
+#define ESP_VEINTE      {11, 0x003F}
+#define ESP_EN_PUNTO    {12, 0x601F}
+#define ESP_PASADA      {13, 0x03F0}
+#define ESP_PASADAS     {13, 0x03F8}
+#define ESP_DE_F        {14, 0xC000}
+#define ESP_LA_F        {14, 0x1800}
+#define ESP_MANANA      {15, 0xFC00}
+#define ESP_TARDE       {15, 0x03E0}
+#define ESP_NOCHE       {15, 0x001F}
+
+void referenceCatalan(byte hour, byte minute, unsigned int * matrix) {
+
+  /*
+
+  00 => en punt
+  01 => tocada/es
+  02 => tocada/es
+  03 => ben tocada/es
+  04 => ben tocada/es
+
+  05 => vora mig quart
+
+  06 => vora mig quart
+  07 => mig quart
+  08 => mig quart tocat
+  09 => vora un quart menys 5
+  10 => un quart menys 5
+  11 => un quart menys 5 tocat
+  12 => un quart menys 5 tocat
+  13 => un quart menys 5 ben tocat
+  14 => vora un quart
+  15 => un quart
+  16 => un quart tocat
+  17 => un quart tocat
+  18 => un quart ben tocat
+  19 => vora un quart i 5
+  20 => un quart i 5
+
+  21 => vora un quart i mig
+  22 => un quart i mig
+  23 => un quart i mig tocat
+  24 => vora dos quarts menys 5
+  25 => dos quarts menys 5
+  26 => dos quarts menys 5 tocats
+  27 => dos quarts menys 5 tocats
+  28 => dos quarts menys 5 ben tocats
+  29 => vora dos quarts
+  30 => dos quarts
+  31 => dos quarts tocats
+  32 => dos quarts tocats
+  33 => dos quarts ben tocats
+  34 => vora dos quarts i 5
+  35 => dos quarts i 5
+
+  36 => vora dos quarts i mig
+  37 => dos quarts i mig
+  38 => dos quarts i mig tocats
+  39 => vora tres quarts menys 5
+  40 => tres quarts menys 5
+  41 => tres quarts menys 5 tocats
+  42 => tres quarts menys 5 tocats
+  43 => tres quarts menys 5 ben tocats
+  44 => vora tres quarts
+  45 => tres quarts
+  46 => tres quarts tocats
+  47 => tres quarts tocats
+  48 => tres quarts ben tocats
+  49 => vora tres quarts i 5
+  50 => tres quarts i 5
+
+  51 => vora tres quart i mig
+  52 => tres quarts i mig
+  53 => tres quarts i mig tocats
+  54 => vora menys 5
+  55 => menys 5
+  56 => menys 5 tocats
+  57 => menys 5 tocats
+  58 => menys 5 ben tocats
+  59 => vora
+
+  */
+
+  // indica si l'hora es referencia a l'actual o la posterior
+  bool hour_is_current = (minute < 5);
+
+  // hora en format 12 i referida
+  byte hour_12 = (hour > 12) ? hour - 12 : hour;
+  if (!hour_is_current) hour_12++;
+  if (hour_12 == 13) hour_12 = 1;
+
+  // indica si l'hora va precedida de l'article (la, les) o del determinant (de, d')
+  bool hour_with_article = (minute < 5) || (minute > 58);
+
+  // indica si l'hora és plural o singular
+  bool hour_is_singular = ((5 <= minute) && (minute <= 23)) || ((minute < 5) && (hour_12 == 1));
+
+  // VERB
+  if (hour_is_singular) {
+    referenceCode((reference_word) CAT_ES, matrix);
+  } else {
+    referenceCode((reference_word) CAT_SON, matrix);
+  }
+
+  // EN PUNT
+  if (minute == 0) {
+    referenceCode((reference_word) CAT_EN_PUNT, matrix);
+  }
+
+  // PRIMERS MINUTS
+  if ((1 <= minute) && (minute <= 4)) {
+    if (hour_is_singular) {
+      referenceCode((reference_word) CAT_TOCADA, matrix);
+    } else {
+      referenceCode((reference_word) CAT_TOCADES, matrix);
+    }
+    if (minute > 2) {
+      referenceCode((reference_word) CAT_BEN, matrix);
+    }
+  }
+  if (minute == 5) {
+    referenceCode((reference_word) CAT_VORA, matrix);
+    referenceCode((reference_word) CAT_MIG, matrix);
+    referenceCode((reference_word) CAT_QUART, matrix);
+  }
+
+  // FRANJA DEL MIG
+  //if ((6 <= minute) && (minute <= 53)) {
+  if (6 <= minute) {
+
+    // convenient words
+    reference_word tocat = (hour_is_singular) ? (reference_word) CAT_TOCAT : (reference_word) CAT_TOCATS;
+
+    byte quarts = (minute - 6) / 15;
+    byte index = (minute - 6) % 15;
+    if (index >= 3) quarts++;
+
+    if (quarts == 1) referenceCode((reference_word) CAT_UN_Q, matrix);
+    if (quarts == 2) referenceCode((reference_word) CAT_DOS_Q, matrix);
+    if (quarts == 3) referenceCode((reference_word) CAT_TRES_Q, matrix);
+    if (index < 3) {
+      if (quarts == 0) {
+        referenceCode((reference_word) CAT_MIG, matrix);
+      } else {
+        referenceCode((reference_word) CAT_I_MIG, matrix);
+      }
+    }
+    if (quarts < 2) {
+        referenceCode((reference_word) CAT_QUART, matrix);
+    } else if (quarts < 4) {
+        referenceCode((reference_word) CAT_QUARTS, matrix);
+    }
+
+    switch (index) {
+
+      case 0:
+        referenceCode((reference_word) CAT_VORA, matrix);
+        break;
+
+      case 2:
+        referenceCode(tocat, matrix);
+        break;
+
+      case 3:
+        referenceCode((reference_word) CAT_VORA, matrix);
+        referenceCode((reference_word) CAT_MENYS, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        break;
+
+      case 4:
+        referenceCode((reference_word) CAT_MENYS, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        break;
+
+      case 5:
+      case 6:
+        referenceCode((reference_word) CAT_MENYS, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        referenceCode(tocat, matrix);
+        break;
+
+      case 7:
+        referenceCode((reference_word) CAT_MENYS, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        referenceCode((reference_word) CAT_BEN_Q, matrix);
+        referenceCode(tocat, matrix);
+        break;
+
+      case 8:
+        referenceCode((reference_word) CAT_VORA, matrix);
+        break;
+
+      case 10:
+      case 11:
+        referenceCode(tocat, matrix);
+        break;
+
+      case 12:
+        referenceCode((reference_word) CAT_BEN_Q, matrix);
+        referenceCode(tocat, matrix);
+        break;
+
+      case 13:
+        referenceCode((reference_word) CAT_VORA, matrix);
+        referenceCode((reference_word) CAT_I, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        break;
+
+      case 14:
+        referenceCode((reference_word) CAT_I, matrix);
+        referenceCode((reference_word) CAT_CINC_Q, matrix);
+        break;
+
+    }
+
+  }
+
+  // HORES
+  switch (hour_12) {
+    case  1: referenceCode((reference_word) CAT_UNA, matrix); break;
+    case  2: referenceCode((reference_word) CAT_DUES, matrix); break;
+    case  3: referenceCode((reference_word) CAT_TRES, matrix); break;
+    case  4: referenceCode((reference_word) CAT_QUATRE, matrix); break;
+    case  5: referenceCode((reference_word) CAT_CINC, matrix); break;
+    case  6: referenceCode((reference_word) CAT_SIS, matrix); break;
+    case  7: referenceCode((reference_word) CAT_SET, matrix); break;
+    case  8: referenceCode((reference_word) CAT_VUIT, matrix); break;
+    case  9: referenceCode((reference_word) CAT_NOU, matrix); break;
+    case 10: referenceCode((reference_word) CAT_DEU, matrix); break;
+    case 11: referenceCode((reference_word) CAT_ONZE, matrix); break;
+    default: referenceCode((reference_word) CAT_DOTZE, matrix); break;
+  }
+
+
+  // PARTICULES DE LES HORES
+  if (hour_with_article) {
+    if (hour_is_singular) {
+      referenceCode((reference_word) CAT_LA, matrix);
+    } else {
+      referenceCode((reference_word) CAT_LES, matrix);
+    }
+  } else {
+    if (hour_12 == 1) {
+      referenceCode((reference_word) CAT_D_UNA, matrix);
+    } else if (hour_12 == 11) {
+      referenceCode((reference_word) CAT_D_ONZE, matrix);
+    } else {
+      referenceCode((reference_word) CAT_DE, matrix);
+    }
+  }
+
+  // FRANJA HORARIA
+  if (hour < 6) {
+    referenceCode((reference_word) CAT_DE_F, matrix);
+    referenceCode((reference_word) CAT_LA_F, matrix);
+    referenceCode((reference_word) CAT_NIT, matrix);
+  } else if (hour < 13) {
+    referenceCode((reference_word) CAT_DEL, matrix);
+    referenceCode((reference_word) CAT_MATI, matrix);
+  } else if (hour < 21) {
+    referenceCode((reference_word) CAT_DE_F, matrix);
+    referenceCode((reference_word) CAT_LA_F, matrix);
+    referenceCode((reference_word) CAT_TARDA, matrix);
+  } else {
+    referenceCode((reference_word) CAT_DE_F, matrix);
+    referenceCode((reference_word) CAT_LA_F, matrix);
+    referenceCode((reference_word) CAT_NIT, matrix);
+  }
+
+}
+
+void referenceCastellano(byte hour, byte minute, unsigned int * matrix) {
+
+  /*
+
+  00 => en punto
+  01 => pasada/s
+  02 => pasada/s
+
+  03 => casi y cinco
+  04 => casi y cinco
+  05 => y cinco
+  06 => y cinco pasadas
+  07 => y cinco pasadas
+
+  08 => casi y diez
+  09 => casi y diez
+  10 => y diez
+  11 => y diez pasadas
+  12 => y diez pasadas
+
+  13 => casi y cuarto
+  14 => casi y cuarto
+  15 => y cuarto
+  16 => y cuarto pasadas
+  17 => y cuarto pasadas
+
+  18 => casi y veinte
+  19 => casi y veinte
+  20 => y veinte
+  21 => y veinte pasadas
+  22 => y veinte pasadas
+
+  23 => casi y veinticinco
+  24 => casi y veinticinco
+  25 => y veinticinco
+  26 => y veinticinco pasadas
+  27 => y veinticinco pasadas
+
+  28 => casi y media
+  29 => casi y media
+  30 => y media
+  31 => y media pasadas
+  32 => y media pasadas
+
+  33 => casi menos veinticinco
+  34 => casi menos veinticinco
+  35 => menos veinticinco
+  36 => menos veinticinco pasadas
+  37 => menos veinticinco pasadas
+
+  38 => casi menos veinte
+  39 => casi menos veinte
+  40 => menos veinte
+  41 => menos veinte pasadas
+  42 => menos veinte pasadas
+
+  43 => casi menos cuarto
+  44 => casi menos cuarto
+  45 => menos cuarto
+  46 => menos cuarto pasadas
+  47 => menos cuarto pasadas
+
+  48 => casi menos diez
+  49 => casi menos diez
+  50 => menos diez
+  51 => menos diez pasadas
+  52 => menos diez pasadas
+
+  53 => casi menos cinco
+  54 => casi menos cinco
+  55 => menos cinco
+  56 => menos cinco pasadas
+  57 => menos cinco pasadas
+
+  58 => casi
+  59 => casi
+
+  */
+
+  // indica si la hora se referencia a la actual o a la posterior
+  bool hour_is_current = (minute < 33);
+
+  // hora en formato 12 y referida
+  byte hour_12 = (hour > 12) ? hour - 12 : hour;
+  if (!hour_is_current) hour_12++;
+  if (hour_12 == 13) hour_12 = 1;
+
+  // indica si la hora es plural o singular
+  bool hour_is_singular = (hour_12 == 1);
+
+  // ARTICLE
+  if (hour_is_singular) {
+    referenceCode((reference_word) ESP_ES, matrix);
+    referenceCode((reference_word) ESP_LA, matrix);
+  } else {
+    referenceCode((reference_word) ESP_SON, matrix);
+    referenceCode((reference_word) ESP_LAS, matrix);
+  }
+
+  // BLOCKS
+  byte reference = ((minute + 2) / 5) % 12;
+  byte index = (minute + 2) % 5;
+  if (reference == 0) {
+    // NOP
+  } else if (reference < 7) {
+    referenceCode((reference_word) ESP_Y, matrix);
+  } else {
+    referenceCode((reference_word) ESP_MENOS, matrix);
+  }
+  if (reference ==  1) referenceCode((reference_word) ESP_CINCO_B, matrix);
+  if (reference ==  2) referenceCode((reference_word) ESP_DIEZ_B, matrix);
+  if (reference ==  3) referenceCode((reference_word) ESP_CUARTO, matrix);
+  if (reference ==  4) referenceCode((reference_word) ESP_VEINTE, matrix);
+  if (reference ==  5) referenceCode((reference_word) ESP_VEINTICINCO, matrix);
+  if (reference ==  6) referenceCode((reference_word) ESP_MEDIA, matrix);
+  if (reference ==  7) referenceCode((reference_word) ESP_VEINTICINCO, matrix);
+  if (reference ==  8) referenceCode((reference_word) ESP_VEINTE, matrix);
+  if (reference ==  9) referenceCode((reference_word) ESP_CUARTO, matrix);
+  if (reference == 10) referenceCode((reference_word) ESP_DIEZ_B, matrix);
+  if (reference == 11) referenceCode((reference_word) ESP_CINCO_B, matrix);
+
+  // MODIFIERS
+  if (index < 2) referenceCode((reference_word) ESP_CASI, matrix);
+  if (index > 2) {
+    if (hour_is_singular) {
+      referenceCode((reference_word) ESP_PASADA, matrix);
+    } else {
+      referenceCode((reference_word) ESP_PASADAS, matrix);
+    }
+  }
+  if (minute == 0) referenceCode((reference_word) ESP_EN_PUNTO, matrix);
+
+  // HORAS
+  switch (hour_12) {
+    case  1: referenceCode((reference_word) ESP_UNA, matrix); break;
+    case  2: referenceCode((reference_word) ESP_DOS, matrix); break;
+    case  3: referenceCode((reference_word) ESP_TRES, matrix); break;
+    case  4: referenceCode((reference_word) ESP_CUATRO, matrix); break;
+    case  5: referenceCode((reference_word) ESP_CINCO, matrix); break;
+    case  6: referenceCode((reference_word) ESP_SEIS, matrix); break;
+    case  7: referenceCode((reference_word) ESP_SIETE, matrix); break;
+    case  8: referenceCode((reference_word) ESP_OCHO, matrix); break;
+    case  9: referenceCode((reference_word) ESP_NUEVE, matrix); break;
+    case 10: referenceCode((reference_word) ESP_DIEZ, matrix); break;
+    case 11: referenceCode((reference_word) ESP_ONCE, matrix); break;
+    default: referenceCode((reference_word) ESP_DOCE, matrix); break;
+  }
+
+  // FRANJA HORARIA
+  referenceCode((reference_word) ESP_DE_F, matrix);
+  referenceCode((reference_word) ESP_LA_F, matrix);
+  if (hour < 6) {
+    referenceCode((reference_word) ESP_NOCHE, matrix);
+  } else if (hour < 13) {
+    referenceCode((reference_word) ESP_MANANA, matrix);
+  } else if (hour < 21) {
+    referenceCode((reference_word) ESP_TARDE, matrix);
+  } else {
+    referenceCode((reference_word) ESP_NOCHE, matrix);
+  }
+
+}
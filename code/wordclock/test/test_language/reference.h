@@ -0,0 +1,30 @@
+/*
+
+  Original language code, the reference for the word tables
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _REFERENCE_h
+#define _REFERENCE_h
+
+// The 16x16 stencil the original code was written for
+#define REFERENCE_ROWS 16
+
+void referenceCatalan(byte hour, byte minute, unsigned int * matrix);
+void referenceCastellano(byte hour, byte minute, unsigned int * matrix);
+
+#endif
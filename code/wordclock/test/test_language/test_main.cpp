@@ -0,0 +1,85 @@
+/*
+
+  Word Clock, the generated word tables against the original language code
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <unity.h>
+
+#include "../../src/wordclock.ino"
+#include "reference.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+typedef void (*reference_t)(byte hour, byte minute, unsigned int * matrix);
+
+/**
+ * Compares every minute of the day of a language with the original code
+ * @param  byte language          Language index
+ * @param  reference_t reference  Original function for the language
+ */
+void languageCompare(byte language, reference_t reference) {
+
+   char message[32];
+
+   for (byte hour=0; hour<24; hour++) {
+      for (byte minute=0; minute<60; minute++) {
+
+         unsigned int expected[REFERENCE_ROWS];
+         row_t pattern[MATRIX_HEIGHT];
+         memset(expected, 0, sizeof(expected));
+         memset(pattern, 0, sizeof(pattern));
+
+         reference(hour, minute, expected);
+         loadLanguage(language, hour, minute, pattern);
+
+         for (byte y=0; y<REFERENCE_ROWS; y++) {
+            snprintf(message, sizeof(message), "%02d:%02d row %d", hour, minute, y);
+            TEST_ASSERT_EQUAL_HEX16_MESSAGE(expected[y], pattern[y], message);
+         }
+
+      }
+   }
+
+}
+
+void test_catalan(void) {
+   languageCompare(LANGUAGE_CATALAN, referenceCatalan);
+}
+
+void test_castellano(void) {
+   languageCompare(LANGUAGE_SPANISH, referenceCastellano);
+}
+
+void test_languages(void) {
+   TEST_ASSERT_EQUAL(2, languages_count);
+}
+
+int main(int argc, char **argv) {
+   nativeReset();
+   setup();
+   UNITY_BEGIN();
+   RUN_TEST(test_languages);
+   RUN_TEST(test_catalan);
+   RUN_TEST(test_castellano);
+   return UNITY_END();
+}
@@ -0,0 +1,141 @@
+/*
+
+  Word Clock, panel layouts
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include "../../src/layout.h"
+
+// The 16x16 serpentine panel the clock was built with
+typedef Layout<16, 16, 1, 1, LAYOUT_SERPENTINE> Default;
+
+/**
+ * Every position of the image maps to a led of its own, all of them used
+ * @param  const char * name      Layout, for the failure message
+ */
+template <class L> void permutation(const char * name) {
+
+  static bool seen[L::pixels];
+  memset(seen, 0, sizeof(seen));
+  TEST_ASSERT_EQUAL_MESSAGE(L::pixels, (unsigned int) L::width * L::height, name);
+  for (unsigned int y=0; y<L::height; y++) {
+    for (unsigned int x=0; x<L::width; x++) {
+      unsigned int index = L::index(x, y);
+      TEST_ASSERT_TRUE_MESSAGE(index < L::pixels, name);
+      TEST_ASSERT_FALSE_MESSAGE(seen[index], name);
+      seen[index] = true;
+    }
+  }
+
+}
+
+/**
+ * Every rotation of a layout, plain and mirrored
+ */
+template <uint8_t TW, uint8_t TH, uint8_t TX, uint8_t TY, uint8_t W>
+void rotations(const char * name) {
+  char message[64];
+  for (uint8_t mirror=0; mirror<2; mirror++) {
+    snprintf(message, sizeof(message), "%s, rotation 0%s", name, mirror ? ", mirrored" : "");
+    mirror ? permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_0, true> >(message)
+           : permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_0, false> >(message);
+    snprintf(message, sizeof(message), "%s, rotation 90%s", name, mirror ? ", mirrored" : "");
+    mirror ? permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_90, true> >(message)
+           : permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_90, false> >(message);
+    snprintf(message, sizeof(message), "%s, rotation 180%s", name, mirror ? ", mirrored" : "");
+    mirror ? permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_180, true> >(message)
+           : permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_180, false> >(message);
+    snprintf(message, sizeof(message), "%s, rotation 270%s", name, mirror ? ", mirrored" : "");
+    mirror ? permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_270, true> >(message)
+           : permutation<Layout<TW, TH, TX, TY, W, LAYOUT_ROTATE_270, false> >(message);
+  }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * The default layout is the formula pixelIndex() had before the tables
+ */
+void test_default(void) {
+  TEST_ASSERT_EQUAL(16, Default::width);
+  TEST_ASSERT_EQUAL(16, Default::height);
+  TEST_ASSERT_EQUAL(1, sizeof(Default::index_t));
+  for (uint8_t y=0; y<16; y++) {
+    for (uint8_t x=0; x<16; x++) {
+      TEST_ASSERT_EQUAL(16 * y + ((y % 2 == 0) ? x : 16 - x - 1), Default::index(x, y));
+    }
+  }
+}
+
+/**
+ * Corners land where the rotation and the mirror put them
+ */
+void test_corners(void) {
+
+  // first led top left, the last one bottom left after 16 serpentine rows
+  TEST_ASSERT_EQUAL(0, Default::index(0, 0));
+  TEST_ASSERT_EQUAL(255, Default::index(0, 15));
+
+  // the image top left on the top right, bottom right and bottom left leds,
+  // the last row running right to left
+  TEST_ASSERT_EQUAL(15, (Layout<16, 16, 1, 1, LAYOUT_SERPENTINE, LAYOUT_ROTATE_0, true>::index(0, 0)));
+  TEST_ASSERT_EQUAL(15, (Layout<16, 16, 1, 1, LAYOUT_SERPENTINE, LAYOUT_ROTATE_90>::index(0, 0)));
+  TEST_ASSERT_EQUAL(240, (Layout<16, 16, 1, 1, LAYOUT_SERPENTINE, LAYOUT_ROTATE_180>::index(0, 0)));
+  TEST_ASSERT_EQUAL(255, (Layout<16, 16, 1, 1, LAYOUT_SERPENTINE, LAYOUT_ROTATE_270>::index(0, 0)));
+  // and its bottom left on the first led when turned clockwise
+  TEST_ASSERT_EQUAL(0, (Layout<16, 16, 1, 1, LAYOUT_SERPENTINE, LAYOUT_ROTATE_90>::index(0, 15)));
+
+  // a non square panel swaps its sides when turned
+  typedef Layout<8, 4, 2, 3, LAYOUT_PROGRESSIVE, LAYOUT_ROTATE_90> Turned;
+  TEST_ASSERT_EQUAL(12, Turned::width);
+  TEST_ASSERT_EQUAL(16, Turned::height);
+
+  // tiles chained row by row, each wired on its own
+  typedef Layout<8, 8, 2, 2, LAYOUT_SERPENTINE> Tiled;
+  TEST_ASSERT_EQUAL(64, Tiled::index(8, 0));
+  TEST_ASSERT_EQUAL(128, Tiled::index(0, 8));
+  TEST_ASSERT_EQUAL(15, Tiled::index(0, 1));
+
+}
+
+/**
+ * Rotated, mirrored and tiled layouts use every led once
+ */
+void test_permutations(void) {
+  rotations<16, 16, 1, 1, LAYOUT_SERPENTINE>("16x16 serpentine");
+  rotations<16, 16, 1, 1, LAYOUT_PROGRESSIVE>("16x16 progressive");
+  rotations<8, 8, 2, 2, LAYOUT_SERPENTINE>("8x8 tiles 2x2 serpentine");
+  rotations<8, 4, 2, 3, LAYOUT_PROGRESSIVE>("8x4 tiles 2x3 progressive");
+  rotations<5, 3, 3, 2, LAYOUT_SERPENTINE>("5x3 tiles 3x2 serpentine");
+  rotations<16, 16, 2, 1, LAYOUT_SERPENTINE>("16x16 tiles 2x1 serpentine");
+  TEST_ASSERT_EQUAL(2, (sizeof(Layout<16, 16, 2, 1, LAYOUT_SERPENTINE>::index_t)));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_default);
+  RUN_TEST(test_corners);
+  RUN_TEST(test_permutations);
+  return UNITY_END();
+}
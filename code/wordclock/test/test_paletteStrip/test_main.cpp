@@ -0,0 +1,244 @@
+/*
+
+  Word Clock, palette strip against Adafruit_NeoPixel
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include <Adafruit_NeoPixel.h>
+#include "paletteStrip.h"
+
+#define PIXELS 256
+#define PIN 4
+#define BYTES (PIXELS * 3)
+
+uint8_t buffer[PALETTE_BUFFER(PIXELS)];
+PaletteStrip strip = PaletteStrip(buffer, PIXELS, PIN);
+Adafruit_NeoPixel reference = Adafruit_NeoPixel(PIXELS, PIN, NEO_GRB + NEO_KHZ800);
+
+unsigned long palette[PALETTE_SIZE];
+uint8_t indexes[PIXELS];
+uint8_t sent[BYTES];
+uint8_t expected[BYTES];
+
+uint16_t seed = 1;
+uint16_t random16() {
+  seed ^= seed << 7;
+  seed ^= seed >> 9;
+  seed ^= seed << 8;
+  return seed;
+}
+
+/**
+ * Shows the frame on both strips, the reference as the clock used to
+ * do it: brightness scaling on setPixelColor, then gamma8 on the buffer
+ * @param  uint8_t level          Brightness
+ */
+void showBoth(uint8_t level) {
+
+  strip.setBrightness(level);
+  for (uint8_t i=0; i<PALETTE_SIZE; i++) strip.setPalette(i, palette[i]);
+  for (uint16_t n=0; n<PIXELS; n++) strip.setPixel(n, indexes[n]);
+  nativeWireRead(sent, 0);
+  strip.show();
+  TEST_ASSERT_EQUAL(BYTES, nativeWireRead(sent, BYTES));
+
+  reference.setBrightness(level);
+  for (uint16_t n=0; n<PIXELS; n++) reference.setPixelColor(n, palette[indexes[n]]);
+  uint8_t * bytes = reference.getPixels();
+  for (uint16_t i=0; i<BYTES; i++) bytes[i] = Adafruit_NeoPixel::gamma8(bytes[i]);
+  reference.show();
+  TEST_ASSERT_EQUAL(BYTES, nativeWireRead(expected, BYTES));
+
+}
+
+void setUp(void) {
+  nativeReset();
+  strip.begin();
+  strip.setDither(false);
+  reference.begin();
+}
+
+void tearDown(void) {
+}
+
+void test_bytes(void) {
+
+  char message[48];
+
+  for (uint8_t round=0; round<64; round++) {
+
+    for (uint8_t i=0; i<PALETTE_SIZE; i++) {
+      palette[i] = ((unsigned long) random16() << 8) ^ random16();
+      palette[i] &= 0xFFFFFF;
+    }
+    for (uint16_t n=0; n<PIXELS; n++) indexes[n] = random16() & 0x0F;
+
+    for (uint16_t level=0; level<256; level+=(round & 7) + 1) {
+      showBoth(level);
+      for (uint16_t i=0; i<BYTES; i++) {
+        if (sent[i] == expected[i]) continue;
+        snprintf(message, sizeof(message), "level %d byte %d: %d, not %d", level, i, sent[i], expected[i]);
+        TEST_FAIL_MESSAGE(message);
+      }
+    }
+
+  }
+
+}
+
+void test_every_value(void) {
+
+  // every channel value at every brightness, grey ramps in all entries
+  for (uint16_t level=0; level<256; level++) {
+    for (uint16_t base=0; base<256; base+=PALETTE_SIZE) {
+      for (uint8_t i=0; i<PALETTE_SIZE; i++) {
+        uint8_t v = base + i;
+        palette[i] = Adafruit_NeoPixel::Color(v, 255 - v, v ^ 0x55);
+      }
+      for (uint16_t n=0; n<PIXELS; n++) indexes[n] = n & 0x0F;
+      showBoth(level);
+      TEST_ASSERT_EQUAL_MEMORY(expected, sent, BYTES);
+    }
+  }
+
+}
+
+/**
+ * CIE L* of a led duty, fractional duties as dithering averages them
+ * @param  double duty            0 to 255
+ */
+double lightness(double duty) {
+  double y = duty / 255.0;
+  return y > 0.008856 ? 116.0 * cbrt(y) - 16.0 : 903.3 * y;
+}
+
+void test_dither(void) {
+
+  // a grey ramp, 16 levels per round through all 256
+  char message[96];
+  double rounded_error = 0;
+  double dithered_error = 0;
+  unsigned int flickering = 0;
+  double worst_depth = 0;
+  uint8_t worst_level = 0;
+
+  strip.setDither(true);
+  strip.setBrightness(255);
+  for (uint16_t n=0; n<PIXELS; n++) strip.setPixel(n, n & 0x0F);
+
+  for (uint16_t base=0; base<256; base+=PALETTE_SIZE) {
+
+    for (uint8_t i=0; i<PALETTE_SIZE; i++) strip.setPalette(i, (base + i) * 0x010101UL);
+
+    // over 256 shows every channel sends its exact level on average
+    unsigned int sum[PALETTE_SIZE] = {0};
+    for (unsigned int f=0; f<256; f++) {
+      nativeWireRead(sent, 0);
+      strip.show();
+      TEST_ASSERT_EQUAL(BYTES, nativeWireRead(sent, BYTES));
+      for (uint8_t i=0; i<PALETTE_SIZE; i++) {
+        TEST_ASSERT_EQUAL(sent[i * 3], sent[i * 3 + 1]);
+        sum[i] += sent[i * 3];
+      }
+    }
+
+    for (uint8_t i=0; i<PALETTE_SIZE; i++) {
+      uint8_t level = base + i;
+      double exact = pow(level / 255.0, PALETTE_GAMMA) * 255.0;
+      TEST_ASSERT_UINT_WITHIN(1, (unsigned long) (exact * 256), sum[i]);
+
+      // what the eye gets, rounded or dithered
+      double error = fabs(lightness(Adafruit_NeoPixel::gamma8(level)) - lightness(exact));
+      if (error > rounded_error) rounded_error = error;
+      error = fabs(lightness(sum[i] / 256.0) - lightness(exact));
+      if (error > dithered_error) dithered_error = error;
+
+      // the flicker: the dither alternates between two duties, at
+      // 50fps always below 25Hz, visible once they are 1 L* apart
+      uint8_t duty = sum[i] >> 8;
+      if (((sum[i] & 0xFF) == 0) || (duty == 255)) continue;
+      double depth = lightness(duty + 1) - lightness(duty);
+      if (depth > 1.0) flickering++;
+      if (depth > worst_depth) {
+        worst_depth = depth;
+        worst_level = level;
+      }
+    }
+
+  }
+
+  snprintf(message, sizeof(message), "L* error: rounded %.2f, dithered %.2f", rounded_error, dithered_error);
+  TEST_MESSAGE(message);
+  snprintf(message, sizeof(message), "%d levels flicker over 1 L* deep, level %d %.1f L*",
+    flickering, worst_level, worst_depth);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(dithered_error < rounded_error);
+  strip.setDither(false);
+
+}
+
+void test_palette(void) {
+
+  // the colors set are given back whatever the brightness
+  strip.setBrightness(10);
+  strip.setPalette(3, 0x123456);
+  strip.setBrightness(200);
+  TEST_ASSERT_EQUAL_HEX32(0x123456, strip.getPalette(3));
+  TEST_ASSERT_EQUAL_HEX32(0, strip.getPalette(PALETTE_SIZE));
+
+  // and brightness changes don't lose precision
+  strip.setBrightness(200);
+  strip.setPalette(0, 0xFFFFFF);
+  for (uint16_t n=0; n<PIXELS; n++) strip.setPixel(n, 0);
+  strip.setBrightness(1);
+  strip.setBrightness(255);
+  nativeWireRead(sent, 0);
+  strip.show();
+  nativeWireRead(sent, BYTES);
+  TEST_ASSERT_EQUAL(255, sent[0]);
+
+}
+
+/**
+ * A show keeps interrupts off for 7.7ms, millis() is given back the
+ * ticks lost whatever the timer phase it starts at
+ */
+void test_millis(void) {
+
+  unsigned long long started = nativeNow();
+  unsigned long from = millis();
+  for (uint16_t i=0; i<200; i++) {
+    strip.show();
+    nativeWireRead(sent, BYTES);
+    delayMicroseconds(12345);
+    TEST_ASSERT_UINT_WITHIN(1, (nativeNow() - started) / 1000, millis() - from);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bytes);
+  RUN_TEST(test_every_value);
+  RUN_TEST(test_dither);
+  RUN_TEST(test_palette);
+  RUN_TEST(test_millis);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+/*
+
+  Word Clock, log and frames looped back through the serial port
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include "logBuffer.h"
+#include "protocol.h"
+
+#define RING 128
+#define PAYLOAD 16
+#define WIRE 2048
+
+uint8_t ring[RING];
+LogBuffer logger = LogBuffer(ring, RING, &Serial);
+
+uint8_t payload[PAYLOAD];
+Protocol protocol = Protocol(payload, PAYLOAD);
+
+// What the host got
+uint8_t wire[WIRE];
+char text[WIRE];
+size_t text_length = 0;
+unsigned int frames = 0;
+unsigned int invalid = 0;
+
+/**
+ * Moves the log to the port until both are empty, then feeds what came
+ * out of the wire to the parser, keeping the text and counting frames
+ * @param  void (*check)()        Called on every frame parsed
+ */
+void drain(void (*check)()) {
+  while (logger.loop() || (Serial.availableForWrite() < NATIVE_SERIAL_TX - 1)) {
+    nativeAdvance(1000);
+  }
+  size_t n = Serial.nativeReceive(wire, WIRE);
+  for (size_t i=0; i<n; i++) {
+    switch (protocol.feed(wire[i], millis())) {
+      case PROTOCOL_TEXT:
+        TEST_ASSERT_LESS_THAN(WIRE - 1, text_length);
+        text[text_length++] = wire[i];
+        break;
+      case PROTOCOL_FRAME:
+        frames++;
+        if (check) check();
+        break;
+      case PROTOCOL_INVALID:
+        invalid++;
+        break;
+    }
+  }
+  text[text_length] = 0;
+}
+
+uint8_t expected[PAYLOAD];
+uint8_t expected_length = 0;
+
+void checkFrame() {
+  TEST_ASSERT_EQUAL_HEX8(0x80, protocol.command());
+  TEST_ASSERT_EQUAL(expected_length, protocol.length());
+  TEST_ASSERT_EQUAL_MEMORY(expected, protocol.payload(), expected_length);
+}
+
+void setUp(void) {
+  nativeReset();
+  Serial.begin(115200);
+  logger.flush();
+  text_length = 0;
+  frames = invalid = 0;
+}
+
+void tearDown(void) {
+}
+
+/**
+ * Log lines and reply frames written in turns reach the host apart, the
+ * text whole and every frame valid, whatever bytes its payload carries
+ */
+void test_loopback(void) {
+
+  char line[32];
+  char sent[WIRE];
+  unsigned long errors = protocol.errors();
+  unsigned long dropped = logger.dropped();
+  size_t sent_length = 0;
+  uint8_t frame[PAYLOAD + PROTOCOL_OVERHEAD];
+
+  for (uint8_t i=0; i<40; i++) {
+    logger.print(F("MODE: "));
+    logger.println(i);
+    snprintf(line, sizeof(line), "MODE: %d\r\n", i);
+    strcpy(&sent[sent_length], line);
+    sent_length += strlen(line);
+
+    expected_length = i % PAYLOAD;
+    for (uint8_t j=0; j<expected_length; j++) {
+      const uint8_t bytes[] = { '\n', 's', PROTOCOL_SYNC, 0, 0xFF };
+      expected[j] = bytes[(i + j) % sizeof(bytes)];
+    }
+    TEST_ASSERT_TRUE(logger.write(frame, Protocol::frame(frame, 0x80, expected, expected_length)) > 0);
+    drain(checkFrame);
+  }
+
+  TEST_ASSERT_EQUAL(40, frames);
+  TEST_ASSERT_EQUAL(0, invalid);
+  TEST_ASSERT_EQUAL(errors, protocol.errors());
+  TEST_ASSERT_EQUAL(dropped, logger.dropped());
+  TEST_ASSERT_EQUAL_STRING(sent, text);
+
+}
+
+/**
+ * Lines that do not fit are never cut silently: each line out is whole
+ * or ends in the cut mark, and one mark stands for all the lines lost
+ * in a row
+ */
+void test_cut_lines(void) {
+
+  char line[40];
+  unsigned long dropped = logger.dropped();
+  for (uint8_t i=0; i<20; i++) {
+    logger.print(F("line "));
+    logger.print(i);
+    logger.println(F(", some text to fill the ring"));
+  }
+  TEST_ASSERT_TRUE(logger.dropped() > dropped);
+  drain(NULL);
+
+  // whole lines, then the one cut
+  uint8_t whole = 0;
+  char * start = text;
+  while (true) {
+    char * end = strstr(start, "\r\n");
+    TEST_ASSERT_NOT_NULL(end);
+    snprintf(line, sizeof(line), "line %d, some text to fill the ring", whole);
+    size_t length = end - start;
+    if ((length == strlen(line)) && (strncmp(start, line, length) == 0)) {
+      whole++;
+      start = end + 2;
+      continue;
+    }
+    TEST_ASSERT_EQUAL('~', end[-1]);
+    TEST_ASSERT_EQUAL(0, strncmp(start, line, length - 1));
+    start = end + 2;
+    break;
+  }
+  TEST_ASSERT_TRUE(whole > 0);
+  TEST_ASSERT_EQUAL_STRING("", start);
+
+  // and the next line goes whole
+  text_length = 0;
+  logger.println(F("next"));
+  drain(NULL);
+  TEST_ASSERT_EQUAL_STRING("next\r\n", text);
+
+}
+
+/**
+ * A frame that does not fit is dropped whole, the text around it goes on
+ */
+void test_frame_whole(void) {
+
+  uint8_t frame[PAYLOAD + PROTOCOL_OVERHEAD];
+  unsigned long dropped = logger.dropped();
+  expected_length = PAYLOAD;
+  memset(expected, 'x', PAYLOAD);
+  while (logger.room() >= PAYLOAD) logger.print('.');
+  logger.println();
+  TEST_ASSERT_EQUAL(0, logger.write(frame, Protocol::frame(frame, 0x80, expected, PAYLOAD)));
+  TEST_ASSERT_EQUAL(PAYLOAD + PROTOCOL_OVERHEAD, logger.dropped() - dropped);
+  drain(NULL);
+  TEST_ASSERT_EQUAL(0, frames);
+  TEST_ASSERT_NULL(strchr(text, '~'));
+
+  logger.println(F("next"));
+  TEST_ASSERT_TRUE(logger.write(frame, Protocol::frame(frame, 0x80, expected, PAYLOAD)) > 0);
+  drain(checkFrame);
+  TEST_ASSERT_EQUAL(1, frames);
+  TEST_ASSERT_NOT_NULL(strstr(text, "next\r\n"));
+
+}
+
+/**
+ * Feeds a frame, every byte but the last one must be part of it
+ * @param  const uint8_t * frame  Frame
+ * @param  uint8_t length         Frame length
+ * @return uint8_t                What the last byte made of it
+ */
+uint8_t feed(const uint8_t * frame, uint8_t length) {
+  for (uint8_t i=0; i<length - 1; i++) {
+    TEST_ASSERT_EQUAL(PROTOCOL_PARTIAL, protocol.feed(frame[i], 0));
+  }
+  return protocol.feed(frame[length - 1], 0);
+}
+
+/**
+ * The payload of a frame too long to take is skipped, its bytes are
+ * not run as text commands, and the sender hears about it if the CRC
+ * holds. The frame after it is parsed
+ */
+void test_oversize(void) {
+
+  unsigned long errors = protocol.errors();
+  uint8_t text[PAYLOAD + 4];
+  for (uint8_t i=0; i<sizeof(text); i++) text[i] = "smp"[i % 3];
+  uint8_t frame[sizeof(text) + PROTOCOL_OVERHEAD];
+  uint8_t length = Protocol::frame(frame, 0x08, text, sizeof(text));
+
+  TEST_ASSERT_EQUAL(PROTOCOL_OVERSIZE, feed(frame, length));
+  TEST_ASSERT_EQUAL_HEX8(0x08, protocol.command());
+  TEST_ASSERT_EQUAL(errors + 1, protocol.errors());
+
+  frame[length - 1] ^= 1;
+  TEST_ASSERT_EQUAL(PROTOCOL_INVALID, feed(frame, length));
+  TEST_ASSERT_EQUAL(errors + 2, protocol.errors());
+
+  length = Protocol::frame(frame, 0x01, (const uint8_t *) "s", 1);
+  TEST_ASSERT_EQUAL(PROTOCOL_FRAME, feed(frame, length));
+  TEST_ASSERT_EQUAL(PROTOCOL_TEXT, protocol.feed('s', 0));
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_loopback);
+  RUN_TEST(test_cut_lines);
+  RUN_TEST(test_frame_whole);
+  RUN_TEST(test_oversize);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+/*
+
+  Word Clock, matrix rain replay
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include "rain.h"
+
+#define RAYS 40
+#define SEED 0x1234
+#define FRAMES 1000
+
+// Checksum of the frames played from SEED, taken before the rays were packed
+#define GOLDEN 0x861132B6UL
+
+ray_t rays[RAYS];
+Rain rain = Rain(rays, RAYS);
+
+// Shade of every pixel of the frame being drawn, 0xFF for off
+uint8_t frame[RAIN_HEIGHT][RAIN_WIDTH];
+
+void pixel(uint8_t x, uint8_t y, uint8_t shade) {
+  TEST_ASSERT_LESS_THAN(RAIN_WIDTH, x);
+  TEST_ASSERT_LESS_THAN(RAIN_HEIGHT, y);
+  TEST_ASSERT_LESS_OR_EQUAL(RAIN_SHADES, shade);
+  frame[y][x] = shade;
+}
+
+/**
+ * Plays frames as the matrix mode does, rays hitting a target pattern
+ * @param  uint16_t seed          Random seed
+ * @param  unsigned int frames    Frames to play
+ * @return unsigned long          FNV-1a checksum of every frame drawn
+ */
+unsigned long play(uint16_t seed, unsigned int frames) {
+
+  rain_row_t target[RAIN_HEIGHT];
+  rain_row_t hits[RAIN_HEIGHT];
+  for (uint8_t y=0; y<RAIN_HEIGHT; y++) {
+    target[y] = (rain_row_t) 0x0FF0 << (y & 3);
+    hits[y] = 0;
+  }
+
+  unsigned long hash = 2166136261UL;
+  rain.begin(seed, 50);
+  for (unsigned int f=0; f<frames; f++) {
+    rain.spawn();
+    rain.step();
+    rain.hit(target, hits);
+    memset(frame, 0xFF, sizeof(frame));
+    rain.draw(pixel);
+    const uint8_t * p = (const uint8_t *) frame;
+    for (unsigned int i=0; i<sizeof(frame); i++) {
+      hash = ((hash ^ p[i]) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    hash = ((hash ^ rain.alive()) * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return hash;
+
+}
+
+void setUp(void) {
+  nativeReset();
+}
+
+void tearDown(void) {
+}
+
+void test_replay(void) {
+  unsigned long first = play(SEED, FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(first, play(SEED, FRAMES));
+  char message[32];
+  snprintf(message, sizeof(message), "checksum 0x%08lX", first);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(GOLDEN, first);
+}
+
+void test_seeds(void) {
+  TEST_ASSERT_TRUE(play(SEED, FRAMES) != play(SEED + 1, FRAMES));
+
+  // 0 would stop the xorshift, it plays as 1
+  TEST_ASSERT_EQUAL_UINT32(play(1, FRAMES), play(0, FRAMES));
+}
+
+void test_rays(void) {
+
+  // every slot gets used, none is leaked
+  rain.begin(SEED, 50);
+  uint8_t most = 0;
+  for (unsigned int f=0; f<FRAMES; f++) {
+    rain.spawn();
+    rain.step();
+    if (rain.alive() > most) most = rain.alive();
+  }
+  TEST_ASSERT_EQUAL(RAYS, most);
+  for (unsigned int f=0; f<RAIN_LIFE_MAX * RAIN_SPEED_MAX; f++) rain.step();
+  TEST_ASSERT_EQUAL(0, rain.alive());
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_replay);
+  RUN_TEST(test_seeds);
+  RUN_TEST(test_rays);
+  return UNITY_END();
+}
@@ -0,0 +1,248 @@
+/*
+
+  Word Clock, settings kept in EEPROM
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include "settings.h"
+
+#define VERSION 1
+#define START 16
+#define SLOTS 4
+#define RECORD SETTINGS_RECORD(sizeof(settings_t))
+
+struct settings_t {
+  uint8_t mode;
+  uint8_t language;
+  uint8_t color;
+  uint8_t brightness;
+};
+
+settings_t defaults = { 0, 0, 3, 111 };
+
+/**
+ * Loads the settings as the clock does at boot, over the defaults
+ * @param  settings_t * data      Settings
+ * @return bool                   True if a record has been loaded
+ */
+bool boot(Settings * settings, settings_t * data) {
+  *data = defaults;
+  return settings->begin(START, SLOTS * RECORD);
+}
+
+/**
+ * Waits for the settings to be quiet and writes the record
+ */
+void flush(Settings * settings) {
+  delay(SETTINGS_QUIET);
+  while (settings->loop());
+  TEST_ASSERT_FALSE(settings->pending());
+}
+
+/**
+ * Changes the brightness and writes it
+ */
+void store(Settings * settings, settings_t * data, uint8_t brightness) {
+  data->brightness = brightness;
+  settings->save();
+  flush(settings);
+}
+
+void setUp(void) {
+  nativeReset();
+  EEPROM.nativeErase();
+}
+
+void tearDown(void) {
+}
+
+/**
+ * A blank chip leaves the defaults, the first record goes to the first
+ * slot and nothing else is written
+ */
+void test_blank(void) {
+
+  settings_t data;
+  Settings settings = Settings(&data, sizeof(data), VERSION);
+  TEST_ASSERT_FALSE(boot(&settings, &data));
+  TEST_ASSERT_EQUAL_MEMORY(&defaults, &data, sizeof(data));
+  TEST_ASSERT_FALSE(settings.pending());
+  TEST_ASSERT_FALSE(settings.loop());
+  TEST_ASSERT_EQUAL(0, EEPROM.nativeWrites());
+
+  store(&settings, &data, 200);
+  TEST_ASSERT_EQUAL(0, settings.slot());
+  TEST_ASSERT_EQUAL(1, settings.writes());
+  TEST_ASSERT_EQUAL(0xFF, EEPROM.read(START - 1));
+  TEST_ASSERT_EQUAL(0xFF, EEPROM.read(START + RECORD));
+
+  settings_t loaded;
+  Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+  TEST_ASSERT_TRUE(boot(&reloaded, &loaded));
+  TEST_ASSERT_EQUAL(200, loaded.brightness);
+
+  // another version is taken for a blank chip
+  Settings other = Settings(&loaded, sizeof(loaded), VERSION + 1);
+  TEST_ASSERT_FALSE(boot(&other, &loaded));
+  TEST_ASSERT_EQUAL_MEMORY(&defaults, &loaded, sizeof(loaded));
+
+}
+
+/**
+ * Changes in a row make a single record once they have been quiet,
+ * every change starting the wait over
+ */
+void test_coalesce(void) {
+
+  settings_t data;
+  Settings settings = Settings(&data, sizeof(data), VERSION);
+  boot(&settings, &data);
+
+  for (uint8_t i=0; i<10; i++) {
+    data.brightness = 100 + i;
+    settings.save();
+    delay(SETTINGS_QUIET / 2);
+    TEST_ASSERT_FALSE(settings.loop());
+    TEST_ASSERT_TRUE(settings.pending());
+  }
+  TEST_ASSERT_EQUAL(0, EEPROM.nativeWrites());
+
+  flush(&settings);
+  TEST_ASSERT_EQUAL(1, settings.writes());
+  TEST_ASSERT_TRUE(EEPROM.nativeWrites() <= RECORD);
+
+  settings_t loaded;
+  Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+  TEST_ASSERT_TRUE(boot(&reloaded, &loaded));
+  TEST_ASSERT_EQUAL(109, loaded.brightness);
+
+}
+
+/**
+ * Every record goes to the next slot, around the area, and the newest
+ * one is loaded wherever it is
+ */
+void test_rotation(void) {
+
+  settings_t data;
+  Settings settings = Settings(&data, sizeof(data), VERSION);
+  boot(&settings, &data);
+
+  for (uint8_t i=0; i<SLOTS * 2 + 1; i++) {
+    store(&settings, &data, i);
+    TEST_ASSERT_EQUAL(i % SLOTS, settings.slot());
+
+    settings_t loaded;
+    Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+    TEST_ASSERT_TRUE(boot(&reloaded, &loaded));
+    TEST_ASSERT_EQUAL(i, loaded.brightness);
+    TEST_ASSERT_EQUAL(i % SLOTS, reloaded.slot());
+  }
+
+  // the area is all there is
+  TEST_ASSERT_EQUAL(0xFF, EEPROM.read(START - 1));
+  TEST_ASSERT_EQUAL(0xFF, EEPROM.read(START + SLOTS * RECORD));
+
+}
+
+/**
+ * A reset halfway through a record leaves it torn, the previous one is
+ * loaded and the next save goes on from it
+ */
+void test_torn_write(void) {
+
+  settings_t data;
+  Settings settings = Settings(&data, sizeof(data), VERSION);
+  boot(&settings, &data);
+  store(&settings, &data, 50);
+  store(&settings, &data, 60);
+
+  for (uint8_t written=1; written<RECORD; written++) {
+    data.brightness = 70;
+    settings.save();
+    delay(SETTINGS_QUIET);
+    for (uint8_t i=0; i<written; i++) TEST_ASSERT_TRUE(settings.loop());
+
+    settings_t loaded;
+    Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+    TEST_ASSERT_TRUE(boot(&reloaded, &loaded));
+    TEST_ASSERT_EQUAL(60, loaded.brightness);
+
+    // the torn slot is written again, its stale bytes replaced
+    store(&reloaded, &loaded, 80);
+    Settings again = Settings(&loaded, sizeof(loaded), VERSION);
+    TEST_ASSERT_TRUE(boot(&again, &loaded));
+    TEST_ASSERT_EQUAL(80, loaded.brightness);
+    TEST_ASSERT_EQUAL(reloaded.slot(), again.slot());
+
+    // back to the state before the tear
+    EEPROM.nativeErase();
+    settings = Settings(&data, sizeof(data), VERSION);
+    boot(&settings, &data);
+    store(&settings, &data, 50);
+    store(&settings, &data, 60);
+  }
+
+}
+
+/**
+ * A record whose CRC does not match is skipped for the previous one,
+ * whatever byte went bad
+ */
+void test_corrupt_crc(void) {
+
+  settings_t data;
+  Settings settings = Settings(&data, sizeof(data), VERSION);
+  boot(&settings, &data);
+  store(&settings, &data, 50);
+  store(&settings, &data, 60);
+  uint16_t newest = START + settings.slot() * RECORD;
+
+  for (uint8_t i=0; i<RECORD; i++) {
+    uint8_t value = EEPROM.read(newest + i);
+    EEPROM.write(newest + i, value ^ 0x10);
+
+    settings_t loaded;
+    Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+    TEST_ASSERT_TRUE(boot(&reloaded, &loaded));
+    TEST_ASSERT_EQUAL(50, loaded.brightness);
+
+    EEPROM.write(newest + i, value);
+  }
+
+  // with both bad the defaults stay
+  EEPROM.write(newest + RECORD - 1, EEPROM.read(newest + RECORD - 1) ^ 0x01);
+  EEPROM.write(newest - 1, EEPROM.read(newest - 1) ^ 0x01);
+  settings_t loaded;
+  Settings reloaded = Settings(&loaded, sizeof(loaded), VERSION);
+  TEST_ASSERT_FALSE(boot(&reloaded, &loaded));
+  TEST_ASSERT_EQUAL_MEMORY(&defaults, &loaded, sizeof(loaded));
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blank);
+  RUN_TEST(test_coalesce);
+  RUN_TEST(test_rotation);
+  RUN_TEST(test_torn_write);
+  RUN_TEST(test_corrupt_crc);
+  return UNITY_END();
+}
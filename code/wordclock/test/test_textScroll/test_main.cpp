@@ -0,0 +1,138 @@
+/*
+
+  Word Clock, text scroll
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+#include "textScroll.h"
+
+#define SIZE 8
+#define PERIOD 70
+
+char buffer[SIZE];
+TextScroll scroller = TextScroll(buffer, SIZE);
+
+// 'A' as drawn on the left edge, top row first
+const text_row_t letter_a[FONT_HEIGHT] = {
+  0x7000, 0x8800, 0x8800, 0x8800, 0xF800, 0x8800, 0x8800
+};
+
+void setUp(void) {
+  scroller.begin(PERIOD);
+}
+
+void tearDown(void) {
+}
+
+/**
+ * The window takes the glyph columns from the text column on the left
+ * edge, blank around the text
+ */
+void test_draw(void) {
+
+  text_row_t rows[FONT_HEIGHT];
+  scroller.set(F("A"));
+  TEST_ASSERT_EQUAL(TEXT_ADVANCE, scroller.columns());
+
+  memset(rows, 0, sizeof(rows));
+  scroller.draw(rows, 0);
+  for (uint8_t y=0; y<FONT_HEIGHT; y++) TEST_ASSERT_EQUAL_HEX16(letter_a[y], rows[y]);
+
+  // entering from the right, then leaving to the left
+  memset(rows, 0, sizeof(rows));
+  scroller.draw(rows, -TEXT_WIDTH + 2);
+  for (uint8_t y=0; y<FONT_HEIGHT; y++) TEST_ASSERT_EQUAL_HEX16(letter_a[y] >> (TEXT_WIDTH - 2), rows[y]);
+  memset(rows, 0, sizeof(rows));
+  scroller.draw(rows, 2);
+  for (uint8_t y=0; y<FONT_HEIGHT; y++) TEST_ASSERT_EQUAL_HEX16((text_row_t) (letter_a[y] << 2), rows[y]);
+
+  memset(rows, 0, sizeof(rows));
+  scroller.draw(rows, -TEXT_WIDTH);
+  scroller.draw(rows, TEXT_ADVANCE);
+  for (uint8_t y=0; y<FONT_HEIGHT; y++) TEST_ASSERT_EQUAL_HEX16(0, rows[y]);
+
+}
+
+/**
+ * Text longer than the buffer is cut, characters out of the font show
+ * as FONT_MISSING
+ */
+void test_set(void) {
+
+  text_row_t rows[FONT_HEIGHT];
+  text_row_t missing[FONT_HEIGHT];
+  TEST_ASSERT_EQUAL(SIZE, scroller.set("0123456789", 10));
+  TEST_ASSERT_EQUAL(SIZE * TEXT_ADVANCE, scroller.columns());
+  TEST_ASSERT_EQUAL(SIZE, scroller.set(F("0123456789")));
+
+  scroller.set("?", 1);
+  memset(missing, 0, sizeof(missing));
+  scroller.draw(missing, 0);
+  scroller.set("\x01", 1);
+  memset(rows, 0, sizeof(rows));
+  scroller.draw(rows, 0);
+  TEST_ASSERT_EQUAL_MEMORY(missing, rows, sizeof(rows));
+
+}
+
+/**
+ * The text enters from the right edge a column every period, with the
+ * fraction in between, and is done once it has left on the left
+ */
+void test_position(void) {
+
+  scroller.set(F("AB"));
+  scroller.start(1000);
+  TEST_ASSERT_EQUAL(-TEXT_WIDTH * 256L, scroller.position(1000));
+  TEST_ASSERT_EQUAL(-TEXT_WIDTH * 256L + 128, scroller.position(1000 + PERIOD / 2));
+  TEST_ASSERT_EQUAL((1 - TEXT_WIDTH) * 256L, scroller.position(1000 + PERIOD));
+
+  unsigned long end = 1000 + (scroller.columns() + TEXT_WIDTH) * PERIOD;
+  TEST_ASSERT_FALSE(scroller.done(end - 1));
+  TEST_ASSERT_TRUE(scroller.done(end));
+
+}
+
+/**
+ * Past its end the text stays done, the time shifted into 1/256 columns
+ * would wrap after 4.6 hours and bring it back
+ */
+void test_position_clamp(void) {
+
+  scroller.set(F("AB"));
+  scroller.start(0);
+  long end = (long) scroller.columns() << 8;
+  unsigned long hours[] = { 1, 4, 5, 24, 24 * 49 };
+  for (uint8_t i=0; i<sizeof(hours) / sizeof(hours[0]); i++) {
+    unsigned long now = hours[i] * 3600000UL;
+    TEST_ASSERT_EQUAL(end, scroller.position(now));
+    TEST_ASSERT_TRUE(scroller.done(now));
+  }
+  TEST_ASSERT_TRUE(scroller.done(0xFFFFFFFFUL));
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_draw);
+  RUN_TEST(test_set);
+  RUN_TEST(test_position);
+  RUN_TEST(test_position_clamp);
+  return UNITY_END();
+}
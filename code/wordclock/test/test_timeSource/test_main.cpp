@@ -0,0 +1,261 @@
+/*
+
+  Word Clock, time kept between RTC reads
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include "timeSource.h"
+
+#define RTC_START 1500000000UL
+
+// Frames shown at 50fps, 256 leds keep interrupts off 7.7ms each
+#define FRAME_PERIOD 20000
+#define FRAME_SHOW 7680
+
+// Mock RTC counting whole seconds of wall time at a rate in 1/1000
+unsigned long rtc_base;
+unsigned long long rtc_since;
+unsigned long rtc_rate;
+
+bool rtc_broken;               // reads rtc_garbage instead
+unsigned long rtc_garbage;
+
+unsigned long rtcRead() {
+  if (rtc_broken) return rtc_garbage;
+  return rtc_base + (unsigned long) ((nativeNow() - rtc_since) * rtc_rate / 1000 / 1000000);
+}
+
+void rtcWrite(unsigned long time) {
+  rtc_base = time;
+  rtc_since = nativeNow();
+}
+
+TimeSource timeSource = TimeSource(rtcRead, rtcWrite);
+
+struct run_t {
+  unsigned long backwards;   // times now() went back
+  long error_min;            // now() - RTC, seconds
+  long error_max;
+};
+
+/**
+ * Runs frames for some seconds of wall time, resyncing as asked
+ * @param  unsigned long seconds  Wall time to run
+ * @param  unsigned long show     Microseconds each frame keeps interrupts off
+ * @param  unsigned long resync   Milliseconds between RTC reads, 0 to
+ *                                leave them to loop()
+ * @param  run_t * run            Results
+ */
+void run(unsigned long seconds, unsigned long show, unsigned long resync, run_t * run) {
+  unsigned long previous = timeSource.now();
+  unsigned long last = millis();
+  run->backwards = 0;
+  run->error_min = run->error_max = 0;
+  for (unsigned long frame=0; frame < seconds * 1000000 / FRAME_PERIOD; frame++) {
+    nativeBusy(show);
+    nativeAdvance(FRAME_PERIOD - show);
+    if ((resync > 0) && (millis() - last >= resync)) {
+      last = millis();
+      timeSource.resync();
+    } else {
+      timeSource.loop();
+    }
+    unsigned long now = timeSource.now();
+    if ((long) (now - previous) < 0) run->backwards++;
+    previous = now;
+    long error = (long) (now - rtcRead());
+    if (error < run->error_min) run->error_min = error;
+    if (error > run->error_max) run->error_max = error;
+  }
+}
+
+void setUp(void) {
+  nativeReset();
+  rtc_base = RTC_START;
+  rtc_since = 0;
+  rtc_rate = 1000;
+  rtc_broken = false;
+  timeSource.begin();
+}
+
+void tearDown(void) {
+}
+
+void test_extrapolate(void) {
+  TEST_ASSERT_EQUAL_UINT32(RTC_START, timeSource.now());
+  run_t r;
+  run(30, 0, 0, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+  TEST_ASSERT_EQUAL(0, r.error_min);
+  TEST_ASSERT_EQUAL(0, r.error_max);
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 30, timeSource.now());
+}
+
+void test_skewed_millis(void) {
+
+  // the shows make millis() lose over a third of its ticks
+  run_t r;
+  run(60, FRAME_SHOW, 0, &r);
+  TEST_ASSERT_LESS_THAN(45000, millis());
+  TEST_ASSERT_LESS_THAN(-15, r.error_min);
+
+  // reading the RTC every second of millis(), over a second and a half
+  // of wall time, keeps the time right to two seconds
+  setUp();
+  run(600, FRAME_SHOW, 1000, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+  TEST_ASSERT_GREATER_OR_EQUAL(-2, r.error_min);
+  TEST_ASSERT_LESS_OR_EQUAL(0, r.error_max);
+
+}
+
+void test_resync_keeps_phase(void) {
+
+  // resyncs that agree with the estimate keep counting from its base
+  nativeAdvance(999000);
+  timeSource.resync();
+  TEST_ASSERT_EQUAL(0, timeSource.drift());
+  nativeAdvance(2000);
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 1, timeSource.now());
+
+  // many resyncs a second don't slow it down
+  for (byte i=0; i<100; i++) {
+    nativeAdvance(300000);
+    timeSource.resync();
+    TEST_ASSERT_EQUAL_UINT32(rtcRead(), timeSource.now());
+  }
+
+}
+
+void test_monotonic(void) {
+
+  // millis() running 2% fast on the resonator puts the estimate ahead,
+  // resyncs hold the time instead of sending it back
+  rtc_rate = 980;
+  run_t r;
+  run(3600, 0, 0, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+  TEST_ASSERT_LESS_OR_EQUAL(2, r.error_max);
+
+  // adjusting is the only way back
+  unsigned long now = timeSource.now();
+  timeSource.adjust(now - 3600);
+  TEST_ASSERT_EQUAL_UINT32(now - 3600, timeSource.now());
+  TEST_ASSERT_EQUAL_UINT32(now - 3600, rtcRead());
+  run(600, 0, 0, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+
+}
+
+void test_periodic_resync(void) {
+  unsigned long reads = timeSource.reads();
+  run_t r;
+  run(TIME_RESYNC_MILLIS / 1000 * 5 + 1, 0, 0, &r);
+  TEST_ASSERT_EQUAL(5, timeSource.reads() - reads);
+  TEST_ASSERT_EQUAL(0, r.error_max);
+}
+
+void tick() {
+  timeSource.tick();
+  nativeInterrupt(1000000, tick);
+}
+
+void test_ticks(void) {
+
+  // the square wave keeps the time even while millis() loses ticks
+  nativeInterrupt(1000000, tick);
+  timeSource.begin(true);
+  run_t r;
+  run(60, FRAME_SHOW, 0, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+  TEST_ASSERT_EQUAL(0, r.error_min);
+  TEST_ASSERT_EQUAL(0, r.error_max);
+
+}
+
+/**
+ * Reads the RTC once with a garbage value
+ * @param  unsigned long value    What the read gives
+ */
+void garbage(unsigned long value) {
+  rtc_garbage = value;
+  rtc_broken = true;
+  timeSource.resync();
+  rtc_broken = false;
+}
+
+void test_garbage_read(void) {
+
+  run_t r;
+  run(10, 0, 0, &r);
+  unsigned long rejected = timeSource.rejected();
+
+  // a failed read and one years ahead are both left out
+  garbage(TIME_INVALID);
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 10, timeSource.now());
+  garbage(RTC_START + 10 * 365 * 86400UL);
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 10, timeSource.now());
+  TEST_ASSERT_EQUAL(rejected + 2, timeSource.rejected());
+
+  // the clock goes on, the next reads are right
+  run(120, 0, 0, &r);
+  TEST_ASSERT_EQUAL(0, r.backwards);
+  TEST_ASSERT_EQUAL(0, r.error_min);
+  TEST_ASSERT_EQUAL(0, r.error_max);
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 130, timeSource.now());
+
+}
+
+void test_confirmed_jump(void) {
+
+  run_t r;
+  run(10, 0, 0, &r);
+  unsigned long rejected = timeSource.rejected();
+
+  // the RTC set an hour ahead elsewhere is taken once read twice, the
+  // second read comes TIME_RESYNC_RETRY ms after the first one
+  rtcWrite(rtcRead() + 3600);
+  timeSource.resync();
+  TEST_ASSERT_EQUAL_UINT32(RTC_START + 10, timeSource.now());
+  run(TIME_RESYNC_RETRY / 1000 + 1, 0, 0, &r);
+  TEST_ASSERT_EQUAL_UINT32(rtcRead(), timeSource.now());
+  TEST_ASSERT_EQUAL(rejected + 1, timeSource.rejected());
+
+  // an hour back is taken at once too, the time does not hold an hour
+  rtcWrite(rtcRead() - 3600);
+  timeSource.resync();
+  run(TIME_RESYNC_RETRY / 1000 + 1, 0, 0, &r);
+  TEST_ASSERT_EQUAL_UINT32(rtcRead(), timeSource.now());
+  TEST_ASSERT_EQUAL(rejected + 2, timeSource.rejected());
+
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_extrapolate);
+  RUN_TEST(test_skewed_millis);
+  RUN_TEST(test_resync_keeps_phase);
+  RUN_TEST(test_monotonic);
+  RUN_TEST(test_periodic_resync);
+  RUN_TEST(test_ticks);
+  RUN_TEST(test_garbage_read);
+  RUN_TEST(test_confirmed_jump);
+  return UNITY_END();
+}
@@ -0,0 +1,473 @@
+/*
+
+  Word Clock, the sketch running on the native clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <unity.h>
+
+#include "../../src/wordclock.ino"
+
+// Time from a button edge to the mode change, and to its first frame, in
+// millis(). The shows keep interrupts off, the strip gives millis() the
+// ticks lost back
+#define BUTTON_LATENCY (DEBOUNCE_DELAY + TASK_BUTTONS_PERIOD)
+#define FRAME_LATENCY (BUTTON_LATENCY + UPDATE_MATRIX)
+
+// Wall time a request waits for its reply and times it is sent, as
+// tools/wordclock.py does
+#define REQUEST_TIMEOUT 250
+#define REQUEST_TRIES 3
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+/**
+ * Milliseconds of wall time since boot
+ */
+unsigned long wall() {
+   return nativeNow() / 1000;
+}
+
+/**
+ * Runs the sketch until a condition holds
+ * @param  bool (*condition)()    Condition to wait for
+ * @param  unsigned long ms       Wall time to give up after
+ * @return bool                   True if the condition holds
+ */
+bool runUntil(bool (*condition)(), unsigned long ms) {
+   unsigned long until = wall() + ms;
+   while (!condition()) {
+      if ((long) (wall() - until) >= 0) return false;
+      loop();
+   }
+   return true;
+}
+
+/**
+ * Runs the sketch for a while
+ * @param  unsigned long ms       Wall time to run
+ */
+void run(unsigned long ms) {
+   unsigned long until = wall() + ms;
+   while ((long) (wall() - until) < 0) loop();
+}
+
+/**
+ * Drives a button pin, the pin change interrupt samples it
+ * @param  byte pin               Button pin
+ * @param  byte level             LOW is pressed
+ */
+void button(byte pin, byte level) {
+   nativeSetPin(pin, level);
+   noInterrupts();
+   buttonChanges.sample();
+   interrupts();
+}
+
+byte wanted_phase = 0;
+bool inPhase() { return (mode == MODE_MATRIX) && (matrix_phase == wanted_phase); }
+bool notMatrix() { return mode != MODE_MATRIX; }
+unsigned long frames_before = 0;
+bool frameShown() { return frames_shown != frames_before; }
+
+/**
+ * Clicks a button, a frame must have been shown by the time it is released
+ * @param  byte pin               Button pin
+ */
+void click(byte pin) {
+   frames_before = frames_shown;
+   button(pin, LOW);
+   run(DEBOUNCE_DELAY * 2);
+   button(pin, HIGH);
+   run(DEBOUNCE_DELAY * 2);
+   TEST_ASSERT_TRUE(frameShown());
+}
+
+/**
+ * Sends a command frame to the serial port
+ * @param  byte command           Command
+ * @param  const byte * payload   Payload
+ * @param  byte length            Payload length
+ * @param  unsigned long after    Microseconds before it starts
+ */
+void send(byte command, const byte * payload, byte length, unsigned long after = 0) {
+   byte frame[255 + PROTOCOL_OVERHEAD];
+   byte size = Protocol::frame(frame, command, payload, length);
+   TEST_ASSERT_EQUAL(size, Serial.nativeSend(frame, size, after));
+}
+
+// Frames the sketch sends back, parsed as the host would, and the
+// log around them
+byte host_payload[255];
+Protocol host = Protocol(host_payload, 255);
+char host_log[4096];
+unsigned int host_log_length = 0;
+
+/**
+ * Runs the sketch until it replies
+ * @param  byte command           Command of the reply
+ * @param  unsigned long ms       Wall time to wait
+ * @return bool                   True if it came in time
+ */
+bool reply(byte command, unsigned long ms) {
+   byte wire[64];
+   unsigned long until = wall() + ms;
+   while ((long) (wall() - until) < 0) {
+      loop();
+      size_t n = Serial.nativeReceive(wire, sizeof(wire));
+      for (size_t i=0; i<n; i++) {
+         byte parsed = host.feed(wire[i], millis());
+         if ((parsed == PROTOCOL_TEXT) && (host_log_length < sizeof(host_log) - 1)) {
+            host_log[host_log_length++] = wire[i];
+            host_log[host_log_length] = 0;
+         }
+         if ((parsed == PROTOCOL_FRAME) && (host.command() == command)) return true;
+      }
+   }
+   return false;
+}
+
+byte request_tries = 0;
+
+/**
+ * Sends a command until it is answered, as tools/wordclock.py does,
+ * request_tries tells how many times it took
+ * @param  byte command           Command
+ * @param  const byte * payload   Payload
+ * @param  byte length            Payload length
+ * @param  unsigned long after    Microseconds before the first try starts
+ * @return bool                   True if it was answered
+ */
+bool request(byte command, const byte * payload, byte length, unsigned long after = 0) {
+   for (request_tries=1; request_tries<=REQUEST_TRIES; request_tries++) {
+      send(command, payload, length, request_tries == 1 ? after : 0);
+      if (reply(command | COMMAND_REPLY, REQUEST_TIMEOUT)) return true;
+   }
+   return false;
+}
+
+/**
+ * CIE L* of a led duty, the lightness perceived
+ * @param  byte duty              Byte sent, 0 to 255
+ */
+double lightness(byte duty) {
+   double y = duty / 255.0;
+   return y > 0.008856 ? 116.0 * cbrt(y) - 16.0 : 903.3 * y;
+}
+
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * The mode button is served within a frame in every phase of the
+ * matrix effect, the hold included
+ */
+void test_matrix_latency(void) {
+
+   char message[64];
+
+   for (byte phase=MATRIX_RAIN; phase<=MATRIX_HOLD; phase++) {
+
+      // back to the matrix, in the phase under test
+      mode = MODE_MATRIX;
+      matrix_phase = MATRIX_RAIN;
+      matrix_count = 0;
+      update_pending = true;
+      wanted_phase = phase;
+      TEST_ASSERT_TRUE(runUntil(inPhase, (STICKY_COUNT + STICKY_MAX) * UPDATE_MATRIX + STICKY_PAUSE));
+      run(phase == MATRIX_HOLD ? STICKY_PAUSE / 2 : 5 * UPDATE_MATRIX);
+      TEST_ASSERT_TRUE(inPhase());
+
+      // a click
+      button(PIN_BUTTON_MODE, LOW);
+      run(DEBOUNCE_DELAY * 2);
+      TEST_ASSERT_EQUAL(MODE_MATRIX, mode);
+      button(PIN_BUTTON_MODE, HIGH);
+      unsigned long released = millis();
+      unsigned long released_wall = wall();
+      frames_before = frames_shown;
+
+      TEST_ASSERT_TRUE(runUntil(notMatrix, FRAME_LATENCY * 4));
+      unsigned long changed = millis() - released;
+      TEST_ASSERT_EQUAL(MODE_TEXT, mode);
+      TEST_ASSERT_TRUE(runUntil(frameShown, FRAME_LATENCY * 4));
+      unsigned long shown = millis() - released;
+
+      snprintf(message, sizeof(message), "phase %d: mode after %lums, frame after %lums (%lums wall)",
+         phase, changed, shown, wall() - released_wall);
+      TEST_MESSAGE(message);
+      TEST_ASSERT_LESS_OR_EQUAL(BUTTON_LATENCY, changed);
+      TEST_ASSERT_LESS_OR_EQUAL(FRAME_LATENCY, shown);
+
+   }
+
+}
+
+/**
+ * The brightness button walks the levels in steps of about the same
+ * perceived lightness, measured on the bytes sent for white words
+ */
+void test_brightness_steps(void) {
+
+   char message[64];
+   byte frame[TOTAL_PIXELS * 3];
+
+   matrix.setDither(false);
+   mode = MODE_CLOCK;
+   color = 0;
+   brightness = 255;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+   TEST_ASSERT_EQUAL_HEX32(COLOR_WHITE, pgm_read_dword(&colors[color]));
+
+   double previous = 0;
+   byte steps = 0;
+   do {
+      click(PIN_BUTTON_BRIGHTNESS);
+      nativeWireRead(frame, 0);
+      matrix.show();
+      TEST_ASSERT_EQUAL(sizeof(frame), nativeWireRead(frame, sizeof(frame)));
+      byte duty = 0;
+      for (unsigned int i=0; i<sizeof(frame); i++) {
+         if (frame[i] > duty) duty = frame[i];
+      }
+      double level = lightness(duty);
+      snprintf(message, sizeof(message), "brightness %d: duty %d, L* %.1f", brightness, duty, level);
+      TEST_MESSAGE(message);
+      if (steps > 0) {
+         TEST_ASSERT_FLOAT_WITHIN(2.5, 6.5, level - previous);
+      }
+      previous = level;
+      steps++;
+   } while (brightness < 255);
+
+   TEST_ASSERT_EQUAL(15, steps);
+   TEST_ASSERT_FLOAT_WITHIN(0.1, 100.0, previous);
+   #ifdef DITHER
+      matrix.setDither(true);
+   #endif
+
+}
+
+/**
+ * A release lost to a full queue is still seen, the button does not
+ * stay pressed and the next press counts
+ */
+void test_button_overflow(void) {
+
+   mode = MODE_CLOCK;
+   brightness = BRIGHTNESS_MIN;
+   run(UPDATE_MATRIX * 2);
+   unsigned int overflows = buttonChanges.overflows();
+
+   // press, then a bouncing button fills the queue before the release
+   button(PIN_BUTTON_BRIGHTNESS, LOW);
+   run(DEBOUNCE_DELAY * 2);
+   TEST_ASSERT_EQUAL(BRIGHTNESS_MIN + BRIGHTNESS_STEP, brightness);
+   for (byte i=0; i<BUTTON_QUEUE; i++) {
+      button(PIN_BUTTON_COLOR, LOW);
+      button(PIN_BUTTON_COLOR, HIGH);
+   }
+   button(PIN_BUTTON_BRIGHTNESS, HIGH);
+   TEST_ASSERT_TRUE(buttonChanges.overflows() > overflows);
+
+   run(DEBOUNCE_DELAY * 2);
+   TEST_ASSERT_EQUAL(0x0F, buttons_levels);
+   TEST_ASSERT_EQUAL(BRIGHTNESS_MIN + BRIGHTNESS_STEP, brightness);
+   TEST_ASSERT_EQUAL(0, color);
+
+   click(PIN_BUTTON_BRIGHTNESS);
+   TEST_ASSERT_EQUAL(BRIGHTNESS_MIN + 2 * BRIGHTNESS_STEP, brightness);
+
+}
+
+bool minuteStart() { return DateTime(timeSource.now()).second() < 5; }
+
+/**
+ * Once the clock has drawn the time it shows nothing until the minute
+ * changes, the timer interrupt keeps millis() with the wall time and
+ * the CPU sleeps between tasks
+ */
+void test_clock_idle(void) {
+
+   mode = MODE_CLOCK;
+   update_pending = true;
+   TEST_ASSERT_TRUE(runUntil(minuteStart, 61000UL));
+   run(2000);
+
+   unsigned long shown = frames_shown;
+   unsigned long started = millis();
+   unsigned long started_wall = wall();
+   run(30000);
+   TEST_ASSERT_EQUAL(shown, frames_shown);
+   TEST_ASSERT_UINT_WITHIN(2, wall() - started_wall, millis() - started);
+
+}
+
+bool textDone() { return mode != MODE_TEXT; }
+
+/**
+ * A message scrolls once over the clock, a frame every render, and the
+ * clock comes back once it has left
+ */
+void test_text_message(void) {
+
+   char message[80];
+   mode = MODE_CLOCK;
+   text_return = MODE_TEXT;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+
+   const char text[] = "HELLO";
+   send(COMMAND_TEXT, (const byte *) text, strlen(text));
+   TEST_ASSERT_TRUE(reply(COMMAND_TEXT | COMMAND_REPLY, 1000));
+   TEST_ASSERT_EQUAL(MODE_TEXT, mode);
+
+   // a second of scrolling, a frame every UPDATE_MATRIX of wall time
+   unsigned long shown = frames_shown;
+   unsigned long started = millis();
+   unsigned long started_wall = wall();
+   run(1000);
+   unsigned long frames = frames_shown - shown;
+   unsigned long elapsed = wall() - started_wall;
+   snprintf(message, sizeof(message), "%lu frames in %lums wall, %lums of millis()", frames, elapsed, millis() - started);
+   TEST_MESSAGE(message);
+   TEST_ASSERT_UINT_WITHIN(2, elapsed / UPDATE_MATRIX, frames);
+   TEST_ASSERT_UINT_WITHIN(2, elapsed, millis() - started);
+
+   unsigned long scroll = (strlen(text) * TEXT_ADVANCE + TEXT_WIDTH) * TEXT_PERIOD;
+   TEST_ASSERT_TRUE(runUntil(textDone, scroll * 2));
+   TEST_ASSERT_EQUAL(MODE_CLOCK, mode);
+
+}
+
+/**
+ * A message longer than TEXT_MAX is refused with an error, the clock
+ * goes on and none of its bytes is run as a text command
+ */
+void test_text_oversize(void) {
+
+   mode = MODE_CLOCK;
+   text_return = MODE_TEXT;
+   run(UPDATE_MATRIX * 2);
+
+   byte text[TEXT_MAX + 1];
+   memset(text, 'm', sizeof(text));
+   unsigned long errors = protocol.errors();
+   host_log_length = 0;
+   send(COMMAND_TEXT, text, sizeof(text));
+   TEST_ASSERT_TRUE(reply(COMMAND_ERROR, 1000));
+   TEST_ASSERT_EQUAL(2, host.length());
+   TEST_ASSERT_EQUAL_HEX8(COMMAND_TEXT, host.payload()[0]);
+   TEST_ASSERT_EQUAL(ERROR_LENGTH, host.payload()[1]);
+   TEST_ASSERT_EQUAL(errors + 1, protocol.errors());
+   TEST_ASSERT_NULL(strstr(host_log, "RAM: "));
+   TEST_ASSERT_EQUAL(MODE_CLOCK, mode);
+
+}
+
+/**
+ * The text command dumps go through the log whole, a line at a time,
+ * while the matrix effect runs and a command frame is answered
+ */
+void test_dump(void) {
+
+   mode = MODE_MATRIX;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+
+   host_log_length = 0;
+   host_log[0] = 0;
+   unsigned long dropped = logger.dropped();
+   TEST_ASSERT_EQUAL(2, Serial.nativeSend((const byte *) "sm", 2));
+   TEST_ASSERT_TRUE(request(COMMAND_PING, NULL, 0));
+   TEST_ASSERT_FALSE(reply(0, 1000));
+
+   TEST_ASSERT_EQUAL(0, dump_pending);
+   TEST_ASSERT_EQUAL(dropped, logger.dropped());
+   TEST_ASSERT_NULL(strchr(host_log, '~'));
+   const char * lines[] = { "Task 0: runs ", "Task 5: runs ", "Buttons: ", "Serial: ", "Idle: asleep ", "RAM: static ", "  serial " };
+   for (byte i=0; i<sizeof(lines) / sizeof(lines[0]); i++) {
+      TEST_ASSERT_NOT_NULL_MESSAGE(strstr(host_log, lines[i]), lines[i]);
+   }
+   TEST_ASSERT_TRUE(strstr(host_log, "Idle: asleep ") < strstr(host_log, "RAM: static "));
+
+   mode = MODE_CLOCK;
+
+}
+
+/**
+ * The shows keep interrupts off long enough for the USART to overrun,
+ * a request arriving then loses bytes and is sent again
+ */
+#define OVERRUN_REQUESTS 20
+void test_serial_overrun(void) {
+
+   mode = MODE_MATRIX;
+   update_pending = true;
+   run(UPDATE_MATRIX * 2);
+
+   unsigned long overruns = Serial.nativeOverruns();
+   unsigned long errors = protocol.errors();
+   unsigned int tries = 0;
+   unsigned long seed = 1;
+   for (byte i=0; i<OVERRUN_REQUESTS; i++) {
+      // anywhere in the render period
+      seed = seed * 1103515245UL + 12345UL;
+      unsigned long offset = (seed >> 8) % (UPDATE_MATRIX * 1000UL);
+      TEST_ASSERT_TRUE(request(COMMAND_GET_TIME, NULL, 0, offset));
+      tries += request_tries;
+   }
+
+   char message[80];
+   snprintf(message, sizeof(message), "%d requests took %u tries, %lu bytes overrun",
+      OVERRUN_REQUESTS, tries, Serial.nativeOverruns() - overruns);
+   TEST_MESSAGE(message);
+   TEST_ASSERT_TRUE(Serial.nativeOverruns() > overruns);
+   TEST_ASSERT_TRUE(tries > OVERRUN_REQUESTS);
+   TEST_ASSERT_EQUAL(tries - OVERRUN_REQUESTS, protocol.errors() - errors);
+
+   mode = MODE_CLOCK;
+
+}
+
+int main(int argc, char **argv) {
+   nativeReset();
+   rtc.adjust(DateTime(2016, 1, 1, 10, 0, 0));
+   setup();
+   UNITY_BEGIN();
+   RUN_TEST(test_matrix_latency);
+   RUN_TEST(test_brightness_steps);
+   RUN_TEST(test_clock_idle);
+   RUN_TEST(test_button_overflow);
+   RUN_TEST(test_text_message);
+   RUN_TEST(test_text_oversize);
+   RUN_TEST(test_dump);
+   RUN_TEST(test_serial_overrun);
+   return UNITY_END();
+}
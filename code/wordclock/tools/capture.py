@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+
+  Word Clock - frame capture decoder
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+  Records the frames a clock built with CAPTURE streams, rebuilds them
+  and shows them in the terminal, writes them as PPM images or compares
+  two recordings frame by frame. Build with MATRIX_SEED set to record
+  the same rain every time.
+
+  Usage: capture.py record [-p PORT] [--period MS] [--frames N] [--view] FILE
+         capture.py show [--ppm DIR] [--scale N] [--delay] FILE
+         capture.py diff FILE FILE
+
+"""
+
+import argparse
+import os
+import sys
+import time
+
+from wordclock import Client, ProtocolError, frame, COMMAND_CAPTURE, COMMAND_REPLY
+
+# Must match wordclock.ino
+CAPTURE_CLOCK = 0x40
+CAPTURE_PIXELS = 0x41
+CAPTURE_PALETTE = 0x42
+CAPTURE_HEADER = 4
+PALETTE_SIZE = 16
+
+
+class Frame:
+
+    def __init__(self, sequence, millis, width, height):
+        self.sequence = sequence
+        self.millis = millis
+        self.width = width
+        self.height = height
+        self.pixels = [[(0, 0, 0)] * width for _ in range(height)]
+
+    def __eq__(self, other):
+        return self.pixels == other.pixels
+
+    def __ne__(self, other):
+        return not self == other
+
+
+class Decoder:
+    """Rebuilds frames from the capture stream, as captureFrame() writes them"""
+
+    def __init__(self, width, height, row_bytes):
+        self.width = width
+        self.height = height
+        self.row_bytes = row_bytes
+        self.rows_bytes = (height + 7) // 8
+        self.palette = [0] * PALETTE_SIZE
+
+    def _scale(self, color, brightness):
+        return tuple(((color >> shift) & 0xFF) * (brightness + 1) >> 8 for shift in (16, 8, 0))
+
+    def _lit(self, payload, at):
+        """Lit leds as (x, y) in stream order and where the data ends"""
+        rows = []
+        for y in range(self.height):
+            if payload[at + y // 8] & (1 << (y % 8)):
+                rows.append(y)
+        at += self.rows_bytes
+        leds = []
+        for y in rows:
+            mask = int.from_bytes(payload[at:at + self.row_bytes], 'little')
+            at += self.row_bytes
+            leds.extend((x, y) for x in range(self.width) if mask & (1 << x))
+        return leds, at
+
+    def feed(self, command, payload):
+        """Takes a frame of the stream, returns a Frame once one is complete"""
+
+        if command == CAPTURE_PALETTE:
+            self.palette = [(payload[i] << 16) | (payload[i + 1] << 8) | payload[i + 2] for i in range(0, 3 * PALETTE_SIZE, 3)]
+            return None
+
+        if command not in (CAPTURE_CLOCK, CAPTURE_PIXELS):
+            return None
+
+        result = Frame(payload[0], payload[1] | (payload[2] << 8), self.width, self.height)
+        brightness = payload[3]
+        at = CAPTURE_HEADER
+        if command == CAPTURE_CLOCK:
+            color = self._scale((payload[at] << 16) | (payload[at + 1] << 8) | payload[at + 2], brightness)
+            leds, _ = self._lit(payload, at + 3)
+            for x, y in leds:
+                result.pixels[y][x] = color
+        else:
+            leds, at = self._lit(payload, at)
+            for i, (x, y) in enumerate(leds):
+                index = (payload[at + i // 2] >> (4 * (i % 2))) & 0x0F
+                result.pixels[y][x] = self._scale(self.palette[index], brightness)
+        return result
+
+
+class Recording:
+    """A capture as saved by record: the capture reply, then the stream as received"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+
+    def frames(self):
+        at = 0
+        decoder = None
+        while at + 4 <= len(self.data):
+            command, length = self.data[at + 1], self.data[at + 2]
+            payload = self.data[at + 3:at + 3 + length]
+            at += length + 4
+            if command == COMMAND_CAPTURE | COMMAND_REPLY:
+                decoder = Decoder(*payload[:3])
+            elif decoder:
+                result = decoder.feed(command, payload)
+                if result:
+                    yield result
+
+
+def terminal(result):
+    """Two leds per character, upper one as foreground"""
+    lines = []
+    for y in range(0, result.height, 2):
+        line = ''
+        for x in range(result.width):
+            top = result.pixels[y][x]
+            bottom = result.pixels[y + 1][x] if y + 1 < result.height else (0, 0, 0)
+            line += '\x1b[38;2;%d;%d;%dm\x1b[48;2;%d;%d;%dm▀' % (top + bottom)
+        lines.append(line + '\x1b[0m')
+    return '\n'.join(lines)
+
+
+def ppm(result, path, scale):
+    with open(path, 'wb') as f:
+        f.write(b'P6 %d %d 255\n' % (result.width * scale, result.height * scale))
+        for row in result.pixels:
+            line = b''.join(bytes(pixel) * scale for pixel in row)
+            f.write(line * scale)
+
+
+def record(args):
+    try:
+        import serial
+    except ImportError:
+        print('error: pyserial is needed, pip install pyserial', file=sys.stderr)
+        return 1
+
+    port = serial.Serial(args.port, args.baud, timeout=0.05)
+    time.sleep(2)
+    client = Client(port, log=lambda line: print(line, file=sys.stderr))
+    count = 0
+    with open(args.file, 'wb') as out:
+        try:
+            reply = client.request(COMMAND_CAPTURE, bytes([args.period & 0xFF, args.period >> 8]))
+            out.write(frame(COMMAND_CAPTURE | COMMAND_REPLY, reply))
+            decoder = Decoder(*reply[:3])
+            while args.frames == 0 or count < args.frames:
+                received = client.poll()
+                if received is None:
+                    continue
+                out.write(frame(*received))
+                result = decoder.feed(*received)
+                if result:
+                    count += 1
+                    if args.view:
+                        print('\x1b[H' + terminal(result))
+        except ProtocolError as e:
+            print('error: %s' % e, file=sys.stderr)
+            return 1
+        except KeyboardInterrupt:
+            pass
+        finally:
+            port.write(frame(COMMAND_CAPTURE, b'\x00\x00'))
+    print('%d frames' % count, file=sys.stderr)
+    return 0
+
+
+def show(args):
+    if args.ppm:
+        os.makedirs(args.ppm, exist_ok=True)
+    previous = None
+    for result in Recording(args.file).frames():
+        if args.ppm:
+            ppm(result, os.path.join(args.ppm, 'frame%05d.ppm' % result.sequence), args.scale)
+            continue
+        if args.delay and previous is not None:
+            time.sleep(((result.millis - previous) & 0xFFFF) / 1000.0)
+        previous = result.millis
+        print('\x1b[H' + terminal(result))
+        print('frame %d at %d ms' % (result.sequence, result.millis))
+    return 0
+
+
+def diff(args):
+    first = list(Recording(args.files[0]).frames())
+    second = list(Recording(args.files[1]).frames())
+    different = [i for i, (a, b) in enumerate(zip(first, second)) if a != b]
+    print('%d and %d frames, %d different' % (len(first), len(second), len(different)))
+    if different:
+        i = different[0]
+        a, b = first[i], second[i]
+        leds = sum(a.pixels[y][x] != b.pixels[y][x] for y in range(a.height) for x in range(a.width))
+        print('first at frame %d (sequence %d / %d), %d leds differ' % (i, a.sequence, b.sequence, leds))
+    return 1 if different or len(first) != len(second) else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Record, show and compare wordclock frame captures')
+    commands = parser.add_subparsers(dest='command')
+    commands.required = True
+    record_parser = commands.add_parser('record', help='record the frames a clock streams')
+    record_parser.add_argument('file')
+    record_parser.add_argument('-p', '--port', default='/dev/ttyUSB0', help='serial port (default: /dev/ttyUSB0)')
+    record_parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate (default: 115200)')
+    record_parser.add_argument('--period', type=int, default=100, help='ms between frames at least (default: 100)')
+    record_parser.add_argument('--frames', type=int, default=0, help='stop after N frames (default: until interrupted)')
+    record_parser.add_argument('--view', action='store_true', help='show the frames while recording')
+    show_parser = commands.add_parser('show', help='play a recording in the terminal or write it as images')
+    show_parser.add_argument('file')
+    show_parser.add_argument('--ppm', metavar='DIR', help='write every frame as DIR/frameNNNNN.ppm')
+    show_parser.add_argument('--scale', type=int, default=8, help='image pixels per led (default: 8)')
+    show_parser.add_argument('--delay', action='store_true', help='play at the recorded pace')
+    diff_parser = commands.add_parser('diff', help='compare two recordings frame by frame')
+    diff_parser.add_argument('files', nargs=2, metavar='FILE')
+    args = parser.parse_args()
+
+    return {'record': record, 'show': show, 'diff': diff}[args.command](args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
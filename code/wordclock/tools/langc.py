@@ -0,0 +1,484 @@
+#!/usr/bin/env python3
+"""
+
+  Word Clock - language compiler
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+  Compiles a language definition (languages/*.lang) against its letter
+  stencil into the PROGMEM tables read by loadLanguage(). Before writing
+  anything it checks that:
+
+  - every word spells its text on the stencil
+  - every minute has a rule and every hour of the day a word and a period
+  - no two words lit at the same time share a led, unless one of them
+    is fully contained in the other (d'una / una)
+  - no time lights more words than a sentence_t holds
+
+  Usage: langc.py [--check] [-o DIR] FILE.lang [FILE.lang ...]
+
+"""
+
+import argparse
+import os
+import sys
+
+# Stencils are any grid up to the widest row_t in wordclock.h,
+# words are placed on a 16x16 grid until a stencil says otherwise
+WIDTH = 16
+HEIGHT = 16
+MAX_WIDTH = 64
+MAX_HEIGHT = 255
+
+# Must match language.h
+LANGUAGE_MAX_WORDS = 28
+LANGUAGE_HOURS = 12
+LANGUAGE_PERIOD_WORDS = 3
+SENTENCE_MAX_WORDS = 13
+RULE_FLAGS = {
+    'next': 'RULE_NEXT_HOUR',
+    'singular': 'RULE_SINGULAR',
+    'agree': 'RULE_AGREE',
+    'determiner': 'RULE_DETERMINER',
+}
+
+# Sizes on the ATmega328P
+SIZEOF_ROW = {8: 1, 16: 2, 32: 4, 64: 8}
+SIZEOF_RULE = 4
+SIZEOF_POINTER = 2
+SIZEOF_LANGUAGE = 6 * SIZEOF_POINTER + SIZEOF_RULE + 2
+
+LICENSE = """/*
+
+  Word Clock
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+"""
+
+
+class Language:
+
+    def __init__(self, path):
+        self.path = path
+        self.name = None
+        self.prefix = None
+        self.stencil = None
+        self.width = WIDTH
+        self.height = HEIGHT
+        self.words = {}         # name -> (row, mask)
+        self.word_order = []
+        self.slots = []         # (name, singular, plural, line)
+        self.highlights = []    # (slot, line)
+        self.rules = {}         # minute -> (flags, slots, comment, line)
+        self.hours = None
+        self.determiners = None
+        self.periods = []       # (start, words, line)
+        self.errors = []
+        self.warnings = []
+
+    # -------------------------------------------------------------------------
+    # Parsing
+    # -------------------------------------------------------------------------
+
+    def error(self, line, message):
+        self.errors.append('%s:%d: %s' % (self.path, line, message))
+
+    def parse(self):
+        flags = []
+        with open(self.path, encoding='utf-8') as f:
+            for number, raw in enumerate(f, 1):
+                text, _, comment = raw.partition('#')
+                tokens = text.split()
+                if not tokens:
+                    continue
+                keyword, args = tokens[0], tokens[1:]
+                if keyword.isdigit():
+                    self.parse_rule(number, int(keyword), flags, args, comment.strip())
+                elif keyword == 'flags':
+                    unknown = [a for a in args if a not in RULE_FLAGS]
+                    if unknown:
+                        self.error(number, 'unknown flags %s' % ' '.join(unknown))
+                    flags = [a for a in args if a in RULE_FLAGS]
+                elif keyword == 'language' and len(args) == 2:
+                    self.name, self.prefix = args
+                elif keyword == 'stencil' and len(args) == 1:
+                    self.load_stencil(number, os.path.join(os.path.dirname(self.path), args[0]))
+                elif keyword == 'word' and len(args) >= 4 and len(args) % 2 == 0:
+                    self.parse_word(number, args)
+                elif keyword == 'slot' and len(args) in (2, 3):
+                    self.slots.append((args[0], args[1], args[-1], number))
+                elif keyword == 'highlight' and args:
+                    self.highlights.extend((a, number) for a in args)
+                elif keyword == 'hours':
+                    self.hours = (args, number)
+                elif keyword == 'determiners':
+                    self.determiners = (args, number)
+                elif keyword == 'period' and len(args) >= 2 and args[0].isdigit():
+                    self.periods.append((int(args[0]), args[1:], number))
+                else:
+                    self.error(number, 'cannot parse "%s"' % text.strip())
+        if self.name is None:
+            self.error(1, 'missing "language <name> <prefix>"')
+        if self.stencil is None:
+            self.error(1, 'missing "stencil <file>"')
+
+    def load_stencil(self, line, path):
+        rows = []
+        try:
+            with open(path, encoding='utf-8') as f:
+                for raw in f:
+                    row = raw.partition('#')[0].strip()
+                    if row:
+                        rows.append(row)
+        except OSError as e:
+            self.error(line, 'cannot read stencil: %s' % e)
+            return
+        if not rows or any(len(row) != len(rows[0]) for row in rows):
+            self.error(line, '%s is not a rectangular grid' % path)
+            return
+        if len(rows[0]) > MAX_WIDTH or len(rows) > MAX_HEIGHT:
+            self.error(line, '%s is larger than %dx%d' % (path, MAX_WIDTH, MAX_HEIGHT))
+            return
+        if self.words:
+            self.error(line, 'stencil must come before the words')
+            return
+        self.stencil = rows
+        self.width = len(rows[0])
+        self.height = len(rows)
+
+    def parse_word(self, line, args):
+        name, row = args[0], args[1]
+        if name in self.words:
+            self.error(line, 'word %s defined twice' % name)
+            return
+        if not row.isdigit() or int(row) >= self.height:
+            self.error(line, 'word %s: bad row %s' % (name, row))
+            return
+        row = int(row)
+        mask = 0
+        for i in range(2, len(args), 2):
+            column, text = args[i], args[i + 1]
+            if not column.isdigit() or int(column) + len(text) > self.width:
+                self.error(line, 'word %s: "%s" does not fit at column %s' % (name, text, column))
+                return
+            column = int(column)
+            if self.stencil is not None:
+                found = self.stencil[row][column:column + len(text)]
+                if found != text:
+                    self.error(line, 'word %s: expected "%s" at %d,%d but the stencil reads "%s"' % (name, text, row, column, found))
+            for c in range(column, column + len(text)):
+                bit = 1 << (self.width - 1 - c)
+                if mask & bit:
+                    self.error(line, 'word %s: segments overlap at column %d' % (name, c))
+                mask |= bit
+        self.words[name] = (row, mask)
+        self.word_order.append(name)
+
+    def parse_rule(self, line, minute, flags, args, comment):
+        if minute >= 60:
+            self.error(line, 'minute %d out of range' % minute)
+        elif minute in self.rules:
+            self.error(line, 'minute %02d defined twice' % minute)
+        else:
+            self.rules[minute] = (list(flags), args, comment, line)
+
+    # -------------------------------------------------------------------------
+    # Validation
+    # -------------------------------------------------------------------------
+
+    def check_words(self, names, line, what, count=None):
+        if count is not None and len(names) != count:
+            self.error(line, '%s needs %d words, got %d' % (what, count, len(names)))
+        for name in names:
+            if name not in self.words:
+                self.error(line, '%s: unknown word %s' % (what, name))
+
+    def validate(self):
+        if self.errors:
+            return
+
+        slot_names = [s[0] for s in self.slots]
+        if len(self.slots) > LANGUAGE_MAX_WORDS:
+            self.error(self.slots[-1][3], '%d minute slots, only %d fit next to the rule flags' % (len(self.slots), LANGUAGE_MAX_WORDS))
+        for name, singular, plural, line in self.slots:
+            if slot_names.count(name) > 1:
+                self.error(line, 'slot %s defined twice' % name)
+            self.check_words([singular, plural], line, 'slot %s' % name)
+
+        for name, line in self.highlights:
+            if name not in slot_names:
+                self.error(line, 'highlight of unknown slot %s' % name)
+
+        for minute in range(60):
+            if minute not in self.rules:
+                self.error(1, 'minute %02d has no rule' % minute)
+                continue
+            flags, slots, _, line = self.rules[minute]
+            for slot in slots:
+                if slot not in slot_names:
+                    self.error(line, 'minute %02d: unknown slot %s' % (minute, slot))
+            if 'determiner' in flags and self.determiners is None:
+                self.error(line, 'minute %02d needs a determiner but there are no determiners' % minute)
+
+        if self.hours is None:
+            self.error(1, 'missing "hours"')
+        else:
+            self.check_words(self.hours[0], self.hours[1], 'hours', LANGUAGE_HOURS)
+        if self.determiners is not None:
+            self.check_words(self.determiners[0], self.determiners[1], 'determiners', LANGUAGE_HOURS)
+
+        previous = -1
+        for start, names, line in self.periods:
+            if start >= 24 or start <= previous:
+                self.error(line, 'period starts must grow from 0 to 23')
+            previous = start
+            if len(names) > LANGUAGE_PERIOD_WORDS:
+                self.error(line, 'a period takes at most %d words' % LANGUAGE_PERIOD_WORDS)
+            self.check_words(names, line, 'period %d' % start)
+        if self.periods and self.periods[0][0] != 0:
+            self.error(self.periods[0][2], 'the first period must start at 0')
+
+        if self.errors:
+            return
+
+        used = set()
+        for name, singular, plural, _ in self.slots:
+            used.update((singular, plural))
+        used.update(self.hours[0])
+        used.update(self.determiners[0] if self.determiners else [])
+        for _, names, _ in self.periods:
+            used.update(names)
+        for name in self.word_order:
+            if name not in used:
+                self.warnings.append('%s: word %s is never lit' % (self.path, name))
+
+        self.check_collisions()
+        words, hour, minute = self.longest
+        if words > SENTENCE_MAX_WORDS:
+            self.errors.append('%s: %d words lit at %02d:%02d, a sentence holds %d' % (self.path, words, hour, minute, SENTENCE_MAX_WORDS))
+
+    def resolve(self, hour, minute):
+        """Same walk as loadLanguage(), returns the names of the lit words"""
+        flags, slots, _, _ = self.rules[minute]
+        hour_12 = (hour + (1 if 'next' in flags else 0)) % 12
+        singular = 'singular' in flags or ('agree' in flags and hour_12 == 1)
+        lit = []
+        for name, one, many, _ in self.slots:
+            if name in slots:
+                lit.append(one if singular else many)
+        lit.append(self.hours[0][hour_12])
+        if 'determiner' in flags and self.determiners:
+            lit.append(self.determiners[0][hour_12])
+        period = None
+        for start, names, _ in self.periods:
+            if hour >= start:
+                period = names
+        lit.extend(period or [])
+        return lit
+
+    def check_collisions(self):
+        reported = set()
+        self.busiest = (0, 0, 0)
+        self.longest = (0, 0, 0)
+        self.lit_cells = set()
+        for hour in range(24):
+            for minute in range(60):
+                lit = self.resolve(hour, minute)
+                if len(lit) > self.longest[0]:
+                    self.longest = (len(lit), hour, minute)
+                leds = 0
+                for i, a in enumerate(lit):
+                    row_a, mask_a = self.words[a]
+                    for c in range(self.width):
+                        if mask_a & (1 << c):
+                            self.lit_cells.add((row_a, c))
+                    for b in lit[i + 1:]:
+                        row_b, mask_b = self.words[b]
+                        if row_a != row_b or a == b:
+                            continue
+                        common = mask_a & mask_b
+                        if common and common != mask_a and common != mask_b and (a, b) not in reported:
+                            reported.add((a, b))
+                            self.errors.append('%s: %s and %s share leds at %02d:%02d' % (self.path, a, b, hour, minute))
+                rows = {}
+                for name in lit:
+                    row, mask = self.words[name]
+                    rows[row] = rows.get(row, 0) | mask
+                leds = sum(bin(mask).count('1') for mask in rows.values())
+                if leds > self.busiest[0]:
+                    self.busiest = (leds, hour, minute)
+
+    # -------------------------------------------------------------------------
+    # Output
+    # -------------------------------------------------------------------------
+
+    def word(self, name):
+        return '%s_%s' % (self.prefix, name)
+
+    def row_bits(self):
+        return min(bits for bits in SIZEOF_ROW if bits >= self.width)
+
+    def sizeof_clockword(self):
+        return 1 + SIZEOF_ROW[self.row_bits()]
+
+    def mask(self, mask):
+        bits = self.row_bits()
+        suffix = 'ULL' if bits > 32 else 'UL' if bits > 16 else ''
+        return '0x%0*X%s' % (bits // 4, mask, suffix)
+
+    def header(self):
+        width = max(16, max(len(self.word(n)) for n in self.word_order) + 1)
+        lines = [LICENSE, '// Generated by tools/langc.py from languages/%s, do not edit' % os.path.basename(self.path), '']
+        lines.append('#if (MATRIX_WIDTH != %d) || (MATRIX_HEIGHT < %d)' % (self.width, self.height))
+        lines.append('#error "%s is drawn on a %dx%d stencil"' % (os.path.basename(self.path), self.width, self.height))
+        lines += ['#endif', '']
+        previous = None
+        for name in sorted(self.word_order, key=lambda n: self.words[n][0]):
+            row, mask = self.words[name]
+            if previous is not None and row != previous:
+                lines.append('')
+            previous = row
+            lines.append('#define %-*s{%d, %s}' % (width, self.word(name), row, self.mask(mask)))
+        lines += ['', 'extern const language_t language_%s PROGMEM;' % self.name, '']
+        return '\n'.join(lines)
+
+    def source(self):
+        p, n = self.prefix, self.name
+        slot = lambda s: '%s_M_%s' % (p, s)
+        width = max(len(slot(s[0])) for s in self.slots) + 1
+        lines = [LICENSE, '// Generated by tools/langc.py from languages/%s, do not edit' % os.path.basename(self.path), '']
+        lines += ['#include <Arduino.h>', '#include "language.h"', '#include "%s.h"' % n, '']
+
+        lines.append('// Words that depend on the minutes, in singular and plural form')
+        for bit, s in enumerate(self.slots):
+            lines.append('#define %-*s(1UL << %d)' % (width, slot(s[0]), bit))
+        lines.append('#define %-*s%d' % (width, p + '_WORDS', len(self.slots)))
+        lines.append('')
+
+        lines.append('const clockword %s_words[%s_WORDS][2] PROGMEM = {' % (n, p))
+        lines.append(',\n'.join('  { %s, %s }' % (self.word(s[1]), self.word(s[2])) for s in self.slots))
+        lines += ['};', '']
+
+        lines.append('const unsigned long %s_minutes[60] PROGMEM = {' % n)
+        for minute in range(60):
+            flags, slots, comment, _ = self.rules[minute]
+            terms = [RULE_FLAGS[f] for f in RULE_FLAGS if f in flags]
+            terms += [slot(s[0]) for s in self.slots if s[0] in slots]
+            line = '  /* %02d */ %s,' % (minute, ' | '.join(terms) or '0')
+            lines.append(line + (' // ' + comment if comment else ''))
+        lines += ['};', '']
+
+        def table(names):
+            words = [self.word(w) for w in names]
+            return ',\n'.join('  ' + ', '.join(words[i:i + 6]) for i in range(0, len(words), 6))
+
+        lines.append('// Hours in 12 hour format, position 0 is twelve')
+        lines.append('const clockword %s_hours[12] PROGMEM = {' % n)
+        lines += [table(self.hours[0]), '};', '']
+
+        if self.determiners:
+            lines.append('// Determiner of every hour')
+            lines.append('const clockword %s_determiners[12] PROGMEM = {' % n)
+            lines += [table(self.determiners[0]), '};', '']
+
+        count = len(self.periods)
+        if count:
+            lines.append('// Day periods, by starting hour')
+            lines.append('const byte %s_period_starts[%d] PROGMEM = { %s };' % (n, count, ', '.join(str(s[0]) for s in self.periods)))
+            lines.append('const clockword %s_periods[%d][LANGUAGE_PERIOD_WORDS] PROGMEM = {' % (n, count))
+            rows = []
+            for _, names, _ in self.periods:
+                words = [self.word(w) for w in names] + ['WORD_NONE'] * (LANGUAGE_PERIOD_WORDS - len(names))
+                rows.append('  { %s }' % ', '.join(words))
+            lines += [',\n'.join(rows), '};', '']
+
+        lines.append('const language_t language_%s PROGMEM = {' % n)
+        highlights = [slot(s[0]) for s in self.slots if s[0] in [h[0] for h in self.highlights]]
+        lines.append('  %s_words, %s_WORDS, %s,' % (n, p, ' | '.join(highlights) or '0'))
+        lines.append('  %s_minutes,' % n)
+        lines.append('  %s_hours,' % n)
+        lines.append('  %s,' % ('%s_determiners' % n if self.determiners else 'NULL'))
+        if count:
+            lines.append('  %s_period_starts, %s_periods, %d' % (n, n, count))
+        else:
+            lines.append('  NULL, NULL, 0')
+        lines += ['};', '']
+        return '\n'.join(lines)
+
+    def report(self):
+        clockword = self.sizeof_clockword()
+        words = len(self.slots) * 2 * clockword
+        minutes = 60 * SIZEOF_RULE
+        hours = LANGUAGE_HOURS * clockword
+        determiners = LANGUAGE_HOURS * clockword if self.determiners else 0
+        periods = len(self.periods) * (1 + LANGUAGE_PERIOD_WORDS * clockword)
+        total = words + minutes + hours + determiners + periods + SIZEOF_LANGUAGE
+        flags = set(f for rule in self.rules.values() for f in rule[0])
+        leds, hour, minute = self.busiest
+        sentence, longest_hour, longest_minute = self.longest
+        print('%s: %d words, %d/%d rule bits (%d slots, %d flags)' % (
+            self.name, len(self.words), len(self.slots) + len(flags), 32, len(self.slots), len(flags)))
+        print('  flash: %d bytes (words %d, minutes %d, hours %d, determiners %d, periods %d, descriptor %d)' % (
+            total, words, minutes, hours, determiners, periods, SIZEOF_LANGUAGE))
+        print('  stencil: %d/%d cells lit at some time, up to %d leds at %02d:%02d' % (
+            len(self.lit_cells), self.width * self.height, leds, hour, minute))
+        print('  sentence: up to %d/%d words at %02d:%02d' % (sentence, SENTENCE_MAX_WORDS, longest_hour, longest_minute))
+
+
+def main():
+    tools = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description='Compile wordclock languages into PROGMEM tables')
+    parser.add_argument('files', nargs='+', metavar='FILE.lang')
+    parser.add_argument('-o', '--output', default=os.path.join(tools, '..', 'src'), help='output folder (default: src)')
+    parser.add_argument('--check', action='store_true', help='validate and report, do not write')
+    args = parser.parse_args()
+
+    failed = False
+    for path in args.files:
+        language = Language(path)
+        language.parse()
+        language.validate()
+        for warning in language.warnings:
+            print('warning: ' + warning, file=sys.stderr)
+        if language.errors:
+            for error in language.errors:
+                print('error: ' + error, file=sys.stderr)
+            failed = True
+            continue
+        language.report()
+        if not args.check:
+            for ext, content in (('.h', language.header()), ('.cpp', language.source())):
+                with open(os.path.join(args.output, language.name + ext), 'w', encoding='utf-8') as f:
+                    f.write(content)
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+
+  Word Clock - serial client
+  Copyright (C) 2015 by Xose Pérez <xose dot perez at gmail dot com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+  Talks the binary command protocol of the clock (lib/protocol) over
+  its serial port. The log text shares the port, it is printed to
+  stderr as it comes.
+
+  Showing a frame keeps the clock interrupts off for some 8 ms (256
+  LEDs), 20 ms apart in the matrix and text modes. Bytes arriving then
+  overrun the UART and are lost, so a request not answered in time is
+  sent again, up to three times. Every command is safe to repeat.
+
+  Usage: wordclock.py [-p PORT] [-b BAUD] ping
+         wordclock.py [-p PORT] time [--set UNIX|now]
+         wordclock.py [-p PORT] settings [--set MODE LANGUAGE COLOR BRIGHTNESS]
+         wordclock.py [-p PORT] text [MESSAGE]
+         wordclock.py [-p PORT] stats
+         wordclock.py [-p PORT] log
+
+  Needs pyserial.
+
+"""
+
+import argparse
+import calendar
+import struct
+import sys
+import time
+
+# Must match protocol.h
+PROTOCOL_SYNC = 0xA5
+
+# Must match wordclock.ino
+SERIAL_BAUD = 115200
+COMMAND_PING = 0x01
+COMMAND_GET_TIME = 0x02
+COMMAND_SET_TIME = 0x03
+COMMAND_GET_SETTINGS = 0x04
+COMMAND_SET_SETTINGS = 0x05
+COMMAND_GET_STATS = 0x06
+COMMAND_CAPTURE = 0x07
+COMMAND_TEXT = 0x08
+TEXT_MAX = 16
+COMMAND_ERROR = 0x7F
+COMMAND_REPLY = 0x80
+ERRORS = {1: 'unknown command', 2: 'bad length', 3: 'out of range'}
+STATS = ('frames shown', 'frames skipped', 'pixels touched', 'rain steps dropped',
+         'button changes lost', 'log bytes dropped', 'protocol errors',
+         'asleep ms', 'awake ms', 'min free RAM')
+
+
+def crc8(data, crc=0):
+    """CRC-8, polynomial 0x07, as Protocol::crc"""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def frame(command, payload=b''):
+    """Builds a frame as Protocol::frame"""
+    body = bytes([command, len(payload)]) + bytes(payload)
+    return bytes([PROTOCOL_SYNC]) + body + bytes([crc8(body)])
+
+
+class ProtocolError(Exception):
+    pass
+
+
+class Client:
+    """
+    Splits what the clock sends into log text and frames. port is
+    anything with read(n) returning what is there (may be less) and
+    write(data), like a pyserial port with a timeout
+    """
+
+    def __init__(self, port, log=None, timeout=0.25, tries=3):
+        self.port = port
+        self.log = log
+        self.timeout = timeout
+        self.tries = tries
+        self.buffer = bytearray()
+        self.line = bytearray()
+
+    def _fill(self):
+        data = self.port.read(64)
+        if data:
+            self.buffer.extend(data)
+        return bool(data)
+
+    def _text(self, byte):
+        if byte == 0x0A:
+            if self.log:
+                self.log(self.line.decode('ascii', 'replace').rstrip('\r'))
+            self.line = bytearray()
+        else:
+            self.line.append(byte)
+
+    def poll(self):
+        """Takes what has arrived, returns a (command, payload) frame or None"""
+        self._fill()
+        while self.buffer:
+            if self.buffer[0] != PROTOCOL_SYNC:
+                self._text(self.buffer.pop(0))
+                continue
+            if len(self.buffer) < 3 or len(self.buffer) < self.buffer[2] + 4:
+                return None
+            size = self.buffer[2] + 4
+            data = bytes(self.buffer[:size])
+            del self.buffer[:size]
+            if crc8(data[1:-1]) != data[-1]:
+                raise ProtocolError('bad CRC in reply')
+            return data[1], data[3:-1]
+        return None
+
+    def request(self, command, payload=b''):
+        """
+        Sends a command and waits for its reply payload, sends it again
+        if the reply does not come in time, as the clock may have lost
+        bytes of it. The timeout is longer than PROTOCOL_TIMEOUT, so
+        what the clock got of it is dropped before the next try
+        """
+        for _ in range(self.tries):
+            self.port.write(frame(command, payload))
+            deadline = time.time() + self.timeout
+            while time.time() < deadline:
+                reply = self.poll()
+                if reply is None:
+                    continue
+                code, data = reply
+                if code == COMMAND_ERROR and data[0] == command:
+                    raise ProtocolError(ERRORS.get(data[1], 'error %d' % data[1]))
+                if code == command | COMMAND_REPLY:
+                    return data
+        raise ProtocolError('no reply to command 0x%02X after %d tries' % (command, self.tries))
+
+    def ping(self):
+        return self.request(COMMAND_PING)[0]
+
+    def get_time(self):
+        return struct.unpack('<I', self.request(COMMAND_GET_TIME))[0]
+
+    def set_time(self, unix):
+        self.request(COMMAND_SET_TIME, struct.pack('<I', unix))
+
+    def get_settings(self):
+        return tuple(self.request(COMMAND_GET_SETTINGS))
+
+    def set_settings(self, mode, language, color, brightness):
+        self.request(COMMAND_SET_SETTINGS, bytes([mode, language, color, brightness]))
+
+    def show_text(self, text):
+        self.request(COMMAND_TEXT, text.encode('ascii', 'replace')[:TEXT_MAX])
+
+    def get_stats(self):
+        data = self.request(COMMAND_GET_STATS)
+        return dict(zip(STATS, struct.unpack('<%dI' % (len(data) // 4), data)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Talk to a wordclock over its serial port')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0', help='serial port (default: /dev/ttyUSB0)')
+    parser.add_argument('-b', '--baud', type=int, default=SERIAL_BAUD, help='baud rate (default: %d)' % SERIAL_BAUD)
+    commands = parser.add_subparsers(dest='command')
+    commands.required = True
+    commands.add_parser('ping', help='protocol version')
+    time_parser = commands.add_parser('time', help='read or set the time')
+    time_parser.add_argument('--set', metavar='UNIX|now', help='unix time to set, "now" for this computer local time')
+    settings_parser = commands.add_parser('settings', help='read or set mode, language, color and brightness')
+    settings_parser.add_argument('--set', nargs=4, type=int, metavar=('MODE', 'LANGUAGE', 'COLOR', 'BRIGHTNESS'))
+    text_parser = commands.add_parser('text', help='scroll a message once, none stops the one scrolling')
+    text_parser.add_argument('message', nargs='?', default='', help='up to %d characters' % TEXT_MAX)
+    commands.add_parser('stats', help='counters')
+    commands.add_parser('log', help='print the log until interrupted')
+    args = parser.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        print('error: pyserial is needed, pip install pyserial', file=sys.stderr)
+        return 1
+
+    # opening the port resets the board, give the bootloader time
+    port = serial.Serial(args.port, args.baud, timeout=0.05)
+    time.sleep(2)
+    client = Client(port, log=lambda line: print(line, file=sys.stderr))
+
+    try:
+        if args.command == 'ping':
+            print('protocol version %d' % client.ping())
+        elif args.command == 'time':
+            if args.set is not None:
+                # the clock keeps local time
+                unix = calendar.timegm(time.localtime()) if args.set == 'now' else int(args.set)
+                client.set_time(unix)
+            print(time.strftime('%Y-%m-%d %H:%M:%S', time.gmtime(client.get_time())))
+        elif args.command == 'settings':
+            if args.set is not None:
+                client.set_settings(*args.set)
+            print('mode %d, language %d, color %d, brightness %d' % client.get_settings())
+        elif args.command == 'text':
+            client.show_text(args.message)
+        elif args.command == 'stats':
+            for name, value in client.get_stats().items():
+                print('%s: %d' % (name, value))
+        elif args.command == 'log':
+            while True:
+                client.poll()
+    except ProtocolError as e:
+        print('error: %s' % e, file=sys.stderr)
+        return 1
+    except KeyboardInterrupt:
+        pass
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())